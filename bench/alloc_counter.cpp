@@ -0,0 +1,59 @@
+#include "alloc_counter.hpp"
+
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+std::atomic<uint64_t> gAllocations{0};
+std::atomic<int64_t> gLiveBytes{0};
+std::atomic<int64_t> gBaseline{0};
+std::atomic<int64_t> gPeakBytes{0};
+
+void* countedAlloc(std::size_t size) {
+  void* p = std::malloc(size ? size : 1);
+  if (!p) throw std::bad_alloc();
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  int64_t live = gLiveBytes.fetch_add(malloc_usable_size(p),
+                                      std::memory_order_relaxed) +
+                 malloc_usable_size(p);
+  int64_t peak = gPeakBytes.load(std::memory_order_relaxed);
+  while (live > peak &&
+         !gPeakBytes.compare_exchange_weak(peak, live,
+                                           std::memory_order_relaxed)) {
+  }
+  return p;
+}
+
+void countedFree(void* p) {
+  if (!p) return;
+  gLiveBytes.fetch_sub(malloc_usable_size(p), std::memory_order_relaxed);
+  std::free(p);
+}
+}  // namespace
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+
+namespace bench {
+
+void resetAllocStats() {
+  int64_t live = gLiveBytes.load(std::memory_order_relaxed);
+  gAllocations.store(0, std::memory_order_relaxed);
+  gBaseline.store(live, std::memory_order_relaxed);
+  gPeakBytes.store(live, std::memory_order_relaxed);
+}
+
+AllocStats allocStats() {
+  return {gAllocations.load(std::memory_order_relaxed),
+          static_cast<uint64_t>(gPeakBytes.load(std::memory_order_relaxed) -
+                                gBaseline.load(std::memory_order_relaxed))};
+}
+
+}  // namespace bench
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+namespace bench {
+/**
+ * @brief 堆分配统计
+ * chat_bench 替换了全局 operator new/delete，用于统计分配次数和堆内存峰值。
+ */
+struct AllocStats {
+  uint64_t allocations;  // reset 以来的分配次数
+  uint64_t peakBytes;    // reset 以来在途内存超出基线的峰值
+};
+
+void resetAllocStats();
+AllocStats allocStats();
+}  // namespace bench
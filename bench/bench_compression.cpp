@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "alloc_counter.hpp"
+#include "utils/compress.hpp"
+
+namespace {
+
+// 模拟 since=0 的 /messages 响应：1000 条消息，约 100KB
+const std::string& messagesBody() {
+  static const std::string body = [] {
+    std::string out = "[";
+    for (int i = 0; i < 1000; ++i) {
+      out += "{\"content\":\"message number " + std::to_string(i) +
+             " from the lobby, 大家好\",\"timestamp\":" +
+             std::to_string(1700000000000 + i * 1375) +
+             ",\"username\":\"user" + std::to_string(i % 17) + "\"},";
+    }
+    out.back() = ']';
+    return out;
+  }();
+  return body;
+}
+
+// 带宽侧：压缩率；CPU 侧：bytes_per_second（按原始大小计）
+void report(benchmark::State& state, size_t compressedSize) {
+  const std::string& body = messagesBody();
+  state.SetBytesProcessed(state.iterations() * body.size());
+  state.counters["ratio"] = static_cast<double>(compressedSize) / body.size();
+  state.counters["allocs/req"] = benchmark::Counter(
+      static_cast<double>(bench::allocStats().allocations) /
+      state.iterations());
+}
+
+// 每次新建 z_stream（静态资源预压缩使用的接口）
+void BM_GzipPerCall(benchmark::State& state) {
+  const std::string& body = messagesBody();
+  size_t size = 0;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    auto out = utils::gzipCompress(body, static_cast<int>(state.range(0)));
+    size = out ? out->size() : 0;
+    benchmark::DoNotOptimize(out);
+  }
+  report(state, size);
+}
+BENCHMARK(BM_GzipPerCall)->Arg(1)->Arg(6)->Arg(9);
+
+// 复用线程内的 z_stream 和输出缓冲（动态响应压缩使用的接口）
+void BM_GzipReused(benchmark::State& state) {
+  const std::string& body = messagesBody();
+  std::string out;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::compressTo(utils::ContentEncoding::Gzip, body,
+                      static_cast<int>(state.range(0)), out);
+    benchmark::DoNotOptimize(out);
+  }
+  report(state, out.size());
+}
+BENCHMARK(BM_GzipReused)->Arg(1)->Arg(6)->Arg(9);
+
+void BM_Brotli(benchmark::State& state) {
+  const std::string& body = messagesBody();
+  std::string out;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::compressTo(utils::ContentEncoding::Brotli, body,
+                      static_cast<int>(state.range(0)), out);
+    benchmark::DoNotOptimize(out);
+  }
+  report(state, out.size());
+}
+BENCHMARK(BM_Brotli)->Arg(1)->Arg(4)->Arg(6)->Arg(11);
+
+}  // namespace
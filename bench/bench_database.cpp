@@ -0,0 +1,292 @@
+#include <benchmark/benchmark.h>
+#include <sqlite3.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "db/database_manager.hpp"
+
+namespace {
+
+constexpr const char* kDbPath = "bench_database.db";
+constexpr int kUsers = 1000;
+constexpr int kRooms = 100;
+constexpr int kMembersPerRoom = 20;
+// 历史消息房间 history_<n> 各有 n 条消息
+constexpr int kHistorySizes[] = {100, 1000, 10000};
+// 历史消息的时间戳从这里开始逐条加 1
+constexpr int64_t kHistoryStart = 1700000000000;
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void exec(sqlite3* db, const std::string& sql) {
+  sqlite3_exec(db, sql.c_str(), nullptr, nullptr, nullptr);
+}
+
+// 表结构由 DatabaseManager 创建，数据用另一个连接在一个事务里批量写入，
+// 否则逐条提交要等很久
+void populate() {
+  sqlite3* db = nullptr;
+  sqlite3_open(kDbPath, &db);
+  exec(db, "BEGIN;");
+  int64_t now = nowMs();
+  for (int u = 0; u < kUsers; ++u) {
+    exec(db, "INSERT INTO users VALUES ('user" + std::to_string(u) +
+                 "', 'password', " + std::to_string(u % 2) + ", " +
+                 std::to_string(now) + ");");
+  }
+  for (int r = 0; r < kRooms; ++r) {
+    std::string room = "room" + std::to_string(r);
+    exec(db, "INSERT INTO rooms VALUES ('" + room + "', 'user" +
+                 std::to_string(r) + "');");
+    for (int m = 0; m < kMembersPerRoom; ++m) {
+      exec(db, "INSERT INTO room_users VALUES ('" + room + "', 'user" +
+                   std::to_string((r * 7 + m * 13) % kUsers) + "');");
+    }
+  }
+  for (int size : kHistorySizes) {
+    std::string room = "history_" + std::to_string(size);
+    exec(db, "INSERT INTO rooms VALUES ('" + room + "', 'user0');");
+    for (int i = 0; i < size; ++i) {
+      exec(db,
+           "INSERT INTO messages (room_name, username, message, timestamp) "
+           "VALUES ('" + room + "', 'user" + std::to_string(i % kUsers) +
+               "', 'message " + std::to_string(i) +
+               " with some typical chat content', " +
+               std::to_string(kHistoryStart + i) + ");");
+    }
+  }
+  exec(db, "COMMIT;");
+  sqlite3_close(db);
+}
+
+// 所有基准共享的数据库，首次使用时建好，进程退出时删除
+struct BenchDb {
+  std::unique_ptr<DatabaseManager> manager;
+  BenchDb() {
+    std::remove(kDbPath);
+    manager = std::make_unique<DatabaseManager>(kDbPath);
+    populate();
+  }
+  ~BenchDb() {
+    manager.reset();
+    std::remove(kDbPath);
+  }
+};
+
+DatabaseManager& db() {
+  static BenchDb instance;
+  return *instance.manager;
+}
+
+std::string user(size_t i) { return "user" + std::to_string(i % kUsers); }
+std::string room(size_t i) { return "room" + std::to_string(i % kRooms); }
+
+// ---- 用户 ----
+
+// 写操作每次都是一个独立的 sqlite 事务，包含落盘
+void BM_DbCreateUser(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  static size_t next = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        manager.createUser("new_user" + std::to_string(next++), "password"));
+  }
+}
+BENCHMARK(BM_DbCreateUser);
+
+void BM_DbValidateUser(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.validateUser(user(i++), "password"));
+  }
+}
+BENCHMARK(BM_DbValidateUser);
+
+void BM_DbSetUserOnlineStatus(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.setUserOnlineStatus(user(i), i % 2));
+    ++i;
+  }
+}
+BENCHMARK(BM_DbSetUserOnlineStatus);
+
+void BM_DbSetUserLastActiveTime(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.setUserLastActiveTime(user(i++)));
+  }
+}
+BENCHMARK(BM_DbSetUserLastActiveTime);
+
+void BM_DbIsUserOnline(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.isUserOnline(user(i++)));
+  }
+}
+BENCHMARK(BM_DbIsUserOnline);
+
+void BM_DbIsUserExists(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.isUserExists(user(i++)));
+  }
+}
+BENCHMARK(BM_DbIsUserExists);
+
+void BM_DbGetOnlineUsers(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getOnlineUsers());
+  }
+}
+BENCHMARK(BM_DbGetOnlineUsers);
+
+void BM_DbGetAllUsers(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getAllUsers());
+  }
+}
+BENCHMARK(BM_DbGetAllUsers);
+
+void BM_DbGetUserList(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getUserList());
+  }
+}
+BENCHMARK(BM_DbGetUserList);
+
+// ---- 房间 ----
+
+// 创建后立即删除，保持房间数不变
+void BM_DbCreateDeleteRoom(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.createRoom("bench_room", "user0"));
+    benchmark::DoNotOptimize(manager.deleteRoom("bench_room"));
+  }
+}
+BENCHMARK(BM_DbCreateDeleteRoom);
+
+void BM_DbAddRemoveUserInRoom(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    std::string name = user(i++);
+    benchmark::DoNotOptimize(manager.addUserToRoom("history_100", name));
+    benchmark::DoNotOptimize(manager.removeUserFromRoom("history_100", name));
+  }
+}
+BENCHMARK(BM_DbAddRemoveUserInRoom);
+
+void BM_DbIsUserInRoom(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.isUserInRoom(room(i), user(i * 13)));
+    ++i;
+  }
+}
+BENCHMARK(BM_DbIsUserInRoom);
+
+void BM_DbIsRoomExists(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.isRoomExists(room(i++)));
+  }
+}
+BENCHMARK(BM_DbIsRoomExists);
+
+void BM_DbGetRoomUsers(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getRoomUsers(room(i++)));
+  }
+}
+BENCHMARK(BM_DbGetRoomUsers);
+
+void BM_DbGetUserRooms(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getUserRooms(user(i++)));
+  }
+}
+BENCHMARK(BM_DbGetUserRooms);
+
+void BM_DbGetRooms(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getRooms());
+  }
+}
+BENCHMARK(BM_DbGetRooms);
+
+void BM_DbGetRoomList(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getRoomList());
+  }
+}
+BENCHMARK(BM_DbGetRoomList);
+
+// ---- 消息 ----
+
+// 参数为房间的历史消息条数，一次取回全部
+void BM_DbGetRoomMessages(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  std::string name = "history_" + std::to_string(state.range(0));
+  size_t bytes = 0;
+  for (auto _ : state) {
+    std::string json = manager.getRoomMessages(name);
+    bytes += json.size();
+    benchmark::DoNotOptimize(json);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *
+                          state.range(0));
+}
+BENCHMARK(BM_DbGetRoomMessages)->Arg(100)->Arg(1000)->Arg(10000);
+
+// 增量拉取：只取最后 10 条
+void BM_DbGetRoomMessagesSince(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  int64_t since = kHistoryStart + 10000 - 11;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.getRoomMessages("history_10000", since));
+  }
+}
+BENCHMARK(BM_DbGetRoomMessagesSince);
+
+// 写入单独的房间。放在读取之后，新增的行不影响上面的全表扫描
+void BM_DbSaveMessage(benchmark::State& state) {
+  DatabaseManager& manager = db();
+  if (!manager.isRoomExists("bench_scratch")) {
+    manager.createRoom("bench_scratch", "user0");
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(manager.saveMessage(
+        "bench_scratch", user(i++), "hello from the benchmark", nowMs()));
+  }
+}
+BENCHMARK(BM_DbSaveMessage);
+
+}  // namespace
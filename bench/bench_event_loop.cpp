@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "reactor/channel.hpp"
+#include "reactor/event_loop.hpp"
+#include "utils/logger.hpp"
+
+namespace {
+
+// 每个连接用一个 eventfd 代替 socket：只占一个 fd，可读状态由写入控制
+class IdleConnections {
+ public:
+  IdleConnections(reactor::EventLoop& loop, int count) : loop_(loop) {
+    for (int i = 0; i < count; ++i) {
+      int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (fd < 0) break;
+      auto channel = std::make_shared<reactor::Channel>(fd);
+      channel->setEvents(EPOLLIN);
+      channel->setReadCallback([this] { ++handled_; });
+      loop_.addChannel(channel);
+      fds_.push_back(fd);
+    }
+  }
+  ~IdleConnections() {
+    for (int fd : fds_) {
+      loop_.removeChannel(fd);
+      close(fd);
+    }
+  }
+
+  bool complete(int count) const {
+    return static_cast<int>(fds_.size()) == count;
+  }
+  // 均匀挑 n 个连接置为可读。回调不读取，水平触发下每轮都会就绪
+  void activate(int n) {
+    uint64_t one = 1;
+    size_t step = fds_.size() / n;
+    for (int i = 0; i < n; ++i) {
+      ssize_t written = write(fds_[i * step], &one, sizeof(one));
+      (void)written;
+    }
+  }
+  uint64_t handled() const { return handled_; }
+
+ private:
+  reactor::EventLoop& loop_;
+  std::vector<int> fds_;
+  uint64_t handled_{0};
+};
+
+// 连接数超过默认的 fd 软限制时尽量提高到硬限制
+bool reserveFds(benchmark::State& state, int count) {
+  rlimit limit{};
+  getrlimit(RLIMIT_NOFILE, &limit);
+  rlim_t needed = static_cast<rlim_t>(count) + 64;
+  if (limit.rlim_cur < needed && limit.rlim_cur < limit.rlim_max) {
+    limit.rlim_cur = std::min(needed, limit.rlim_max);
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  if (limit.rlim_cur >= needed) return true;
+  state.SkipWithError(("RLIMIT_NOFILE " + std::to_string(limit.rlim_cur) +
+                       " is too low, raise ulimit -n")
+                          .c_str());
+  return false;
+}
+
+// 一轮事件循环的开销：range(0) 个空闲连接中有 range(1) 个就绪，
+// 计时包括 epoll_wait、按事件找到 Channel 并执行回调
+void BM_EventLoopDispatch(benchmark::State& state) {
+  int connections = static_cast<int>(state.range(0));
+  int active = static_cast<int>(state.range(1));
+  if (!reserveFds(state, connections)) return;
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  reactor::EventLoop loop;
+  IdleConnections conns(loop, connections);
+  if (!conns.complete(connections)) {
+    state.SkipWithError("eventfd failed");
+    return;
+  }
+  conns.activate(active);
+  loop.runOnce(0);
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(loop.runOnce(0));
+  }
+  bench::AllocStats stats = bench::allocStats();
+  state.SetItemsProcessed(static_cast<int64_t>(conns.handled()));
+  state.counters["allocs/iter"] = benchmark::Counter(
+      static_cast<double>(stats.allocations) / state.iterations());
+}
+BENCHMARK(BM_EventLoopDispatch)
+    ->ArgsProduct({{1000, 10000, 50000}, {64, 512}});
+
+// 已有 range(0) 个连接时注册再注销一个 Channel，即建连和断连的开销
+void BM_EventLoopChannelChurn(benchmark::State& state) {
+  int connections = static_cast<int>(state.range(0));
+  if (!reserveFds(state, connections + 1)) return;
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  reactor::EventLoop loop;
+  IdleConnections conns(loop, connections);
+  int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!conns.complete(connections) || fd < 0) {
+    state.SkipWithError("eventfd failed");
+    return;
+  }
+  for (auto _ : state) {
+    auto channel = std::make_shared<reactor::Channel>(fd);
+    channel->setEvents(EPOLLIN);
+    loop.addChannel(channel);
+    loop.removeChannel(fd);
+  }
+  close(fd);
+}
+BENCHMARK(BM_EventLoopChannelChurn)->Arg(1000)->Arg(10000)->Arg(50000);
+
+}  // namespace
@@ -0,0 +1,109 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "utils/json_writer.hpp"
+#include "utils/shared_buffer.hpp"
+
+namespace {
+
+// 同一房间的一次轮询应答（三条消息）发给很多连接。
+// 连接的输出用 /dev/null 代替 socket：保留每个连接一次 writev，
+// 不经过协议栈，差别只在应答的序列化、复制和分配
+constexpr const char* kHead =
+    "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n"
+    "Content-Type: application/json\r\nConnection: close\r\n\r\n";
+const size_t kHeadSize = std::string_view(kHead).size();
+
+struct Message {
+  const char* content;
+  int64_t timestamp;
+  const char* username;
+};
+const Message kMessages[] = {
+    {"大家好, hello world! 今晚八点开会，记得带上周的数据。", 1792330270821,
+     "alice"},
+    {"收到，我把图表也准备好 :)", 1792330270829, "bob"},
+    {"\"quoted\" reply with\nnewline", 1792330270855, "carol"},
+};
+
+std::string serializeAnswer() {
+  std::string json;
+  utils::JsonWriter writer(json);
+  writer.beginArray();
+  for (const Message& m : kMessages) {
+    writer.beginObject()
+        .key("content")
+        .value(m.content)
+        .key("timestamp")
+        .value(m.timestamp)
+        .key("username")
+        .value(m.username)
+        .endObject();
+  }
+  writer.endArray();
+  return json;
+}
+
+// 每个连接的待发送报文：复制方式各有一份应答，共享方式只有引用
+struct Output {
+  std::string copy;
+  utils::SharedBuffer shared;
+};
+
+void writeOut(int fd, const Output& out) {
+  std::string_view body =
+      out.shared ? out.shared.view() : std::string_view(out.copy);
+  iovec iov[2] = {{const_cast<char*>(kHead), kHeadSize},
+                  {const_cast<char*>(body.data()), body.size()}};
+  ssize_t n = writev(fd, iov, 2);
+  benchmark::DoNotOptimize(n);
+}
+
+void reportFanout(benchmark::State& state) {
+  bench::AllocStats stats = bench::allocStats();
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.counters["allocs/msg"] = benchmark::Counter(
+      static_cast<double>(stats.allocations) / state.iterations());
+}
+
+// 改造前：每个接收者各自序列化一份应答
+void BM_FanoutCopyPerRecipient(benchmark::State& state) {
+  int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  std::vector<Output> outputs(state.range(0));
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    for (Output& out : outputs) out.copy = serializeAnswer();
+    for (Output& out : outputs) writeOut(devNull, out);
+    for (Output& out : outputs) std::string().swap(out.copy);
+  }
+  reportFanout(state);
+  close(devNull);
+}
+BENCHMARK(BM_FanoutCopyPerRecipient)->Arg(10000);
+
+// 改造后：序列化一次，各连接通过 iovec 引用同一个 SharedBuffer
+void BM_FanoutSharedBuffer(benchmark::State& state) {
+  int devNull = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  std::vector<Output> outputs(state.range(0));
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::SharedBuffer answer =
+        utils::SharedBuffer::copyOf(serializeAnswer());
+    for (Output& out : outputs) out.shared = answer;
+    for (Output& out : outputs) writeOut(devNull, out);
+    for (Output& out : outputs) out.shared = utils::SharedBuffer();
+  }
+  reportFanout(state);
+  close(devNull);
+}
+BENCHMARK(BM_FanoutSharedBuffer)->Arg(10000);
+
+}  // namespace
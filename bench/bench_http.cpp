@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "http/http_request.hpp"
+#include "http/http_response.hpp"
+#include "utils/arena.hpp"
+
+namespace {
+
+// 浏览器发出的 GET：请求头较多，带查询参数
+const std::string kRawGetMessages =
+    "GET /messages?room=general&since=1700000000000 HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 "
+    "(KHTML, like Gecko) Chrome/120.0.0.0 Safari/537.36\r\n"
+    "Accept: application/json, text/plain, */*\r\n"
+    "Accept-Encoding: gzip, deflate, br\r\n"
+    "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+    "Referer: http://127.0.0.1:8080/\r\n"
+    "Cookie: session=0123456789abcdef0123456789abcdef\r\n"
+    "\r\n";
+
+std::string rawSendMessage(size_t contentBytes) {
+  std::string body = R"({"room":"general","username":"alice","content":")" +
+                     std::string(contentBytes, 'x') + "\"}";
+  return "POST /send_message HTTP/1.1\r\n"
+         "Host: 127.0.0.1:8080\r\n"
+         "Content-Type: application/json\r\n"
+         "Content-Length: " +
+         std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+void BM_HttpRequestParseGet(benchmark::State& state) {
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    auto request = http::HttpRequest::parse(kRawGetMessages);
+    benchmark::DoNotOptimize(request.queryParam("room"));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          kRawGetMessages.size());
+}
+BENCHMARK(BM_HttpRequestParseGet);
+
+// 参数为消息内容的字节数
+void BM_HttpRequestParsePost(benchmark::State& state) {
+  const std::string raw = rawSendMessage(state.range(0));
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    auto request = http::HttpRequest::parse(raw);
+    benchmark::DoNotOptimize(request.body());
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *
+                          raw.size());
+}
+BENCHMARK(BM_HttpRequestParsePost)->Arg(16)->Arg(1024)->Arg(64 * 1024);
+
+// 大多数接口返回的小 JSON 响应，完整报文
+void BM_ResponseToStringSmall(benchmark::State& state) {
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    http::HttpResponse response(200, "{\"status\":\"success\"}");
+    response.setHeader("Content-Type", "application/json");
+    response.setHeader("Access-Control-Allow-Origin", "*");
+    utils::ArenaString out = response.toString();
+    benchmark::DoNotOptimize(out);
+  }
+}
+BENCHMARK(BM_ResponseToStringSmall);
+
+}  // namespace
@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "chat/requests.hpp"
+#include "utils/json_reader.hpp"
+
+namespace {
+
+// 与 static/chat.html 实际发送的请求体一致
+const std::string kLoginBody =
+    R"({"username":"alice","password":"correct-horse-battery"})";
+const std::string kMessagesBody =
+    R"({"room":"general","since":1718000000000,"username":"alice"})";
+
+std::string sendMessageBody(size_t contentSize) {
+  std::string content;
+  while (content.size() < contentSize) content += "大家好, hello world! ";
+  return R"({"room":"general","username":"alice","content":")" + content +
+         R"("})";
+}
+
+// 改造前：构建完整 DOM 后再取字段
+void BM_ParseNlohmann(benchmark::State& state, const std::string& body) {
+  for (auto _ : state) {
+    auto data = nlohmann::json::parse(body);
+    std::string room = data.contains("room") ? data["room"] : "";
+    std::string username = data["username"];
+    benchmark::DoNotOptimize(room);
+    benchmark::DoNotOptimize(username);
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+void BM_ParseJsonReader(benchmark::State& state, const std::string& body) {
+  for (auto _ : state) {
+    utils::JsonReader data(body);
+    auto room = data.getString("room");
+    auto username = data.getString("username");
+    benchmark::DoNotOptimize(room);
+    benchmark::DoNotOptimize(username);
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+// 按编译期字段表一次扫描绑定到请求结构体
+template <typename Request>
+void bindLoop(benchmark::State& state, const std::string& body) {
+  for (auto _ : state) {
+    utils::BoundRequest<Request> request(body);
+    benchmark::DoNotOptimize(request.ok());
+    benchmark::DoNotOptimize(request->username);
+  }
+  state.SetBytesProcessed(state.iterations() * body.size());
+}
+
+void BM_BindLogin(benchmark::State& state, const std::string& body) {
+  bindLoop<LoginRequest>(state, body);
+}
+void BM_BindGetMessages(benchmark::State& state, const std::string& body) {
+  bindLoop<GetMessagesRequest>(state, body);
+}
+void BM_BindSendMessage(benchmark::State& state, const std::string& body) {
+  bindLoop<SendMessageRequest>(state, body);
+}
+
+BENCHMARK_CAPTURE(BM_ParseNlohmann, login, kLoginBody);
+BENCHMARK_CAPTURE(BM_ParseJsonReader, login, kLoginBody);
+BENCHMARK_CAPTURE(BM_BindLogin, login, kLoginBody);
+BENCHMARK_CAPTURE(BM_ParseNlohmann, messages, kMessagesBody);
+BENCHMARK_CAPTURE(BM_ParseJsonReader, messages, kMessagesBody);
+BENCHMARK_CAPTURE(BM_BindGetMessages, messages, kMessagesBody);
+BENCHMARK_CAPTURE(BM_ParseNlohmann, send_64B, sendMessageBody(64));
+BENCHMARK_CAPTURE(BM_ParseJsonReader, send_64B, sendMessageBody(64));
+BENCHMARK_CAPTURE(BM_BindSendMessage, send_64B, sendMessageBody(64));
+BENCHMARK_CAPTURE(BM_ParseNlohmann, send_4KB, sendMessageBody(4096));
+BENCHMARK_CAPTURE(BM_ParseJsonReader, send_4KB, sendMessageBody(4096));
+BENCHMARK_CAPTURE(BM_BindSendMessage, send_4KB, sendMessageBody(4096));
+
+}  // namespace
@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <sqlite3.h>
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "db/database_manager.hpp"
+
+namespace {
+
+constexpr const char* kDbPath = "bench_messages.db";
+constexpr const char* kRoom = "bench_room";
+
+// 带 n 条消息的临时数据库，内容里混入需要转义的字符和中文
+class MessageDb {
+ public:
+  explicit MessageDb(int n) {
+    std::remove(kDbPath);
+    manager_ = std::make_unique<DatabaseManager>(kDbPath);
+    sqlite3_open(kDbPath, &raw_);
+    sqlite3_exec(raw_, "BEGIN;", nullptr, nullptr, nullptr);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(raw_,
+                       "INSERT INTO messages (room_name, username, message, "
+                       "timestamp) VALUES (?, ?, ?, ?);",
+                       -1, &stmt, nullptr);
+    for (int i = 0; i < n; ++i) {
+      std::string user = "user" + std::to_string(i % 50);
+      std::string content = "message #" + std::to_string(i) +
+                            " \"quoted\" 你好，世界\nsecond line\tend";
+      sqlite3_bind_text(stmt, 1, kRoom, -1, SQLITE_STATIC);
+      sqlite3_bind_text(stmt, 2, user.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_text(stmt, 3, content.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int64(stmt, 4, 1700000000000LL + i);
+      sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_exec(raw_, "COMMIT;", nullptr, nullptr, nullptr);
+  }
+
+  ~MessageDb() {
+    sqlite3_close(raw_);
+    manager_.reset();
+    std::remove(kDbPath);
+  }
+
+  DatabaseManager& manager() { return *manager_; }
+  sqlite3* raw() { return raw_; }
+
+ private:
+  std::unique_ptr<DatabaseManager> manager_;
+  sqlite3* raw_{nullptr};
+};
+
+// 改造前的 DOM 路径：逐行构造 nlohmann::json，拷贝成数组再 dump
+std::string domRoomMessages(sqlite3* db) {
+  std::vector<nlohmann::json> messages;
+  sqlite3_stmt* stmt = nullptr;
+  sqlite3_prepare_v2(db,
+                     "SELECT username, message, timestamp FROM messages "
+                     "WHERE room_name='bench_room' ORDER BY timestamp ASC;",
+                     -1, &stmt, nullptr);
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    nlohmann::json msg;
+    msg["username"] =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    msg["content"] =
+        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+    msg["timestamp"] = sqlite3_column_int64(stmt, 2);
+    messages.push_back(msg);
+  }
+  sqlite3_finalize(stmt);
+  nlohmann::json resp_json = messages;
+  return resp_json.dump();
+}
+
+void reportMemory(benchmark::State& state, size_t bytes) {
+  bench::AllocStats stats = bench::allocStats();
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  state.counters["allocs/iter"] = benchmark::Counter(
+      static_cast<double>(stats.allocations) / state.iterations());
+  state.counters["peak_heap"] = benchmark::Counter(
+      static_cast<double>(stats.peakBytes), benchmark::Counter::kDefaults,
+      benchmark::Counter::kIs1024);
+  // ru_maxrss 是进程级的单调值，对比时请用 --benchmark_filter 单独运行
+  state.counters["max_rss_kb"] =
+      benchmark::Counter(static_cast<double>(usage.ru_maxrss));
+}
+
+void BM_RoomMessagesDom(benchmark::State& state) {
+  MessageDb db(static_cast<int>(state.range(0)));
+  size_t bytes = 0;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    std::string body = domRoomMessages(db.raw());
+    bytes += body.size();
+    benchmark::DoNotOptimize(body);
+  }
+  reportMemory(state, bytes);
+}
+BENCHMARK(BM_RoomMessagesDom)->RangeMultiplier(10)->Range(100, 100000);
+
+void BM_RoomMessagesStream(benchmark::State& state) {
+  MessageDb db(static_cast<int>(state.range(0)));
+  size_t bytes = 0;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    std::string body = db.manager().getRoomMessages(kRoom);
+    bytes += body.size();
+    benchmark::DoNotOptimize(body);
+  }
+  reportMemory(state, bytes);
+}
+BENCHMARK(BM_RoomMessagesStream)->RangeMultiplier(10)->Range(100, 100000);
+
+}  // namespace
@@ -0,0 +1,82 @@
+#include <benchmark/benchmark.h>
+
+#include <iostream>
+#include <streambuf>
+
+#include "utils/logger.hpp"
+
+namespace {
+
+// 日志写入 bench_logs/。LOG 同时写 std::cout，测量期间把它丢弃，
+// 只计格式化和写文件（终端输出的开销取决于终端本身）
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+class DiscardStdout {
+ public:
+  DiscardStdout() : saved_(std::cout.rdbuf(&buffer_)) {}
+  ~DiscardStdout() { std::cout.rdbuf(saved_); }
+
+ private:
+  NullBuffer buffer_;
+  std::streambuf* saved_;
+};
+
+// Logger 是单例，写线程只在 initialize 时启动，不能从异步切回同步，
+// 所以同步版本必须先运行（按注册顺序）
+enum class Mode { None, Sync, Async };
+Mode gMode = Mode::None;
+
+bool useMode(Mode mode) {
+  if (gMode == mode) return true;
+  if (gMode == Mode::Async) return false;
+  utils::LogConfig config;
+  config.logFilePath = "bench_logs";
+  config.maxFileSize = 256 * 1024 * 1024;
+  config.maxBackupFiles = 2;
+  config.asyncLogging = mode == Mode::Async;
+  utils::Logger::initialize(config);
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::INFO);
+  gMode = mode;
+  return true;
+}
+
+// 同步：调用线程格式化并写文件，每条 flush
+void BM_LogSync(benchmark::State& state) {
+  if (!useMode(Mode::Sync)) {
+    state.SkipWithError("logger already switched to async");
+    return;
+  }
+  DiscardStdout discard;
+  int i = 0;
+  for (auto _ : state) {
+    LOG(INFO) << "User alice joined room general, request " << i++;
+  }
+}
+BENCHMARK(BM_LogSync);
+
+// 异步：调用线程只格式化并入队，写线程批量写文件
+void BM_LogAsync(benchmark::State& state) {
+  useMode(Mode::Async);
+  DiscardStdout discard;
+  int i = 0;
+  for (auto _ : state) {
+    LOG(INFO) << "User alice joined room general, request " << i++;
+  }
+}
+BENCHMARK(BM_LogAsync);
+
+// 低于全局级别的日志：只有一次级别比较
+void BM_LogFiltered(benchmark::State& state) {
+  useMode(Mode::Async);
+  int i = 0;
+  for (auto _ : state) {
+    LOG(DEBUG) << "User alice joined room general, request " << i++;
+  }
+}
+BENCHMARK(BM_LogFiltered);
+
+}  // namespace
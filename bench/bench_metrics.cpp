@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "utils/metrics.hpp"
+
+namespace {
+
+// 记录只写本线程的槽，多线程下不应有伸缩性问题
+void BM_CounterInc(benchmark::State& state) {
+  static utils::Counter counter =
+      utils::metrics().counter("bench_counter_total", "Benchmark counter");
+  for (auto _ : state) {
+    counter.inc();
+  }
+}
+BENCHMARK(BM_CounterInc)->Threads(1)->Threads(4)->Threads(8);
+
+void BM_HistogramRecord(benchmark::State& state) {
+  static utils::Histogram histogram = utils::metrics().histogram(
+      "bench_latency_seconds", "Benchmark histogram");
+  uint64_t nanos = 1000;
+  for (auto _ : state) {
+    histogram.record(nanos);
+    nanos = nanos * 33 % 1000003;
+  }
+}
+BENCHMARK(BM_HistogramRecord)->Threads(1)->Threads(4)->Threads(8);
+
+// 包括两次 steady_clock::now()，即处理函数和数据库调用实际多出的开销
+void BM_ScopedTimer(benchmark::State& state) {
+  static utils::Histogram histogram = utils::metrics().histogram(
+      "bench_scoped_seconds", "Benchmark scoped timer");
+  for (auto _ : state) {
+    utils::ScopedTimer timer(histogram);
+  }
+}
+BENCHMARK(BM_ScopedTimer);
+
+// 抓取：约 40 个直方图时渲染一次的开销
+void BM_Render(benchmark::State& state) {
+  for (int i = 0; i < 40; ++i) {
+    utils::metrics()
+        .histogram("bench_render_seconds", "Benchmark render",
+                   {{"route", "/route" + std::to_string(i)}})
+        .record(uint64_t{1000} * i);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(utils::metrics().render());
+  }
+}
+BENCHMARK(BM_Render);
+
+}  // namespace
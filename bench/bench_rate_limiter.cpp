@@ -0,0 +1,51 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "http/rate_limiter.hpp"
+
+namespace {
+
+// 正常负载：限制足够宽松，每次都放行，测的是每个请求多出的开销
+http::RateLimitOptions looseOptions() {
+  http::RateLimitOptions options;
+  options.enabled = true;
+  options.perIp = {1e9, 1e9};
+  options.perUser = {1e9, 1e9};
+  for (auto& route : options.routes) {
+    route.perIp = {1e9, 1e9};
+    route.perUser = {1e9, 1e9};
+  }
+  return options;
+}
+
+http::RateLimiter* gLimiter = nullptr;
+
+// state.range(0) 个客户端 IP 轮流请求，多线程共享一个限流器
+void BM_RateLimitIp(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    gLimiter = new http::RateLimiter(looseOptions());
+  }
+  uint32_t clients = static_cast<uint32_t>(state.range(0));
+  uint32_t i = state.thread_index() * 7919;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        gLimiter->acquireForIp(i++ % clients, "POST", "/send_message"));
+  }
+  if (state.thread_index() == 0) {
+    state.counters["buckets"] = gLimiter->bucketCount();
+    delete gLimiter;
+  }
+}
+BENCHMARK(BM_RateLimitIp)->Arg(1)->Arg(10000)->Threads(1)->Threads(4);
+
+void BM_RateLimitUser(benchmark::State& state) {
+  http::RateLimiter limiter(looseOptions());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        limiter.acquireForUser("alice", "POST", "/messages"));
+  }
+}
+BENCHMARK(BM_RateLimitUser);
+
+}  // namespace
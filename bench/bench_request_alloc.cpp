@@ -0,0 +1,177 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "alloc_counter.hpp"
+#include "chat/chat_json.hpp"
+#include "chat/requests.hpp"
+#include "http/http_request.hpp"
+#include "http/http_response.hpp"
+#include "utils/arena.hpp"
+#include "utils/json_writer.hpp"
+
+namespace {
+
+const std::string kLoginBody =
+    R"({"username":"alice","password":"correct-horse-battery"})";
+const std::string kSendBody =
+    R"({"room":"general","username":"alice","content":"大家好, hello world!"})";
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+void reportAllocs(benchmark::State& state) {
+  bench::AllocStats stats = bench::allocStats();
+  state.counters["allocs/req"] = benchmark::Counter(
+      static_cast<double>(stats.allocations) / state.iterations());
+}
+
+// 改造前的 /login：nlohmann::json 事件，发送与日志各 dump 一次，响应再 dump
+void BM_LoginHandlerDom(benchmark::State& state) {
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::BoundRequest<LoginRequest> req(kLoginBody);
+    nlohmann::json event = {{"username", req->username},
+                            {"action", "login"},
+                            {"timestamp", nowMs()},
+                            {"type", "user_event"}};
+    std::string sent = event.dump();
+    std::string logged = event.dump();
+    nlohmann::json resp = {{"status", "success"},
+                           {"username", req->username}};
+    std::string body = resp.dump();
+    benchmark::DoNotOptimize(sent);
+    benchmark::DoNotOptimize(logged);
+    benchmark::DoNotOptimize(body);
+  }
+  reportAllocs(state);
+}
+
+// 改造后：chat_json 事件分配在请求 arena 中，只 dump 一次，响应用 JsonWriter
+void BM_LoginHandlerArena(benchmark::State& state) {
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    utils::BoundRequest<LoginRequest> req(kLoginBody);
+    chat_json event = {{"username", req->username},
+                       {"action", "login"},
+                       {"timestamp", nowMs()},
+                       {"type", "user_event"}};
+    utils::ArenaString sent = event.dump();
+    std::string body;
+    utils::JsonWriter(body)
+        .beginObject()
+        .key("status")
+        .value("success")
+        .key("username")
+        .value(req->username)
+        .endObject();
+    benchmark::DoNotOptimize(sent);
+    benchmark::DoNotOptimize(body);
+  }
+  reportAllocs(state);
+}
+
+void BM_SendMessageEventDom(benchmark::State& state) {
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::BoundRequest<SendMessageRequest> req(kSendBody);
+    nlohmann::json event = {{"room", req->room},
+                            {"username", req->username},
+                            {"content", req->content},
+                            {"timestamp", nowMs()},
+                            {"type", "chat_message"}};
+    std::string sent = event.dump();
+    std::string logged = event.dump();
+    benchmark::DoNotOptimize(sent);
+    benchmark::DoNotOptimize(logged);
+  }
+  reportAllocs(state);
+}
+
+void BM_SendMessageEventArena(benchmark::State& state) {
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    utils::BoundRequest<SendMessageRequest> req(kSendBody);
+    chat_json event = {{"room", req->room},
+                       {"username", req->username},
+                       {"content", req->content},
+                       {"timestamp", nowMs()},
+                       {"type", "chat_message"}};
+    utils::ArenaString sent = event.dump();
+    benchmark::DoNotOptimize(sent);
+  }
+  reportAllocs(state);
+}
+
+const std::string kRawJoinRoom =
+    "POST /join_room HTTP/1.1\r\n"
+    "Host: 127.0.0.1:8080\r\n"
+    "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+    "Accept: */*\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 37\r\n"
+    "\r\n"
+    R"({"room":"general","username":"alice"})";
+
+// HttpServer::handleClient 的解析、分发和序列化（不含 socket 读写和数据库）
+void BM_HttpRequestPath(benchmark::State& state) {
+  size_t bytes = 0;
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    auto request = http::HttpRequest::parse(kRawJoinRoom);
+    auto contentLength = request.header("Content-Length");
+    utils::BoundRequest<JoinRoomRequest> req(request.body());
+    http::HttpResponse response(200, "{\"status\":\"success\"}");
+    response.setHeader("Content-Type", "application/json");
+    response.setHeader("Access-Control-Allow-Origin", "*");
+    response.setHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
+    response.setHeader("Access-Control-Allow-Headers", "Content-Type");
+    response.setHeader("Date", http::httpDate());
+    utils::ArenaString out = response.serializeHeaders();
+    bytes += out.size() + response.body().size();
+    benchmark::DoNotOptimize(contentLength);
+    benchmark::DoNotOptimize(req->room);
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(bytes));
+  reportAllocs(state);
+}
+
+// 序列化一个 /messages 大小的响应：拼成完整报文 vs 只生成头部（响应体随后 writev）
+const std::string kMessagesBody(16 * 1024, 'x');
+
+void BM_ResponseToString(benchmark::State& state) {
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    http::HttpResponse response(200, kMessagesBody);
+    utils::ArenaString out = response.toString();
+    benchmark::DoNotOptimize(out);
+  }
+}
+
+void BM_ResponseHeadersForWritev(benchmark::State& state) {
+  for (auto _ : state) {
+    utils::ArenaScope arena(utils::threadArena());
+    http::HttpResponse response(200, kMessagesBody);
+    utils::ArenaString head = response.serializeHeaders();
+    benchmark::DoNotOptimize(head);
+  }
+}
+
+BENCHMARK(BM_LoginHandlerDom);
+BENCHMARK(BM_LoginHandlerArena);
+BENCHMARK(BM_SendMessageEventDom);
+BENCHMARK(BM_SendMessageEventArena);
+BENCHMARK(BM_HttpRequestPath);
+BENCHMARK(BM_ResponseToString);
+BENCHMARK(BM_ResponseHeadersForWritev);
+
+}  // namespace
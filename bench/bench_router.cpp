@@ -0,0 +1,132 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "alloc_counter.hpp"
+#include "http/router.hpp"
+
+namespace {
+
+using Handler = std::function<int(int)>;
+
+const std::vector<std::pair<std::string, std::string>> kRoutes = {
+    {"GET", "/"},          {"GET", "/*"},          {"POST", "/register"},
+    {"POST", "/login"},    {"POST", "/create_room"}, {"POST", "/join_room"},
+    {"GET", "/rooms"},     {"POST", "/send_message"}, {"POST", "/messages"},
+    {"GET", "/users"},     {"POST", "/logout"},
+    {"GET", "/rooms/:name/messages"}};
+
+// 混合静态路由、静态文件通配和不存在的路径
+const std::vector<std::pair<std::string, std::string>> kRequests = {
+    {"POST", "/send_message"}, {"POST", "/messages"}, {"GET", "/rooms"},
+    {"GET", "/users"},         {"POST", "/login"},    {"GET", "/chat.html"},
+    {"GET", "/"},              {"POST", "/nope"}};
+
+void reportAllocs(benchmark::State& state) {
+  state.counters["allocs/req"] = benchmark::Counter(
+      static_cast<double>(bench::allocStats().allocations) /
+      (state.iterations() * kRequests.size()));
+}
+
+// 最初的实现：unordered_map 两级查找，按值返回 std::function（每次拷贝）
+void BM_RouteUnorderedMapCopy(benchmark::State& state) {
+  std::unordered_map<std::string, std::unordered_map<std::string, Handler>>
+      handlers;
+  for (const auto& route : kRoutes) {
+    handlers[route.first][route.second] = [](int x) { return x + 1; };
+  }
+  auto find = [&](const std::string& method,
+                  const std::string& path) -> Handler {
+    auto methodIt = handlers.find(method);
+    if (methodIt != handlers.end()) {
+      auto pathIt = methodIt->second.find(path);
+      if (pathIt != methodIt->second.end()) return pathIt->second;
+      auto wildcardIt = methodIt->second.find("/*");
+      if (wildcardIt != methodIt->second.end()) return wildcardIt->second;
+    }
+    return nullptr;
+  };
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    for (const auto& request : kRequests) {
+      // 原实现从解析结果构造 std::string 再查找
+      Handler handler = find(std::string(request.first),
+                             std::string(request.second));
+      benchmark::DoNotOptimize(handler);
+    }
+  }
+  reportAllocs(state);
+}
+
+// user-030 之后：std::map + std::less<> 用 string_view 查找，返回指针
+void BM_RouteTransparentMap(benchmark::State& state) {
+  std::map<std::string, std::map<std::string, Handler, std::less<>>,
+           std::less<>>
+      handlers;
+  for (const auto& route : kRoutes) {
+    handlers[route.first][route.second] = [](int x) { return x + 1; };
+  }
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    for (const auto& request : kRequests) {
+      const Handler* handler = nullptr;
+      auto methodIt = handlers.find(std::string_view(request.first));
+      if (methodIt != handlers.end()) {
+        auto pathIt = methodIt->second.find(std::string_view(request.second));
+        if (pathIt == methodIt->second.end()) {
+          pathIt = methodIt->second.find(std::string_view("/*"));
+        }
+        if (pathIt != methodIt->second.end()) handler = &pathIt->second;
+      }
+      benchmark::DoNotOptimize(handler);
+    }
+  }
+  reportAllocs(state);
+}
+
+// 前缀树：枚举方法，返回处理函数下标，路径参数写入定长数组
+void BM_RouteTrie(benchmark::State& state) {
+  http::Router router;
+  std::vector<Handler> handlers;
+  for (const auto& route : kRoutes) {
+    router.add(http::parseMethod(route.first), route.second, handlers.size());
+    handlers.push_back([](int x) { return x + 1; });
+  }
+  bench::resetAllocStats();
+  for (auto _ : state) {
+    for (const auto& request : kRequests) {
+      http::PathParams params;
+      size_t index = router.find(http::parseMethod(request.first),
+                                 request.second, params);
+      benchmark::DoNotOptimize(index);
+      benchmark::DoNotOptimize(params.size());
+    }
+  }
+  reportAllocs(state);
+}
+
+void BM_RouteTrieWithParam(benchmark::State& state) {
+  http::Router router;
+  for (size_t i = 0; i < kRoutes.size(); ++i) {
+    router.add(http::parseMethod(kRoutes[i].first), kRoutes[i].second, i);
+  }
+  for (auto _ : state) {
+    http::PathParams params;
+    size_t index =
+        router.find(http::Method::Get, "/rooms/general/messages", params);
+    benchmark::DoNotOptimize(index);
+    benchmark::DoNotOptimize(params.size());
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_RouteUnorderedMapCopy);
+BENCHMARK(BM_RouteTransparentMap);
+BENCHMARK(BM_RouteTrie);
+BENCHMARK(BM_RouteTrieWithParam);
@@ -0,0 +1,60 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chat/session_store.hpp"
+#include "db/database_manager.hpp"
+
+namespace {
+
+constexpr const char* kDbPath = "bench_sessions.db";
+constexpr int kUsers = 1000;
+
+// 改造前每个请求的身份检查：查 is_online，再写 last_active_time
+void BM_IdentityCheckDb(benchmark::State& state) {
+  std::remove(kDbPath);
+  auto manager = std::make_unique<DatabaseManager>(kDbPath);
+  std::vector<std::string> users;
+  for (int i = 0; i < kUsers; ++i) {
+    users.push_back("user" + std::to_string(i));
+    manager->createUser(users.back(), "password");
+    manager->setUserOnlineStatus(users.back(), true);
+  }
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        manager->checkAndUpdateInactiveUsers(users[i++ % users.size()]));
+  }
+  manager.reset();
+  std::remove(kDbPath);
+}
+BENCHMARK(BM_IdentityCheckDb);
+
+// 会话表：一次分片内的哈希查找并顺延过期时间，多线程共享同一张表
+SessionStore* gStore = nullptr;
+std::vector<std::string>* gTokens = nullptr;
+
+void BM_IdentityCheckSession(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    gStore = new SessionStore();
+    gTokens = new std::vector<std::string>();
+    for (int i = 0; i < kUsers; ++i) {
+      gTokens->push_back(gStore->create("user" + std::to_string(i)));
+    }
+  }
+  size_t i = state.thread_index() * 7919;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        gStore->resolve((*gTokens)[i++ % gTokens->size()]));
+  }
+  if (state.thread_index() == 0) {
+    delete gStore;
+    delete gTokens;
+  }
+}
+BENCHMARK(BM_IdentityCheckSession)->Threads(1)->Threads(4)->Threads(8);
+
+}  // namespace
@@ -0,0 +1,56 @@
+#include <benchmark/benchmark.h>
+
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "utils/thread_pool.hpp"
+
+namespace {
+
+constexpr size_t kBatch = 1024;
+
+// 吞吐：提交一批空任务再等全部完成；参数为工作线程数
+void BM_ThreadPoolThroughput(benchmark::State& state) {
+  utils::ThreadPool pool(state.range(0), "bench");
+  std::vector<std::future<void>> futures;
+  futures.reserve(kBatch);
+  for (auto _ : state) {
+    for (size_t i = 0; i < kBatch; ++i) {
+      futures.push_back(pool.enqueue([] {}));
+    }
+    for (auto& future : futures) future.wait();
+    futures.clear();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * kBatch);
+}
+BENCHMARK(BM_ThreadPoolThroughput)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
+
+// 多个线程同时提交（如 HttpServer 的 accept 线程之外再有业务线程提交），
+// 只计 enqueue 本身，任务在后台执行
+utils::ThreadPool* gPool = nullptr;
+
+void BM_ThreadPoolEnqueueContended(benchmark::State& state) {
+  if (state.thread_index() == 0) gPool = new utils::ThreadPool(4, "bench");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(gPool->enqueue([] {}));
+  }
+  if (state.thread_index() == 0) {
+    delete gPool;
+    gPool = nullptr;
+  }
+}
+BENCHMARK(BM_ThreadPoolEnqueueContended)->Threads(1)->Threads(4);
+
+// 延迟：提交一个任务到拿到结果的往返，即空闲工作线程被唤醒的时间
+void BM_ThreadPoolRoundTrip(benchmark::State& state) {
+  utils::ThreadPool pool(4, "bench");
+  int value = 0;
+  for (auto _ : state) {
+    value = pool.enqueue([value] { return value + 1; }).get();
+  }
+  benchmark::DoNotOptimize(value);
+}
+BENCHMARK(BM_ThreadPoolRoundTrip)->UseRealTime();
+
+}  // namespace
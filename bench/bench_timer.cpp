@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <future>
+
+#include "utils/timer.hpp"
+
+namespace {
+
+// 添加一个不会到期的任务：加锁、入堆并唤醒定时线程
+void BM_TimerAddOnceTask(benchmark::State& state) {
+  utils::Timer timer;
+  timer.start();
+  for (auto _ : state) {
+    timer.addOnceTask(std::chrono::hours(1), [] {});
+  }
+  timer.stop();
+}
+BENCHMARK(BM_TimerAddOnceTask);
+
+// 立即到期的任务从添加到回调执行的时间，即定时线程的唤醒延迟
+void BM_TimerFireLatency(benchmark::State& state) {
+  utils::Timer timer;
+  timer.start();
+  for (auto _ : state) {
+    std::promise<void> fired;
+    timer.addOnceTask(std::chrono::milliseconds(0),
+                      [&fired] { fired.set_value(); });
+    fired.get_future().wait();
+  }
+  timer.stop();
+}
+BENCHMARK(BM_TimerFireLatency)->UseRealTime();
+
+}  // namespace
@@ -0,0 +1,28 @@
+#include <benchmark/benchmark.h>
+
+#include "utils/tracing.hpp"
+
+namespace {
+
+// 追踪关闭或请求未被采样时，每个阶段只多一次线程局部变量读取
+void BM_TraceSpanUnsampled(benchmark::State& state) {
+  utils::tracer().setSampleRate(0);
+  utils::TraceRequest request("request");
+  for (auto _ : state) {
+    utils::TraceSpan span("phase", "bench");
+  }
+}
+BENCHMARK(BM_TraceSpanUnsampled);
+
+// 被采样的请求：两次取时间加一次写环形缓冲区
+void BM_TraceSpanSampled(benchmark::State& state) {
+  utils::tracer().setSampleRate(1);
+  utils::TraceRequest request("request");
+  for (auto _ : state) {
+    utils::TraceSpan span("phase", "bench");
+  }
+  utils::tracer().setSampleRate(0);
+}
+BENCHMARK(BM_TraceSpanSampled);
+
+}  // namespace
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "utils/arena.hpp"
+
+/**
+ * 处理函数中构建的 JSON（如 Kafka 事件）统一使用 chat_json。
+ * 节点、字符串、对象和数组都从 utils::ArenaScope 设置的请求内存池分配，
+ * 请求结束时随 arena 一起释放。chat_json 不能保存到请求之外，
+ * dump() 返回的 utils::ArenaString 同样只在请求内有效。
+ */
+using chat_json =
+    nlohmann::basic_json<std::map, std::vector, utils::ArenaString, bool,
+                         std::int64_t, std::uint64_t, double,
+                         utils::ArenaAllocator>;
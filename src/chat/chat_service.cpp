@@ -0,0 +1,396 @@
+#include "chat_service.hpp"
+
+#include <charconv>
+#include <chrono>
+
+#include "chat/chat_json.hpp"
+#include "chat/requests.hpp"
+#include "utils/json_writer.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+
+namespace {
+
+// Kafka 事件只序列化一次，发送和日志共用同一份文本。
+// 未配置 Kafka 时 producer 为空，直接丢弃
+void publishEvent(KafkaProducer* producer, const chat_json& event) {
+  if (!producer) return;
+  const utils::ArenaString payload = event.dump();
+  std::string_view text(payload.data(), payload.size());
+  if (producer->send(text)) {
+    LOG(INFO) << "Kafka send success: " << text;
+  } else {
+    LOG(ERROR) << "Kafka send failed: " << text;
+  }
+}
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+constexpr const char* kUnauthorized =
+    "{\"error\":\"Invalid or expired session\"}";
+constexpr const char* kForbidden =
+    "{\"error\":\"User does not match session\"}";
+
+using Response = ChatService::Response;
+
+// 已有结果时直接完成的 Task
+Response ready(http::HttpResponse response) { co_return response; }
+
+// 把请求体绑定为 Request 后 co_await handler(req)。请求体复制到协程帧中，
+// Request 的 string_view 指向这份副本，跨 co_await 仍然有效。非法 JSON
+// 或缺少字段时直接返回 400，不进入处理函数
+template <typename Request, typename F>
+Response bindAndRun(const http::HttpRequest& request, F handler) {
+  std::string body(request.body());
+  utils::BoundRequest<Request> bound(body);
+  if (bound.status() == utils::BindStatus::InvalidJson) {
+    LOG(ERROR) << "Invalid JSON in request to " << request.path();
+    co_return http::HttpResponse(400, "{\"error\":\"Invalid JSON\"}");
+  }
+  if (bound.status() == utils::BindStatus::MissingField) {
+    LOG(ERROR) << "Missing required fields in request to " << request.path();
+    co_return http::HttpResponse(400, Request::kMissingError);
+  }
+  try {
+    co_return co_await handler(*bound);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Request handler failed: " << e.what();
+    co_return http::HttpResponse(500, "{\"error\":\"Internal server error\"}");
+  }
+}
+
+template <typename Request, typename F>
+ChatService::Handler typedHandler(F handler) {
+  return [handler = std::move(handler)](const http::HttpRequest& request) {
+    return bindAndRun<Request>(request, handler);
+  };
+}
+
+// 校验会话令牌并按用户限流：令牌无效或过期返回 401，该用户超出限流
+// 返回 429；通过时返回空，user 为会话用户
+std::optional<http::HttpResponse> checkSession(
+    const http::HttpRequest& request, SessionStore& sessions,
+    http::RateLimiter* limiter, std::string& user) {
+  std::optional<std::string_view> token = SessionStore::tokenFrom(request);
+  std::optional<std::string> resolved;
+  if (token) resolved = sessions.resolve(*token);
+  if (!resolved) return http::HttpResponse(401, kUnauthorized);
+  user = std::move(*resolved);
+  if (limiter) {
+    uint32_t retryAfter =
+        limiter->acquireForUser(user, request.method(), request.path());
+    if (retryAfter) {
+      LOG(WARN) << "Rate limited user: " << user;
+      return http::tooManyRequests(retryAfter);
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename Request, typename F>
+Response runWithSession(const http::HttpRequest& request,
+                        SessionStore& sessions, http::RateLimiter* limiter,
+                        F handler) {
+  std::string user;
+  if (auto denied = checkSession(request, sessions, limiter, user)) {
+    co_return std::move(*denied);
+  }
+  // 令牌指向请求报文，挂起后不再有效
+  std::string sessionToken(*SessionStore::tokenFrom(request));
+  auto checked = [&](const Request& req) -> Response {
+    std::optional<std::string_view> actor = req.actor();
+    if (actor && *actor != user) {
+      LOG(WARN) << "User " << *actor << " does not match session of "
+                << user;
+      return ready(http::HttpResponse(403, kForbidden));
+    }
+    return handler(req, sessionToken);
+  };
+  co_return co_await bindAndRun<Request>(request, checked);
+}
+
+// 需要登录的接口：令牌无效或过期返回 401，该用户超出限流返回 429，
+// 请求体中的操作者与会话用户不一致返回 403。处理函数的第二个参数是
+// 会话令牌。路由可能先于 setRateLimit() 注册，所以限流器按引用捕获，
+// 为空时不按用户限流
+template <typename Request, typename F>
+ChatService::Handler sessionHandler(
+    SessionStore& sessions, const std::unique_ptr<http::RateLimiter>& limiter,
+    F handler) {
+  return [&sessions, &limiter, handler = std::move(handler)](
+             const http::HttpRequest& request) {
+    return runWithSession<Request>(request, sessions, limiter.get(), handler);
+  };
+}
+
+http::HttpResponse jsonResponse(std::string_view body) {
+  http::HttpResponse resp(200, body);
+  resp.setHeader("Content-Type", "application/json");
+  return resp;
+}
+
+}  // namespace
+
+ChatService::ChatService(const std::string& db_file_path,
+                         const std::string& kafka_brokers)
+    : db_(std::make_shared<DatabaseManager>(db_file_path), kDbThreads),
+      kafkaProducer_(kafka_brokers.empty()
+                         ? nullptr
+                         : std::make_unique<KafkaProducer>(kafka_brokers,
+                                                           "chatroom_events")) {
+}
+
+void ChatService::setRateLimit(const http::RateLimitOptions& options) {
+  rateLimiter_.reset();
+  if (options.enabled) {
+    rateLimiter_ = std::make_unique<http::RateLimiter>(options);
+  }
+}
+
+void ChatService::start() {
+  if (started_.exchange(true)) return;
+  sessionTimer_.addPeriodicTask(kSessionSweepInterval, kSessionSweepInterval,
+                                [this]() { expireSessions(); });
+  sessionTimer_.start();
+}
+
+void ChatService::stop() { sessionTimer_.stop(); }
+
+void ChatService::expireSessions() {
+  for (const std::string& username : sessions_.sweep()) {
+    LOG(INFO) << "Session expired: " << username;
+    db_.sync().setUserOnlineStatus(username, false);
+  }
+}
+
+void ChatService::appendMetrics(std::string& out) const {
+  utils::appendMetric(out, "chat_sessions", "gauge", "Active login sessions",
+                      sessions_.size());
+  if (rateLimiter_) {
+    utils::appendMetric(out, "rate_limiter_buckets", "gauge",
+                        "Token buckets held by the rate limiter",
+                        rateLimiter_->bucketCount());
+  }
+}
+
+void ChatService::mount(const Mount& mount) {
+  // 协程中从 arena 分配的对象（HttpResponse、chat_json）只在最后一次
+  // co_await 之后创建，挂起期间不持有
+  mount("POST", "/register",
+        typedHandler<RegisterRequest>(
+            [this](const RegisterRequest& req) -> Response {
+              if (co_await db_.isUserExists(req.username)) {
+                LOG(WARN) << "Username already exists: " << req.username;
+                co_return http::HttpResponse(
+                    400, "{\"error\":\"Username already exists\"}");
+              }
+              if (co_await db_.createUser(req.username, req.password)) {
+                LOG(INFO) << "User registered: " << req.username;
+                co_return jsonResponse("{\"status\":\"success\"}");
+              }
+              LOG(ERROR) << "Failed to create user in database: "
+                         << req.username;
+              co_return http::HttpResponse(
+                  500, "{\"error\":\"Internal server error\"}");
+            }));
+
+  mount("POST", "/login",
+        typedHandler<LoginRequest>([this](const LoginRequest& req) -> Response {
+          if (!co_await db_.validateUser(req.username, req.password)) {
+            LOG(WARN) << "Invalid login attempt for user: " << req.username;
+            co_return http::HttpResponse(
+                401, "{\"error\":\"Invalid username or password\"}");
+          }
+          LOG(INFO) << "User logged in: " << req.username;
+          co_await db_.setUserOnlineStatus(req.username, true);
+          std::string token = sessions_.create(req.username);
+
+          // 添加Kafka事件
+          chat_json kafka_event = {{"username", req.username},
+                                   {"action", "login"},
+                                   {"timestamp", nowMs()},
+                                   {"type", "user_event"}};
+          publishEvent(kafkaProducer_.get(), kafka_event);
+
+          std::string body;
+          utils::JsonWriter(body)
+              .beginObject()
+              .key("status")
+              .value("success")
+              .key("username")
+              .value(req.username)
+              .key("token")
+              .value(token)
+              .endObject();
+          http::HttpResponse resp = jsonResponse(body);
+          resp.setHeader("Set-Cookie",
+                         std::string(SessionStore::kCookieName) + "=" + token +
+                             "; Path=/; HttpOnly; SameSite=Strict");
+          co_return resp;
+        }));
+
+  mount("POST", "/create_room",
+        sessionHandler<CreateRoomRequest>(
+            sessions_, rateLimiter_,
+            [this](const CreateRoomRequest& req, std::string_view) -> Response {
+              if (co_await db_.createRoom(req.name, req.creator) &&
+                  co_await db_.addUserToRoom(req.name, req.creator)) {
+                LOG(INFO) << "Created room and added creator: " << req.name
+                          << ", " << req.creator;
+                // 添加Kafka事件
+                chat_json kafka_event = {{"room", req.name},
+                                         {"creator", req.creator},
+                                         {"action", "create_room"},
+                                         {"timestamp", nowMs()},
+                                         {"type", "room_event"}};
+                publishEvent(kafkaProducer_.get(), kafka_event);
+                co_return jsonResponse("{\"status\":\"success\"}");
+              }
+              LOG(ERROR) << "Failed to create room: " << req.name;
+              co_return http::HttpResponse(
+                  500, "{\"error\":\"Failed to create room\"}");
+            }));
+
+  mount("POST", "/join_room",
+        sessionHandler<JoinRoomRequest>(
+            sessions_, rateLimiter_,
+            [this](const JoinRoomRequest& req, std::string_view) -> Response {
+              if (co_await db_.addUserToRoom(req.room, req.username)) {
+                LOG(INFO) << "User " << req.username
+                          << " joined room: " << req.room;
+                co_return jsonResponse("{\"status\":\"success\"}");
+              }
+              LOG(WARN) << "Failed to join room: " << req.room;
+              co_return http::HttpResponse(404,
+                                           "{\"error\":\"Room not found\"}");
+            }));
+
+  mount("GET", "/rooms", [this](const http::HttpRequest&) -> Response {
+    co_return jsonResponse(co_await db_.getRoomList());
+  });
+
+  // 只读地获取房间消息，不更新用户活跃状态：?since=<毫秒时间戳>。
+  // 和 POST /messages 一样需要登录，也按用户限流
+  mount("GET", "/rooms/:name/messages",
+        [this](const http::HttpRequest& request) -> Response {
+          std::string user;
+          if (auto denied = checkSession(request, sessions_,
+                                         rateLimiter_.get(), user)) {
+            return ready(std::move(*denied));
+          }
+          // 挂起前先取出参数，房间名复制到协程帧中
+          std::string room(
+              http::HttpRequest::urlDecode(*request.pathParam("name")));
+          int64_t since = 0;
+          if (auto value = request.queryParam("since")) {
+            std::from_chars(value->data(), value->data() + value->size(),
+                            since);
+          }
+          return roomMessages(std::move(room), since);
+        });
+
+  mount("POST", "/send_message",
+        sessionHandler<SendMessageRequest>(
+            sessions_, rateLimiter_,
+            [this](const SendMessageRequest& req,
+                   std::string_view) -> Response {
+              int64_t timestamp = nowMs();
+              if (!co_await db_.saveMessage(req.room, req.username,
+                                            req.content, timestamp)) {
+                LOG(ERROR) << "Failed to save message";
+                co_return http::HttpResponse(
+                    500, "{\"error\":\"Failed to save message\"}");
+              }
+              LOG(INFO) << "Message saved from " << req.username
+                        << " in room " << req.room;
+              if (rooms_) {
+                std::string entry;
+                utils::JsonWriter(entry)
+                    .beginObject()
+                    .key("content")
+                    .value(req.content)
+                    .key("timestamp")
+                    .value(timestamp)
+                    .key("username")
+                    .value(req.username)
+                    .endObject();
+                co_await rooms_->append(std::string(req.room), timestamp,
+                                        std::move(entry));
+              }
+
+              // Kafka 消息发送
+              chat_json kafka_message = {{"room", req.room},
+                                         {"username", req.username},
+                                         {"content", req.content},
+                                         {"timestamp", timestamp},
+                                         {"type", "chat_message"}};
+              publishEvent(kafkaProducer_.get(), kafka_message);
+              co_return jsonResponse("{\"status\":\"success\"}");
+            }));
+
+  mount("POST", "/messages",
+        sessionHandler<GetMessagesRequest>(
+            sessions_, rateLimiter_,
+            [this](const GetMessagesRequest& req,
+                   std::string_view) -> Response {
+              // 用户活跃时间由会话表记录，这里只读消息
+              co_return co_await roomMessages(std::string(req.room),
+                                              req.since.value_or(0));
+            }));
+
+  mount("GET", "/users", [this](const http::HttpRequest&) -> Response {
+    try {
+      co_return jsonResponse(co_await db_.getUserList());
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Error getting user list: " << e.what();
+      co_return http::HttpResponse(500,
+                                   "{\"error\":\"Internal server error\"}");
+    }
+  });
+
+  // 采样请求的阶段耗时，Chrome trace-event JSON，可在 Perfetto 中打开
+  mount("GET", "/debug/trace", [](const http::HttpRequest&) {
+    if (!utils::tracer().enabled()) {
+      return ready(
+          http::HttpResponse(404, "{\"error\":\"Tracing disabled\"}"));
+    }
+    return ready(jsonResponse(utils::tracer().dumpChromeTrace()));
+  });
+
+  mount("POST", "/logout",
+        sessionHandler<LogoutRequest>(
+            sessions_, rateLimiter_,
+            [this](const LogoutRequest& req,
+                   std::string_view token) -> Response {
+              // 同一用户还有其他会话（如另一个标签页）时保持在线
+              if (!sessions_.remove(token) ||
+                  co_await db_.setUserOnlineStatus(req.username, false)) {
+                LOG(INFO) << "User logged out: " << req.username;
+                co_return jsonResponse("{\"status\":\"success\"}");
+              }
+              LOG(ERROR) << "Failed to logout user: " << req.username;
+              co_return http::HttpResponse(
+                  500, "{\"error\":\"Internal server error\"}");
+            }));
+}
+
+ChatService::Response ChatService::roomMessages(std::string room,
+                                                int64_t since) {
+  if (rooms_) {
+    std::optional<utils::SharedBuffer> cached =
+        co_await rooms_->messagesAfter(room, since);
+    if (cached) {
+      // 同一房间的轮询者共用一份应答，发送时通过 iovec 引用，不复制
+      http::HttpResponse resp(200);
+      resp.setHeader("Content-Type", "application/json");
+      resp.setBody(std::move(*cached));
+      co_return resp;
+    }
+  }
+  co_return jsonResponse(co_await db_.getRoomMessages(room, since));
+}
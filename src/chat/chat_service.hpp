@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "chat/room_shards.hpp"
+#include "chat/session_store.hpp"
+#include "db/async_database.hpp"
+#include "http/http_request.hpp"
+#include "http/http_response.hpp"
+#include "http/rate_limiter.hpp"
+#include "reactor/task.hpp"
+#include "utils/kafka_producer.hpp"
+#include "utils/timer.hpp"
+
+/**
+ * @brief 聊天业务层，与传输方式无关
+ * 路由处理函数只依赖 HttpRequest/HttpResponse。线程池服务器和 epoll
+ * 服务器挂载同一组处理函数，对比不同传输模型时业务逻辑完全相同。
+ * 数据库、会话表和限流器各自加锁，处理函数可在多个线程中并发调用，
+ * 多个事件循环可以共用一个 ChatService。
+ *
+ * 处理函数是协程：在事件循环上等待数据库时挂起，查询在数据库线程池
+ * 中执行，完成后回到原循环继续，挂起的请求只占一个协程帧。线程池
+ * 服务器用 reactor::syncWait() 同步运行，查询直接在工作线程执行。
+ */
+class ChatService {
+ public:
+  // 返回的 Task 须在 request 有效时启动，处理函数挂起前只同步读取
+  // request，需要跨 co_await 的内容（如请求体）复制到协程帧中
+  using Response = reactor::Task<http::HttpResponse>;
+  using Handler = std::function<Response(const http::HttpRequest&)>;
+  // 传输层提供的路由注册函数
+  using Mount = std::function<void(const std::string& method,
+                                   const std::string& path, Handler handler)>;
+
+  // kafka_brokers 为空时不发送 Kafka 事件
+  ChatService(const std::string& db_file_path,
+              const std::string& kafka_brokers);
+
+  // 注册业务路由：注册、登录、房间、消息、用户列表和 /debug/trace。
+  // 静态文件和 /metrics 由传输层自己处理
+  void mount(const Mount& mount);
+
+  // 在处理请求之前调用。按 IP 和按用户共用，未启用时为空
+  void setRateLimit(const http::RateLimitOptions& options);
+  http::RateLimiter* rateLimiter() const { return rateLimiter_.get(); }
+
+  // 在处理请求之前调用：新消息追加到所属循环的房间缓存，轮询优先从
+  // 缓存回答。shards 由传输层持有，处理函数须在其事件循环上运行
+  void setRoomShards(RoomShards* shards) { rooms_ = shards; }
+
+  // 开始定期清理过期会话，重复调用只启动一次
+  void start();
+  void stop();
+
+  // GET /metrics 中的业务指标：会话数和限流桶数
+  void appendMetrics(std::string& out) const;
+
+ private:
+  // 清理过期会话，没有剩余会话的用户标记为离线
+  void expireSessions();
+  // 读取房间消息，有房间缓存时先查缓存。参数已从请求中复制出来
+  Response roomMessages(std::string room, int64_t since);
+  static constexpr std::chrono::seconds kSessionSweepInterval{60};
+  // DatabaseManager 只有一个连接、整体加锁，多开线程只会排队等锁
+  static constexpr size_t kDbThreads = 1;
+
+  AsyncDatabase db_;
+  std::unique_ptr<KafkaProducer> kafkaProducer_;
+  std::unique_ptr<http::RateLimiter> rateLimiter_;
+  RoomShards* rooms_{nullptr};
+  SessionStore sessions_;
+  std::atomic<bool> started_{false};
+  // 最后声明，先于会话表和数据库停止
+  utils::Timer sessionTimer_;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <tuple>
+
+#include "utils/json_binder.hpp"
+
+/**
+ * 各接口的请求体，由 utils::BoundRequest 按 fields() 字段表绑定。
+ * string_view 指向请求体，只在处理函数内有效。
+ * kMissingError 为缺少字段（或类型不符）时返回的响应体。
+ * 需要登录的接口用 actor() 给出请求体声明的操作者，须与会话用户一致。
+ */
+
+// POST /register, POST /login
+struct LoginRequest {
+  std::string_view username;
+  std::string_view password;
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing username or password\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("username", &LoginRequest::username),
+        utils::requiredField("password", &LoginRequest::password));
+  }
+};
+using RegisterRequest = LoginRequest;
+
+// POST /create_room
+struct CreateRoomRequest {
+  std::string_view name;
+  std::string_view creator;
+
+  std::optional<std::string_view> actor() const { return creator; }
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing room name or creator\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("name", &CreateRoomRequest::name),
+        utils::requiredField("creator", &CreateRoomRequest::creator));
+  }
+};
+
+// POST /join_room
+struct JoinRoomRequest {
+  std::string_view room;
+  std::string_view username;
+
+  std::optional<std::string_view> actor() const { return username; }
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing room or username\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("room", &JoinRoomRequest::room),
+        utils::requiredField("username", &JoinRoomRequest::username));
+  }
+};
+
+// POST /send_message
+struct SendMessageRequest {
+  std::string_view room;
+  std::string_view username;
+  std::string_view content;
+
+  std::optional<std::string_view> actor() const { return username; }
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing required fields\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("room", &SendMessageRequest::room),
+        utils::requiredField("username", &SendMessageRequest::username),
+        utils::requiredField("content", &SendMessageRequest::content));
+  }
+};
+
+// POST /messages，since 必须出现但可以为 null（等同于 0）
+struct GetMessagesRequest {
+  std::string_view room;
+  std::optional<int64_t> since;
+  std::optional<std::string_view> username;
+
+  std::optional<std::string_view> actor() const { return username; }
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing required fields\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("room", &GetMessagesRequest::room),
+        utils::requiredField("since", &GetMessagesRequest::since),
+        utils::optionalField("username", &GetMessagesRequest::username));
+  }
+};
+
+// POST /logout
+struct LogoutRequest {
+  std::string_view username;
+
+  std::optional<std::string_view> actor() const { return username; }
+
+  static constexpr const char* kMissingError =
+      "{\"error\":\"Missing username\"}";
+  static constexpr auto fields() {
+    return std::make_tuple(
+        utils::requiredField("username", &LogoutRequest::username));
+  }
+};
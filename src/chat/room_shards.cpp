@@ -0,0 +1,151 @@
+#include "room_shards.hpp"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+RoomShards::RoomShards(size_t shards, size_t maxRecent)
+    : maxRecent_(std::max<size_t>(maxRecent, 1)),
+      hits_(utils::metrics().counter(
+          "room_cache_lookups_total",
+          "Message polls answered by the owning loop's room cache",
+          {{"result", "hit"}})),
+      misses_(utils::metrics().counter(
+          "room_cache_lookups_total",
+          "Message polls answered by the owning loop's room cache",
+          {{"result", "miss"}})) {
+  shards = std::max<size_t>(shards, 1);
+  for (size_t i = 0; i < shards; ++i) {
+    auto shard = std::make_unique<Shard>();
+    shard->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (shard->wakeFd < 0) {
+      throw std::runtime_error("Failed to create room mailbox eventfd");
+    }
+    shards_.push_back(std::move(shard));
+  }
+}
+
+RoomShards::~RoomShards() {
+  for (auto& shard : shards_) close(shard->wakeFd);
+}
+
+size_t RoomShards::shardOf(std::string_view room) const {
+  return std::hash<std::string_view>()(room) % shards_.size();
+}
+
+void RoomShards::attach(size_t shard, reactor::EventLoop& loop) {
+  Shard& s = *shards_[shard];
+  s.loop.store(&loop, std::memory_order_release);
+  attached_.fetch_add(1, std::memory_order_acq_rel);
+  auto channel = std::make_shared<reactor::Channel>(s.wakeFd);
+  channel->setEvents(EPOLLIN);
+  channel->setReadCallback([this, shard]() { drain(shard); });
+  loop.addChannel(channel);
+}
+
+void RoomShards::detach() {
+  attached_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void RoomShards::post(size_t shard, std::function<void()> op) {
+  Shard& s = *shards_[shard];
+  s.mailbox.push(std::move(op));
+  // 信箱被清空之前只写一次 eventfd
+  if (!s.signaled.exchange(true)) {
+    uint64_t one = 1;
+    ssize_t n = write(s.wakeFd, &one, sizeof(one));
+    (void)n;
+  }
+}
+
+void RoomShards::drain(size_t shard) {
+  Shard& s = *shards_[shard];
+  uint64_t count;
+  ssize_t n = read(s.wakeFd, &count, sizeof(count));
+  (void)n;
+  // 先清标志再取：之后入队的操作会重新写 eventfd
+  s.signaled.store(false);
+  while (std::optional<std::function<void()>> op = s.mailbox.pop()) (*op)();
+}
+
+RoomShards::Room& RoomShards::room(size_t shard, const std::string& name) {
+  Shard& s = *shards_[shard];
+  auto it = s.rooms.find(name);
+  if (it != s.rooms.end()) {
+    s.lru.splice(s.lru.begin(), s.lru, it->second.lruPos);
+    return it->second.room;
+  }
+  // 缓存可以随时丢弃，重新建立的房间从当前时间开始完整。淘汰最久
+  // 没有访问的房间，活跃的房间一直留在缓存里
+  if (s.rooms.size() >= kMaxRooms) {
+    const std::string* oldest = s.lru.back();
+    s.lru.pop_back();
+    s.rooms.erase(*oldest);
+  }
+  it = s.rooms.try_emplace(name).first;
+  s.lru.push_front(&it->first);
+  it->second.lruPos = s.lru.begin();
+  it->second.room.completeAfter = nowMs();
+  return it->second.room;
+}
+
+RoomCall<bool> RoomShards::append(std::string room, int64_t timestamp,
+                                  std::string json) {
+  return call(std::move(room), [this, timestamp, json = std::move(json)](
+                                   Room& r) mutable {
+    // 建立缓存之前的消息只在数据库里
+    if (timestamp <= r.completeAfter) return true;
+    // 几乎总是追加在末尾；并发发送时保存顺序可能与时间戳不同
+    auto pos = std::upper_bound(
+        r.recent.begin(), r.recent.end(), timestamp,
+        [](int64_t ts, const Message& m) { return ts < m.timestamp; });
+    r.recent.insert(pos, Message{timestamp, std::move(json)});
+    r.answer = utils::SharedBuffer();
+    if (r.recent.size() > maxRecent_) {
+      r.completeAfter = r.recent.front().timestamp;
+      r.recent.pop_front();
+    }
+    return true;
+  });
+}
+
+RoomCall<std::optional<utils::SharedBuffer>> RoomShards::messagesAfter(
+    std::string room, int64_t since) {
+  return call(std::move(room),
+              [this, since](Room& r) -> std::optional<utils::SharedBuffer> {
+                // since 为 0 时要全部历史，只有数据库有
+                if (since <= 0 || since < r.completeAfter) {
+                  misses_.inc();
+                  return std::nullopt;
+                }
+                hits_.inc();
+                if (r.answer && r.answerSince == since) return r.answer;
+                auto it = std::upper_bound(
+                    r.recent.begin(), r.recent.end(), since,
+                    [](int64_t ts, const Message& m) {
+                      return ts < m.timestamp;
+                    });
+                std::string json = "[";
+                for (; it != r.recent.end(); ++it) {
+                  if (json.size() > 1) json += ',';
+                  json += it->json;
+                }
+                json += ']';
+                r.answerSince = since;
+                r.answer = utils::SharedBuffer::copyOf(json);
+                return r.answer;
+              });
+}
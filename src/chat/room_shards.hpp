@@ -0,0 +1,187 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "reactor/event_loop.hpp"
+#include "utils/arena.hpp"
+#include "utils/metrics.hpp"
+#include "utils/mpsc_queue.hpp"
+#include "utils/shared_buffer.hpp"
+#include "utils/tracing.hpp"
+
+template <typename R>
+class RoomCall;
+
+/**
+ * @brief 按房间划分给事件循环的内存状态（actor 模型）
+ * 房间名哈希到分片，每个分片归一个事件循环所有，只在该循环的线程上
+ * 读写，不加锁。其他循环通过分片的无锁 MPSC 信箱投递操作，所属循环
+ * 被 eventfd 唤醒后依次执行，结果经 queueInLoop() 送回发起的循环恢复
+ * 协程；发起者就是所属循环时直接执行，不经过信箱。
+ *
+ * 目前分片缓存各房间最近的消息，轮询不用再排队等数据库锁。消息仍先
+ * 写入数据库，缓存不完整的查询（since 为 0 或早于缓存范围）仍查数据库。
+ */
+class RoomShards {
+ public:
+  struct Message {
+    int64_t timestamp;
+    // 序列化好的对象，格式与 getRoomMessages() 数组的元素相同
+    std::string json;
+  };
+  struct Room {
+    std::deque<Message> recent;  // 按时间戳升序
+    // 时间戳大于它的消息都在 recent 中：建立时为当时的时间，
+    // 淘汰旧消息后为被淘汰的最新一条的时间戳
+    int64_t completeAfter{0};
+    // 最近一次轮询的应答。同一时刻的轮询者通常带着相同的 since，
+    // 共用这一份序列化结果，追加消息时作废
+    int64_t answerSince{-1};
+    utils::SharedBuffer answer;
+  };
+
+  static constexpr size_t kMaxRecent = 512;  // 每个房间缓存的消息数
+  // 每个分片缓存的房间数，超出时淘汰最久没有访问的房间
+  static constexpr size_t kMaxRooms = 4096;
+
+  explicit RoomShards(size_t shards, size_t maxRecent = kMaxRecent);
+  ~RoomShards();
+  RoomShards(const RoomShards&) = delete;
+  RoomShards& operator=(const RoomShards&) = delete;
+
+  size_t size() const { return shards_.size(); }
+  size_t shardOf(std::string_view room) const;
+
+  // 在所属循环的线程上、loop() 之前调用，登记信箱的 eventfd
+  void attach(size_t shard, reactor::EventLoop& loop);
+  // 所属循环自己的处理函数都已完成。之后它仍要 drain() 信箱，
+  // 直到 attached() 为 0，其他循环挂起的处理函数还可能访问它的房间
+  void detach();
+  size_t attached() const {
+    return attached_.load(std::memory_order_acquire);
+  }
+  // 在所属循环的线程上执行信箱中的操作
+  void drain(size_t shard);
+
+  // 在 room 所属的循环上执行 fn(Room&)，返回可 co_await 的对象。
+  // 只能在事件循环线程上 co_await，fn 的结果复制回发起的循环
+  template <typename F>
+  RoomCall<std::invoke_result_t<F&, Room&>> call(std::string room, F fn);
+
+  // 消息写入数据库后追加到房间缓存，结果恒为 true
+  RoomCall<bool> append(std::string room, int64_t timestamp,
+                        std::string json);
+  // 时间戳大于 since 的消息，JSON 数组与 getRoomMessages() 相同，
+  // 相同的查询共用一个缓冲区；缓存不能完整回答时为空，由调用方查数据库
+  RoomCall<std::optional<utils::SharedBuffer>> messagesAfter(std::string room,
+                                                             int64_t since);
+
+ private:
+  template <typename R>
+  friend class RoomCall;
+
+  struct Shard {
+    std::atomic<reactor::EventLoop*> loop{nullptr};
+    int wakeFd{-1};
+    std::atomic<bool> signaled{false};  // 已写 eventfd、信箱还没被清空
+    utils::MpscQueue<std::function<void()>> mailbox;
+    struct CachedRoom {
+      Room room;
+      std::list<const std::string*>::iterator lruPos;
+    };
+    std::unordered_map<std::string, CachedRoom> rooms;
+    // 指向 rooms 中的房间名，最近访问的在前
+    std::list<const std::string*> lru;
+  };
+
+  reactor::EventLoop* owner(size_t shard) const {
+    return shards_[shard]->loop.load(std::memory_order_acquire);
+  }
+  // 可在任意线程调用，op 在所属循环的线程上执行
+  void post(size_t shard, std::function<void()> op);
+  // 只在所属循环的线程上调用，不存在时建立
+  Room& room(size_t shard, const std::string& name);
+
+  size_t maxRecent_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<size_t> attached_{0};
+  utils::Counter hits_;
+  utils::Counter misses_;
+};
+
+/**
+ * @brief RoomShards::call() 返回的 awaitable
+ * 与 reactor::Offload 相同，恢复时处在本线程 arena 的作用域内，
+ * 创建时正在追踪的请求在所属循环上执行 fn 和恢复协程时保持不变
+ */
+template <typename R>
+class RoomCall {
+ public:
+  RoomCall(RoomShards& shards, std::string room,
+           std::function<R(RoomShards::Room&)> fn)
+      : shards_(shards),
+        shard_(shards.shardOf(room)),
+        room_(std::move(room)),
+        fn_(std::move(fn)),
+        traceId_(utils::trace_detail::activeRequest) {}
+
+  bool await_ready() {
+    caller_ = reactor::EventLoop::current();
+    if (!caller_) throw std::logic_error("RoomShards: not on an event loop");
+    return shards_.owner(shard_) == caller_;
+  }
+  void await_suspend(std::coroutine_handle<> handle) {
+    shards_.post(shard_, [this, handle]() {
+      uint64_t traceId = traceId_;
+      {
+        utils::TraceScope trace(traceId);
+        try {
+          result_.emplace(fn_(shards_.room(shard_, room_)));
+        } catch (...) {
+          error_ = std::current_exception();
+        }
+      }
+      caller_->queueInLoop([handle, traceId]() {
+        utils::ArenaScope arena(utils::threadArena());
+        utils::TraceScope trace(traceId);
+        handle.resume();
+      });
+    });
+  }
+  R await_resume() {
+    if (error_) std::rethrow_exception(error_);
+    if (result_) return std::move(*result_);
+    return fn_(shards_.room(shard_, room_));  // 就在所属循环上
+  }
+
+ private:
+  RoomShards& shards_;
+  size_t shard_;
+  std::string room_;
+  std::function<R(RoomShards::Room&)> fn_;
+  uint64_t traceId_;
+  reactor::EventLoop* caller_{nullptr};
+  std::optional<R> result_;
+  std::exception_ptr error_;
+};
+
+template <typename F>
+RoomCall<std::invoke_result_t<F&, RoomShards::Room&>> RoomShards::call(
+    std::string room, F fn) {
+  return {*this, std::move(room), std::move(fn)};
+}
@@ -0,0 +1,172 @@
+#include "session_store.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  return -1;
+}
+
+std::string_view trim(std::string_view s) {
+  while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+  while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+  return s;
+}
+
+}  // namespace
+
+SessionStore::SessionStore(std::chrono::milliseconds ttl) : ttl_(ttl) {}
+
+std::string SessionStore::create(std::string_view username) {
+  // random_device 在 Linux 上读取内核随机源，登录不在热路径上
+  std::random_device random;
+  Key key{};
+  for (int i = 0; i < 2; ++i) {
+    key.hi = (key.hi << 32) | random();
+    key.lo = (key.lo << 32) | random();
+  }
+
+  std::string token(kTokenLength, '0');
+  for (size_t i = 0; i < 16; ++i) {
+    token[i] = kHexDigits[(key.hi >> (60 - 4 * i)) & 0xf];
+    token[16 + i] = kHexDigits[(key.lo >> (60 - 4 * i)) & 0xf];
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(usersMutex_);
+    ++userSessions_[std::string(username)];
+  }
+  Shard& shard = shardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  // 在锁内取时间，保证新会话的截止时间不早于队尾
+  Clock::time_point deadline = Clock::now() + ttl_;
+  shard.sessions[key] = Session{std::string(username), deadline};
+  shard.expiries.push_back(Expiry{deadline, key});
+  return token;
+}
+
+std::optional<std::string> SessionStore::resolve(std::string_view token) {
+  std::optional<Key> key = parseToken(token);
+  if (!key) return std::nullopt;
+  Shard& shard = shardFor(*key);
+  Clock::time_point now = Clock::now();
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.sessions.find(*key);
+  // 已过期但还没被 sweep() 清理的会话同样视为无效
+  if (it == shard.sessions.end() || it->second.expiresAt <= now) {
+    return std::nullopt;
+  }
+  it->second.expiresAt = now + ttl_;
+  return it->second.username;
+}
+
+bool SessionStore::remove(std::string_view token) {
+  std::optional<Key> key = parseToken(token);
+  if (!key) return false;
+  Shard& shard = shardFor(*key);
+  std::string username;
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.sessions.find(*key);
+    if (it == shard.sessions.end()) return false;
+    username = std::move(it->second.username);
+    // 过期队列中的条目留到 sweep() 时跳过
+    shard.sessions.erase(it);
+  }
+  return releaseUser(username);
+}
+
+std::vector<std::string> SessionStore::sweep() {
+  std::vector<std::string> expired;
+  Clock::time_point now = Clock::now();
+  for (Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    while (!shard.expiries.empty() && shard.expiries.front().deadline <= now) {
+      Key key = shard.expiries.front().key;
+      shard.expiries.pop_front();
+      auto it = shard.sessions.find(key);
+      if (it == shard.sessions.end()) continue;
+      if (it->second.expiresAt <= now) {
+        expired.push_back(std::move(it->second.username));
+        shard.sessions.erase(it);
+      } else {
+        // 期间被访问过，按新的过期时间插回队列。新截止时间可能早于
+        // 之后创建的会话，直接追加到队尾会打乱顺序，让队头挡住已过期的会话
+        Expiry expiry{it->second.expiresAt, key};
+        auto pos = std::upper_bound(
+            shard.expiries.begin(), shard.expiries.end(), expiry,
+            [](const Expiry& a, const Expiry& b) {
+              return a.deadline < b.deadline;
+            });
+        shard.expiries.insert(pos, expiry);
+      }
+    }
+  }
+
+  std::vector<std::string> offline;
+  for (std::string& username : expired) {
+    if (releaseUser(username)) offline.push_back(std::move(username));
+  }
+  return offline;
+}
+
+size_t SessionStore::size() const {
+  size_t total = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.sessions.size();
+  }
+  return total;
+}
+
+std::optional<std::string_view> SessionStore::tokenFrom(
+    const http::HttpRequest& request) {
+  if (auto auth = request.header("Authorization")) {
+    constexpr std::string_view kBearer = "Bearer ";
+    if (auth->substr(0, kBearer.size()) == kBearer) {
+      return trim(auth->substr(kBearer.size()));
+    }
+  }
+  if (auto cookies = request.header("Cookie")) {
+    std::string_view rest = *cookies;
+    while (!rest.empty()) {
+      size_t end = rest.find(';');
+      std::string_view pair = trim(rest.substr(0, end));
+      rest = end == std::string_view::npos ? std::string_view()
+                                           : rest.substr(end + 1);
+      size_t eq = pair.find('=');
+      if (eq != std::string_view::npos && pair.substr(0, eq) == kCookieName) {
+        return pair.substr(eq + 1);
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<SessionStore::Key> SessionStore::parseToken(
+    std::string_view token) {
+  if (token.size() != kTokenLength) return std::nullopt;
+  Key key{};
+  for (size_t i = 0; i < kTokenLength; ++i) {
+    int value = hexValue(token[i]);
+    if (value < 0) return std::nullopt;
+    uint64_t& half = i < 16 ? key.hi : key.lo;
+    half = (half << 4) | static_cast<uint64_t>(value);
+  }
+  return key;
+}
+
+bool SessionStore::releaseUser(const std::string& username) {
+  std::lock_guard<std::mutex> lock(usersMutex_);
+  auto it = userSessions_.find(username);
+  if (it == userSessions_.end()) return false;
+  if (--it->second > 0) return false;
+  userSessions_.erase(it);
+  return true;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "http/http_request.hpp"
+
+/**
+ * @brief 登录会话表：不透明令牌 -> 用户名，全部在内存中，不访问数据库
+ * 令牌是 128 位随机数的 32 位十六进制串，按高 64 位分到 kShards 个分片，
+ * 低 64 位作分片内的哈希。每个分片一把锁，解析令牌是一次无分配的
+ * 哈希查找。
+ * 过期时间按最后一次访问顺延 ttl；每个分片另有一个按截止时间排列的
+ * 过期队列，sweep() 只检查队头已到期的会话，不遍历整张表。
+ * 线程安全。
+ */
+class SessionStore {
+ public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr size_t kShards = 16;
+  static constexpr size_t kTokenLength = 32;
+  static constexpr std::string_view kCookieName = "chat_session";
+
+  explicit SessionStore(
+      std::chrono::milliseconds ttl = std::chrono::minutes(30));
+
+  SessionStore(const SessionStore&) = delete;
+  SessionStore& operator=(const SessionStore&) = delete;
+
+  // 为用户新建会话，返回令牌
+  std::string create(std::string_view username);
+  // 令牌有效时返回用户名，并把过期时间顺延到 now + ttl
+  std::optional<std::string> resolve(std::string_view token);
+  // 删除会话，返回 true 表示这是该用户的最后一个会话
+  bool remove(std::string_view token);
+  // 删除已过期的会话，返回因此不再有会话的用户
+  std::vector<std::string> sweep();
+
+  size_t size() const;
+
+  // 依次从 Authorization: Bearer 和 Cookie 中取令牌
+  static std::optional<std::string_view> tokenFrom(
+      const http::HttpRequest& request);
+
+ private:
+  struct Key {
+    uint64_t hi;
+    uint64_t lo;
+    bool operator==(const Key& other) const {
+      return hi == other.hi && lo == other.lo;
+    }
+  };
+  // 令牌本身是随机数，直接取低 64 位作哈希
+  struct KeyHash {
+    size_t operator()(const Key& key) const { return key.lo; }
+  };
+  struct Session {
+    std::string username;
+    Clock::time_point expiresAt;
+  };
+  struct Expiry {
+    Clock::time_point deadline;
+    Key key;
+  };
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Session, KeyHash> sessions;
+    std::deque<Expiry> expiries;
+  };
+
+  static std::optional<Key> parseToken(std::string_view token);
+  Shard& shardFor(const Key& key) { return shards_[key.hi % kShards]; }
+  // 用户的会话数减一，返回是否减到 0
+  bool releaseUser(const std::string& username);
+
+  std::chrono::milliseconds ttl_;
+  Shard shards_[kShards];
+  // 每个用户的会话数，只在登录、登出和清理时访问
+  std::mutex usersMutex_;
+  std::unordered_map<std::string, size_t> userSessions_;
+};
@@ -1,26 +1,36 @@
 #pragma once
+#include <memory>
 #include <string>
 
-#include "db/database_manager.hpp"
+#include "chat/chat_service.hpp"
 #include "http/http_server.hpp"
-#include "utils/kafka_producer.hpp"
+#include "http/rate_limiter.hpp"
+#include "http/response_compression.hpp"
+#include "http/static_file_cache.hpp"
 
 class ChatroomServer {
  public:
+  // kafka_brokers 为空时不发送 Kafka 事件
   ChatroomServer(const std::string& static_dir_path,
                  const std::string& db_file_path, int port,
                  const std::string& kafka_brokers = "localhost:9092");
   void startServer();
   void stopServer();
+  void setCompression(const http::CompressionOptions& options) {
+    compression_ = options;
+  }
+  // 在 startServer() 之前调用
+  void setRateLimit(const http::RateLimitOptions& options) {
+    service_->setRateLimit(options);
+  }
 
  private:
   void setupRoutes();
-  http::HttpResponse handleStaticFileRequest(const std::string& dir_path);
 
   int port_;
   std::string staticDirPath_;
-
-  std::unique_ptr<KafkaProducer> kafkaProducer_;
+  std::unique_ptr<http::StaticFileCache> staticCache_;
+  http::CompressionOptions compression_;
+  std::unique_ptr<ChatService> service_;
   std::unique_ptr<http::HttpServer> httpServer_;
-  std::shared_ptr<DatabaseManager> dbManager_;
-};
\ No newline at end of file
+};
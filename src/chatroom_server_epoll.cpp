@@ -3,17 +3,22 @@
 #include <arpa/inet.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <charconv>
 #include <cstring>
-#include <filesystem>
-#include <fstream>
-#include <iostream>
-#include <nlohmann/json.hpp>
-#include <sstream>
 
+#include "http/http_metrics.hpp"
+#include "http/http_request.hpp"
+#include "http/http_response.hpp"
+#include "reactor/task.hpp"
 #include "utils/logger.hpp"
+#include "utils/tracing.hpp"
 
 namespace {
 
@@ -23,60 +28,21 @@ int setNonBlocking(int fd) {
   return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
 }
 
-bool ends_with(const std::string& value, const std::string& ending) {
-  if (ending.size() > value.size()) return false;
-  return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
-}
-
-std::string getContentType(const std::string& path) {
-  if (ends_with(path, ".html") || ends_with(path, ".htm")) return "text/html";
-  if (ends_with(path, ".css")) return "text/css";
-  if (ends_with(path, ".js")) return "application/javascript";
-  if (ends_with(path, ".json")) return "application/json";
-  if (ends_with(path, ".png")) return "image/png";
-  if (ends_with(path, ".jpg") || ends_with(path, ".jpeg")) return "image/jpeg";
-  if (ends_with(path, ".ico")) return "image/x-icon";
-  return "text/plain";
-}
-
-// 简单HTTP请求解析（仅支持单次收包，生产环境需完善）
-bool parseHttpRequest(const std::string& raw, std::string& method,
-                      std::string& path,
-                      std::unordered_map<std::string, std::string>& headers,
-                      std::string& body) {
-  size_t pos = raw.find("\r\n\r\n");
-  if (pos == std::string::npos) return false;
-  std::istringstream iss(raw.substr(0, pos));
-  std::string line;
-  if (!std::getline(iss, line)) return false;
-  std::istringstream reqline(line);
-  reqline >> method >> path;
-  while (std::getline(iss, line)) {
-    if (line.empty() || line == "\r") break;
-    size_t sep = line.find(':');
-    if (sep != std::string::npos) {
-      std::string key = line.substr(0, sep);
-      std::string value = line.substr(sep + 1);
-      while (!value.empty() && (value[0] == ' ' || value[0] == '\t'))
-        value.erase(0, 1);
-      if (!value.empty() && value.back() == '\r') value.pop_back();
-      headers[key] = value;
-    }
-  }
-  body = raw.substr(pos + 4);
-  return true;
-}
+// 连接数已满时直接写给客户端的响应，不创建 channel
+constexpr char kServiceUnavailable[] =
+    "HTTP/1.1 503 Service Unavailable\r\nRetry-After: 1\r\n"
+    "Content-Length: 0\r\nConnection: close\r\n\r\n";
+
+// io_uring 后端发送大文件时每次读出的块大小
+constexpr uint64_t kFileChunk = 64 * 1024;
 
-std::string makeHttpResponse(
-    const std::string& body,
-    const std::string& contentType = "application/json", int status = 200) {
-  std::ostringstream oss;
-  oss << "HTTP/1.1 " << status << " OK\r\n";
-  oss << "Content-Type: " << contentType << "\r\n";
-  oss << "Content-Length: " << body.size() << "\r\n";
-  oss << "Connection: close\r\n\r\n";
-  oss << body;
-  return oss.str();
+// 请求头中的 Content-Length，缺失或非法时为 0
+size_t contentLength(const http::HttpRequest& request) {
+  size_t length = 0;
+  if (auto value = request.header("Content-Length")) {
+    std::from_chars(value->data(), value->data() + value->size(), length);
+  }
+  return length;
 }
 
 }  // namespace
@@ -85,10 +51,16 @@ ChatroomServerEpoll::ChatroomServerEpoll(const std::string& static_dir_path,
                                          const std::string& db_file_path,
                                          int port,
                                          const std::string& kafka_brokers)
-    : staticDirPath_(static_dir_path),
-      dbManager_(std::make_shared<DatabaseManager>(db_file_path)),
-      kafkaProducer_(
-          std::make_unique<KafkaProducer>(kafka_brokers, "chatroom_events")),
+    : ChatroomServerEpoll(
+          std::make_shared<ChatService>(db_file_path, kafka_brokers),
+          static_dir_path, port) {}
+
+ChatroomServerEpoll::ChatroomServerEpoll(std::shared_ptr<ChatService> service,
+                                         const std::string& static_dir_path,
+                                         int port, bool reusePort)
+    : service_(std::move(service)),
+      staticDirPath_(static_dir_path),
+      staticCache_(static_dir_path),
       eventLoop_(std::make_unique<reactor::EventLoop>()),
       listenFd_(-1),
       running_(false) {
@@ -97,6 +69,9 @@ ChatroomServerEpoll::ChatroomServerEpoll(const std::string& static_dir_path,
   setNonBlocking(listenFd_);
   int opt = 1;
   setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+  if (reusePort) {
+    setsockopt(listenFd_, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+  }
   sockaddr_in addr;
   std::memset(&addr, 0, sizeof(addr));
   addr.sin_family = AF_INET;
@@ -110,425 +85,753 @@ ChatroomServerEpoll::ChatroomServerEpoll(const std::string& static_dir_path,
     close(listenFd_);
     throw std::runtime_error("Failed to listen");
   }
+  socklen_t addrLen = sizeof(addr);
+  getsockname(listenFd_, (sockaddr*)&addr, &addrLen);
+  port_ = ntohs(addr.sin_port);
+  deadlineTimerFd_ =
+      timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (deadlineTimerFd_ < 0) {
+    close(listenFd_);
+    throw std::runtime_error("Failed to create timerfd");
+  }
+  reserveFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
   setupRoutes();
-  eventLoop_->setChatroomServerEpoll(this);
-  LOG(INFO) << "Chatroom server initialized on port " << port;
+  eventLoop_->setCleanupCallback([this]() { cleanupPendingChannels(); });
+  LOG(INFO) << "Chatroom server initialized on port " << port_;
+}
+
+ChatroomServerEpoll::~ChatroomServerEpoll() {
+  cleanupPendingChannels();
+  closeServerFds();  // 没有调用过 startServer() 时
+  for (Connection* conn : connections_) {
+    if (!conn) continue;
+    close(conn->fd);
+    if (conn->write.fileFd >= 0) close(conn->write.fileFd);
+    connPool_.destroy(conn);
+  }
+}
+
+bool ChatroomServerEpoll::setIoBackend(reactor::IoBackend backend) {
+  if (backend == eventLoop_->backend()) return true;
+  std::unique_ptr<reactor::EventLoop> loop;
+  try {
+    loop = std::make_unique<reactor::EventLoop>(backend);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "I/O backend unavailable, keeping epoll: " << e.what();
+    return false;
+  }
+  loop->setCleanupCallback([this]() { cleanupPendingChannels(); });
+  eventLoop_ = std::move(loop);
+  return true;
 }
 
 void ChatroomServerEpoll::startServer() {
   running_ = true;
-  auto listenChannel = std::make_shared<reactor::Channel>(listenFd_);
-  listenChannel->setEvents(EPOLLIN);
-  listenChannel->setReadCallback([this]() { handleNewConnection(); });
-  eventLoop_->addChannel(listenChannel);
-  eventLoop_->loop();
+  if (eventLoop_->uring()) {
+    startAccepting();
+  } else {
+    auto listenChannel = std::make_shared<reactor::Channel>(listenFd_);
+    listenChannel->setEvents(EPOLLIN);
+    listenChannel->setReadCallback([this]() { handleNewConnection(); });
+    eventLoop_->addChannel(listenChannel);
+  }
+  auto deadlineChannel = std::make_shared<reactor::Channel>(deadlineTimerFd_);
+  deadlineChannel->setEvents(EPOLLIN);
+  deadlineChannel->setReadCallback([this]() { handleReadDeadlines(); });
+  eventLoop_->addChannel(deadlineChannel);
+  if (roomShards_) roomShards_->attach(shardIndex_, *eventLoop_);
+  service_->start();
+  // quit() 之后通道仍然注册：不再接受新连接，挂起的处理函数完成后
+  // 照常发送响应，没发完的响应继续等 EPOLLOUT，最多等一个读取期限
+  bool stopping = false;
+  std::chrono::steady_clock::time_point flushDeadline;
+  eventLoop_->loop([&]() {
+    if (!stopping) {
+      stopping = true;
+      stopAccepting();
+      flushDeadline =
+          std::chrono::steady_clock::now() + admission_.requestTimeout;
+    }
+    // 数据库和压缩线程池之后不会再向这个循环投递
+    if (pendingHandlers_ > 0) return true;
+    return connectionCount() > 0 &&
+           std::chrono::steady_clock::now() < flushDeadline;
+  });
+  // 到期仍没发完的连接直接关闭
+  for (Connection* conn : connections_) {
+    if (conn) closeClient(conn->fd);
+  }
+  // loop() 已注销信箱的 eventfd，分片的操作在这里直接执行。
+  // runOnce() 同时提交 io_uring 的关闭请求并归还关闭的连接
+  auto drainOnce = [this]() {
+    if (roomShards_) roomShards_->drain(shardIndex_);
+    eventLoop_->runOnce(10);
+  };
+  drainOnce();
+  if (roomShards_) {
+    // 其他循环挂起的处理函数还可能访问本循环的房间
+    roomShards_->detach();
+    while (roomShards_->attached() > 0) drainOnce();
+  }
+  closeServerFds();
 }
 
 void ChatroomServerEpoll::stopServer() {
+  // 可在任意线程（包括信号处理函数）调用，只通知事件循环退出。
+  // 监听、计时器和预留的 fd 仍由事件循环线程使用，退出后再关闭
   running_ = false;
-  if (listenFd_ != -1) {
-    close(listenFd_);
-    listenFd_ = -1;
-  }
+  service_->stop();
   eventLoop_->quit();
   LOG(INFO) << "Chatroom server stopped";
 }
 
+void ChatroomServerEpoll::closeServerFds() {
+  for (int* fd : {&listenFd_, &deadlineTimerFd_, &reserveFd_}) {
+    if (*fd != -1) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+}
+
 void ChatroomServerEpoll::handleNewConnection() {
   while (true) {
     sockaddr_in client_addr;
     socklen_t client_len = sizeof(client_addr);
     int clientFd = accept(listenFd_, (sockaddr*)&client_addr, &client_len);
     if (clientFd < 0) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK)
-        break;
-      else {
-        std::cerr << "accept error: " << strerror(errno) << std::endl;
+      if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+      if (errno == EINTR || errno == ECONNABORTED) continue;
+      // 连接留在监听队列里会让水平触发的监听 fd 一直可读，事件循环空转
+      if (errno == EMFILE || errno == ENFILE) {
+        // 备用描述符也用不上时只能等下次可读事件
+        if (shedWithReserveFd()) continue;
         break;
       }
+      LOG(ERROR) << "accept error: " << strerror(errno);
+      break;
     }
+    if (!admitConnection(clientFd)) continue;
     setNonBlocking(clientFd);
-    auto clientChannel = std::make_shared<reactor::Channel>(clientFd);
-    clientChannel->setEvents(EPOLLIN | EPOLLET);
-    clientChannel->setReadCallback(
-        [this, clientFd]() { handleClientEvent(clientFd); });
-    clientChannels_[clientFd] = clientChannel;
-    eventLoop_->addChannel(clientChannel);
+    Connection* conn = openConnection(clientFd, client_addr.sin_addr.s_addr);
+    conn->channel.setEvents(EPOLLIN | EPOLLET);
+    // 只捕获两个指针，std::function 直接存在对象内，不另外分配
+    conn->channel.setReadCallback([this, conn]() { handleClientEvent(conn); });
+    eventLoop_->addChannel(&conn->channel);
     LOG(INFO) << "New client connected: " << inet_ntoa(client_addr.sin_addr)
               << ":" << ntohs(client_addr.sin_port);
   }
 }
 
-ChatroomServerEpoll::StaticFileResult ChatroomServerEpoll::handleStaticFile(
-    const std::string& path) {
-  std::string requestedFile = path;
-  if (requestedFile == "/" || requestedFile.empty()) {
-    requestedFile = "/login.html";
+bool ChatroomServerEpoll::admitConnection(int clientFd) {
+  if (connectionCount() < admission_.maxConnections) return true;
+  // 尽力回一个 503，发不出去也直接关闭
+  send(clientFd, kServiceUnavailable, sizeof(kServiceUnavailable) - 1,
+       MSG_DONTWAIT | MSG_NOSIGNAL);
+  close(clientFd);
+  ++admissionStats_.rejectedMaxConnections;
+  return false;
+}
+
+ChatroomServerEpoll::Connection* ChatroomServerEpoll::openConnection(
+    int clientFd, uint32_t clientIp) {
+  Connection* conn = connPool_.create(clientFd, clientIp);
+  if (static_cast<size_t>(clientFd) >= connections_.size()) {
+    connections_.resize(clientFd + 1);
+  }
+  connections_[clientFd] = conn;
+  // 期限都相同，接在表尾仍按到期先后排列
+  conn->deadline = std::chrono::steady_clock::now() + admission_.requestTimeout;
+  conn->prevReading = readingTail_;
+  if (readingTail_) {
+    readingTail_->nextReading = conn;
+  } else {
+    readingHead_ = conn;
+  }
+  readingTail_ = conn;
+  if (readingHead_ == conn) armDeadlineTimer();
+  ++admissionStats_.accepted;
+  return conn;
+}
+
+void ChatroomServerEpoll::stopReading(Connection* conn) {
+  if (!conn->reading) return;
+  conn->reading = false;
+  if (conn->prevReading) {
+    conn->prevReading->nextReading = conn->nextReading;
+  } else {
+    readingHead_ = conn->nextReading;
+  }
+  if (conn->nextReading) {
+    conn->nextReading->prevReading = conn->prevReading;
+  } else {
+    readingTail_ = conn->prevReading;
+  }
+  conn->prevReading = conn->nextReading = nullptr;
+  conn->readBuffer.clear();
+}
+
+void ChatroomServerEpoll::startAccepting() {
+  acceptToken_ = eventLoop_->uring()->acceptMultishot(
+      listenFd_, [this](int res) { handleAccepted(res); });
+}
+
+void ChatroomServerEpoll::stopAccepting() {
+  if (reactor::IoUring* uring = eventLoop_->uring()) {
+    uring->cancel(acceptToken_);
+  } else {
+    eventLoop_->removeChannel(listenFd_);
   }
-  std::filesystem::path full_path =
-      std::filesystem::path(staticDirPath_) / requestedFile.substr(1);
-  if (!std::filesystem::exists(full_path)) {
-    return {"<html><body><h1>404 Not Found</h1><p>File not found: " +
-                requestedFile + "</p></body></html>",
-            "text/html"};
+  // 还没收齐请求的连接不会再有响应要发
+  while (readingHead_) closeClient(readingHead_->fd);
+}
+
+void ChatroomServerEpoll::handleAccepted(int res) {
+  if (!running_) {
+    // stopServer() 之后内核仍可能接受连接，直接关闭
+    if (res >= 0) close(res);
+    return;
   }
-  std::ifstream file(full_path, std::ios::binary);
-  if (!file) {
-    return {
-        "<html><body><h1>500 Internal Server Error</h1><p>Failed to read "
-        "file</p></body></html>",
-        "text/html"};
+  if (res < 0) {
+    if (res == -EMFILE || res == -ENFILE) {
+      // 把监听队列里的连接都拒掉再重新提交，否则会立即再次失败
+      errno = -res;
+      while (shedWithReserveFd()) {
+      }
+    } else {
+      LOG(ERROR) << "accept error: " << strerror(-res);
+    }
+    startAccepting();  // multishot accept 出错后已终止
+    return;
+  }
+  int clientFd = res;
+  if (!admitConnection(clientFd)) return;
+  // 地址只在按 IP 限流时需要，不限流时省掉这次系统调用
+  uint32_t clientIp = 0;
+  if (service_->rateLimiter()) {
+    sockaddr_in addr{};
+    socklen_t addrLen = sizeof(addr);
+    if (getpeername(clientFd, (sockaddr*)&addr, &addrLen) == 0) {
+      clientIp = addr.sin_addr.s_addr;
+    }
+  }
+  Connection* conn = openConnection(clientFd, clientIp);
+  // 关闭连接时先取消 recv，之后不再回调，conn 在回调里一直有效
+  conn->recvToken = eventLoop_->uring()->recvMultishot(
+      clientFd, [this, conn](int n, const char* data) {
+        if (n > 0) {
+          handleClientData(conn, std::string_view(data, n));
+        } else if (conn->reading) {
+          // 请求已收齐时由发送完成后关闭
+          closeClient(conn->fd);
+        }
+      });
+  LOG(INFO) << "New client connected: " << clientFd;
+}
+
+bool ChatroomServerEpoll::shedWithReserveFd() {
+  if (reserveFd_ < 0) {
+    LOG(ERROR) << "accept error: " << strerror(errno);
+    return false;
   }
-  std::ostringstream ss;
-  ss << file.rdbuf();
-  LOG(INFO) << "Serving static file: " << requestedFile;
-  return {ss.str(), getContentType(requestedFile)};
+  close(reserveFd_);
+  int fd = accept(listenFd_, nullptr, nullptr);
+  if (fd >= 0) close(fd);
+  reserveFd_ = open("/dev/null", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  ++admissionStats_.rejectedNoFd;
+  LOG(WARN) << "Out of file descriptors, connection dropped";
+  return true;
 }
 
-void ChatroomServerEpoll::handleClientEvent(int clientFd) {
+void ChatroomServerEpoll::armDeadlineTimer() {
+  itimerspec spec{};
+  if (readingHead_) {
+    auto delay = readingHead_->deadline - std::chrono::steady_clock::now();
+    // 已经到期时也要设一个非零值，零表示停止计时器
+    auto ns = std::max<int64_t>(
+        1, std::chrono::duration_cast<std::chrono::nanoseconds>(delay)
+               .count());
+    spec.it_value.tv_sec = ns / 1000000000;
+    spec.it_value.tv_nsec = ns % 1000000000;
+  }
+  timerfd_settime(deadlineTimerFd_, 0, &spec, nullptr);
+}
+
+void ChatroomServerEpoll::handleReadDeadlines() {
+  uint64_t expirations;
+  while (read(deadlineTimerFd_, &expirations, sizeof(expirations)) > 0) {
+  }
+  auto now = std::chrono::steady_clock::now();
+  // closeClient() 把表头移出链表
+  while (readingHead_ && readingHead_->deadline <= now) {
+    LOG(WARN) << "Request not received in time, closing: "
+              << readingHead_->fd;
+    ++admissionStats_.requestTimeouts;
+    closeClient(readingHead_->fd);
+  }
+  armDeadlineTimer();
+}
+
+void ChatroomServerEpoll::handleClientEvent(Connection* conn) {
+  // 请求已经收齐（正在压缩或发送响应）时不再读
+  if (!conn->reading) return;
+  int clientFd = conn->fd;
+
+  // 收包、解析、处理和响应都从本线程的 arena 分配，处理完整体回收
+  utils::ArenaScope arena(utils::threadArena());
+  utils::TraceRequest trace("handleClientEvent");
   char buf[8192];
-  std::string request;
+  utils::ArenaString request(conn->readBuffer.data(), conn->readBuffer.size());
+  utils::TraceSpan recvSpan("recv", "http");
   while (true) {
     ssize_t n = recv(clientFd, buf, sizeof(buf), 0);
     if (n > 0) {
       request.append(buf, n);
       if (n < (ssize_t)sizeof(buf)) break;  // 简单处理：假设一次收完
     } else if (n == 0) {
-      eventLoop_->removeChannel(clientFd);
-      pendingDeleteFds_.push_back(clientFd);
+      closeClient(clientFd);
       return;
     } else {
       if (errno == EAGAIN || errno == EWOULDBLOCK) break;
-      eventLoop_->removeChannel(clientFd);
-      pendingDeleteFds_.push_back(clientFd);
+      closeClient(clientFd);
       return;
     }
   }
+  recvSpan.end();
+  processRequest(conn, request);
+}
 
-  // 解析HTTP请求
-  std::string method, path, body;
-  std::unordered_map<std::string, std::string> headers;
-  if (!parseHttpRequest(request, method, path, headers, body)) {
-    std::string resp = makeHttpResponse("{\"error\":\"Bad Request\"}",
-                                        "application/json", 400);
-    send(clientFd, resp.data(), resp.size(), 0);
-    eventLoop_->removeChannel(clientFd);
-    pendingDeleteFds_.push_back(clientFd);
+void ChatroomServerEpoll::handleClientData(Connection* conn,
+                                           std::string_view data) {
+  // 请求收齐之后到达的数据丢弃
+  if (!conn->reading) return;
+
+  utils::ArenaScope arena(utils::threadArena());
+  utils::TraceRequest trace("handleClientData");
+  utils::ArenaString request(conn->readBuffer.data(), conn->readBuffer.size());
+  request.append(data.data(), data.size());
+  processRequest(conn, request);
+}
+
+void ChatroomServerEpoll::processRequest(Connection* conn,
+                                         utils::ArenaString& request) {
+  int clientFd = conn->fd;
+  uint32_t clientIp = conn->ip;
+  // 头部或请求体没收齐时先存起来，等后续数据或期限到达
+  size_t headersEnd = request.find("\r\n\r\n");
+  bool headersComplete = headersEnd != utils::ArenaString::npos;
+  if (!headersComplete && request.size() <= admission_.maxRequestBytes) {
+    conn->readBuffer.assign(request.data(), request.size());
+    return;
+  }
+  utils::TraceSpan parseSpan("parse", "http");
+  http::HttpRequest httpRequest = http::HttpRequest::parse(request);
+  parseSpan.end();
+  size_t expectedBody = headersComplete ? contentLength(httpRequest) : 0;
+  if (!headersComplete || expectedBody > admission_.maxRequestBytes) {
+    ++admissionStats_.oversizedRequests;
+    stopReading(conn);
+    http::HttpResponse response(413, "{\"error\":\"Request too large\"}");
+    sendResponse(clientFd, response);
+    return;
+  }
+  // 按收到的字节数判断，解析出的请求体会去掉末尾的 '\r'
+  if (request.size() - (headersEnd + 4) < expectedBody) {
+    conn->readBuffer.assign(request.data(), request.size());
     return;
   }
-  LOG(INFO) << "Received request: " << method << " " << path;
-
-  // 路由分发
-  std::string respBody;
-  std::string contentType = "application/json";
-  bool isStatic = false;
-
-  auto mit = handlers_.find(method);
-  if (mit != handlers_.end()) {
-    auto pit = mit->second.find(path);
-    if (pit != mit->second.end()) {
-      respBody = pit->second(body, headers);
-    } else if (method == "GET") {
-      auto staticResult = handleStaticFile(path);
-      respBody = staticResult.content;
-      contentType = staticResult.contentType;
-      isStatic = true;
+  stopReading(conn);
+  LOG(INFO) << "Received request: " << httpRequest.method() << " "
+            << httpRequest.path();
+
+  // 按 IP 限流在分发之前，被拒绝的请求不解析请求体、不访问数据库
+  if (http::RateLimiter* limiter = service_->rateLimiter()) {
+    uint32_t retryAfter = limiter->acquireForIp(
+        clientIp, httpRequest.method(), httpRequest.path());
+    if (retryAfter) {
+      LOG(WARN) << "Rate limited: " << httpRequest.method() << " "
+                << httpRequest.path();
+      http::HttpResponse response = http::tooManyRequests(retryAfter);
+      sendResponse(clientFd, response);
+      return;
     }
-  } else if (method == "GET") {
-    auto staticResult = handleStaticFile(path);
-    respBody = staticResult.content;
-    contentType = staticResult.contentType;
-    isStatic = true;
-  } else {
-    respBody = "{\"error\":\"Not found\"}";
   }
 
-  std::string resp = makeHttpResponse(respBody, contentType);
-  send(clientFd, resp.data(), resp.size(), 0);
-  LOG(INFO) << "Sent response: " << contentType;
-
-  // 短连接，直接关闭
-  eventLoop_->removeChannel(clientFd);
-  pendingDeleteFds_.push_back(clientFd);
-  LOG(INFO) << "Client disconnected: " << clientFd;
+  // 路由分发，未注册的 GET 请求交给静态资源缓存
+  if (const Handler* handler = findHandler(httpRequest)) {
+    runHandler(conn, static_cast<size_t>(handler - handlers_.data()),
+               httpRequest);
+    return;
+  }
+  http::HttpResponse response;
+  if (httpRequest.method() == "GET" && httpRequest.path() == "/metrics") {
+    response = metricsResponse();
+  } else if (httpRequest.method() == "GET") {
+    response = staticCache_.respond(httpRequest);
+  } else {
+    response.setStatus(404);
+    response.setHeader("Content-Type", "application/json");
+    response.setBody("{\"error\":\"Not found\"}");
+  }
+  respond(clientFd, httpRequest.header("Accept-Encoding"), response);
 }
 
-void ChatroomServerEpoll::setupRoutes() {
-  // 静态文件路由已在 handleClientEvent 兜底处理
-
-  // 注册
-  registerHandler(
-      "POST", "/register", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("username") || !data.contains("password"))
-            return std::string("{\"error\":\"Missing username or password\"}");
-          std::string username = data["username"];
-          std::string password = data["password"];
-          if (dbManager_->validateUser(username, password)) {
-            LOG(WARN) << "User already exists: " << username;
-            return std::string("{\"error\":\"Username already exists\"}");
-          }
-          if (dbManager_->createUser(username, password)) {
-            {
-              LOG(INFO) << "User registered: " << username;
-              return std::string("{\"status\":\"success\"}");
-            }
-          }
-          LOG(ERROR) << "Failed to create user: " << username;
-          return std::string("{\"error\":\"Internal server error\"}");
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse registration request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
+void ChatroomServerEpoll::runHandler(Connection* conn, size_t index,
+                                     const http::HttpRequest& request) {
+  // 压缩协商在处理函数完成后进行，那时请求报文可能已经释放
+  std::optional<std::string> acceptEncoding;
+  if (compression_.enabled) {
+    if (auto value = request.header("Accept-Encoding")) {
+      acceptEncoding.emplace(*value);
+    }
+  }
+  // 处理函数等待数据库时挂起，完成后在本循环上恢复并发送响应。挂起
+  // 期间连接已停止读，fd 一直保持打开，conn 不会被释放
+  conn->handling = true;
+  ++pendingHandlers_;
+  // 处理函数可能挂起，"handler" 阶段到完成时才结束，按起止时间记录。
+  // 恢复后 Offload 和 RoomCall 带回了当前请求，之后的阶段照常记录
+  uint64_t traceId = utils::trace_detail::activeRequest;
+  uint64_t traceStart = traceId ? utils::trace_detail::nowNanos() : 0;
+  reactor::spawn(
+      handlers_[index](request),
+      [this, conn, latency = handlerLatency_[index],
+       start = std::chrono::steady_clock::now(), traceId, traceStart,
+       acceptEncoding = std::move(acceptEncoding)](
+          http::HttpResponse response) {
+        latency.record(std::chrono::steady_clock::now() - start);
+        if (traceId) {
+          utils::TraceScope trace(traceId);
+          utils::trace_detail::record("handler", "http", traceStart,
+                                      utils::trace_detail::nowNanos());
         }
+        conn->handling = false;
+        --pendingHandlers_;
+        respond(conn->fd, acceptEncoding, response);
       });
+}
 
-  // 登录
-  registerHandler(
-      "POST", "/login", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("username") || !data.contains("password"))
-            return std::string("{\"error\":\"Missing username or password\"}");
-          std::string username = data["username"];
-          std::string password = data["password"];
-          if (dbManager_->validateUser(username, password)) {
-            dbManager_->setUserOnlineStatus(username, true);
-            dbManager_->setUserLastActiveTime(username);
-
-            // 添加Kafka事件
-            nlohmann::json kafka_event = {
-                {"username", username},
-                {"action", "login"},
-                {"timestamp",
-                 std::chrono::duration_cast<std::chrono::milliseconds>(
-                     std::chrono::system_clock::now().time_since_epoch())
-                     .count()},
-                {"type", "user_event"}};
-            if (kafkaProducer_->send(kafka_event.dump())) {
-              LOG(INFO) << "Kafka send success: " << kafka_event.dump();
-            } else {
-              LOG(ERROR) << "Kafka send failed: " << kafka_event.dump();
-            }
-
-            nlohmann::json resp = {{"status", "success"},
-                                   {"username", username}};
-            LOG(INFO) << "User logged in: " << username;
-            return resp.dump();
-          } else {
-            LOG(WARN) << "Invalid login attempt for user: " << username;
-            return std::string("{\"error\":\"Invalid username or password\"}");
-          }
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse login request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+void ChatroomServerEpoll::respond(
+    int clientFd, std::optional<std::string_view> acceptEncoding,
+    http::HttpResponse& response) {
+  if (compressPool_) {
+    utils::ContentEncoding encoding =
+        http::chooseEncoding(acceptEncoding, response, compression_);
+    if (encoding != utils::ContentEncoding::Identity) {
+      compressInPool(clientFd, response, encoding);
+      return;
+    }
+  } else {
+    utils::TraceSpan span("compress", "http");
+    http::compressResponse(acceptEncoding, response, compression_);
+  }
 
-  // 创建房间
-  registerHandler(
-      "POST", "/create_room", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("name") || !data.contains("creator"))
-            return std::string("{\"error\":\"Missing room name or creator\"}");
-          std::string room_name = data["name"];
-          std::string creator = data["creator"];
-          if (dbManager_->createRoom(room_name, creator)) {
-            if (dbManager_->addUserToRoom(room_name, creator)) {
-              LOG(INFO) << "Room created: " << room_name
-                        << " by user: " << creator;
-              nlohmann::json kafka_event = {
-                  {"room", room_name},
-                  {"creator", creator},
-                  {"action", "create_room"},
-                  {"timestamp",
-                   std::chrono::duration_cast<std::chrono::milliseconds>(
-                       std::chrono::system_clock::now().time_since_epoch())
-                       .count()},
-                  {"type", "room_event"}};
-              if (kafkaProducer_->send(kafka_event.dump())) {
-                LOG(INFO) << "Kafka send success: " << kafka_event.dump();
-              } else {
-                LOG(ERROR) << "Kafka send failed: " << kafka_event.dump();
-              }
-              return std::string("{\"status\":\"success\"}");
-            }
-          }
-          LOG(ERROR) << "Failed to create room: " << room_name;
-          return std::string("{\"error\":\"Failed to create room\"}");
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse create room request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+  LOG(INFO) << "Sending response: " << response.statusCode();
+  sendResponse(clientFd, response);
+}
 
-  // 加入房间
-  registerHandler(
-      "POST", "/join_room", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("room") || !data.contains("username"))
-            return std::string("{\"error\":\"Missing room or username\"}");
-          std::string room_name = data["room"];
-          std::string username = data["username"];
-          if (dbManager_->addUserToRoom(room_name, username)) {
-            LOG(INFO) << "User joined room: " << username << " -> "
-                      << room_name;
-            return std::string("{\"status\":\"success\"}");
-          } else {
-            LOG(WARN) << "Room not found: " << room_name;
-            return std::string("{\"error\":\"Room not found\"}");
-          }
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse join room request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+void ChatroomServerEpoll::setCompression(
+    const http::CompressionOptions& options) {
+  compression_ = options;
+  compressPool_.reset();
+  if (options.enabled && options.workerThreads > 0) {
+    compressPool_ =
+        std::make_unique<utils::ThreadPool>(options.workerThreads, "compress");
+  }
+}
 
-  // 获取房间列表
-  registerHandler("GET", "/rooms", [this](const std::string&, const auto&) {
-    auto rooms = dbManager_->getRooms();
-    nlohmann::json response = nlohmann::json::array();
-    for (const auto& room : rooms) {
-      nlohmann::json room_info = {{"name", room},
-                                  {"members", dbManager_->getRoomUsers(room)}};
-      response.push_back(room_info);
+void ChatroomServerEpoll::compressInPool(int clientFd,
+                                         const http::HttpResponse& response,
+                                         utils::ContentEncoding encoding) {
+  // 压缩完成前不再读这个连接，fd 也一直保持打开，不会被新连接复用。
+  // io_uring 后端收到的数据在请求收齐后直接丢弃，不用改回调
+  Connection* conn = connection(clientFd);
+  if (!conn) return;
+  if (!eventLoop_->uring()) conn->channel.setReadCallback(nullptr);
+
+  // 响应在 arena 中，头部和响应体都拷贝出来交给压缩线程
+  int status = response.statusCode();
+  std::vector<std::pair<std::string, std::string>> headers;
+  headers.reserve(response.headers().size());
+  for (const auto& header : response.headers()) {
+    headers.emplace_back(header.first, header.second);
+  }
+  std::string body(response.body());
+  int level = compression_.levelFor(encoding);
+  // 发送之前都算作挂起，退出时等它完成
+  ++pendingHandlers_;
+  uint64_t traceId = utils::trace_detail::activeRequest;
+  compressPool_->enqueue([this, clientFd, status, encoding, level, traceId,
+                          headers = std::move(headers),
+                          body = std::move(body)]() mutable {
+    std::string compressed;
+    bool ok;
+    {
+      utils::TraceScope trace(traceId);
+      utils::TraceSpan span("compress", "http");
+      ok = utils::compressTo(encoding, body, level, compressed) &&
+           compressed.size() < body.size();
     }
-    LOG(INFO) << "Room list retrieved";
-    return response.dump();
+    eventLoop_->queueInLoop([this, clientFd, status, encoding, ok, traceId,
+                             headers = std::move(headers),
+                             body = ok ? std::move(compressed)
+                                       : std::move(body)]() {
+      utils::ArenaScope arena(utils::threadArena());
+      utils::TraceScope trace(traceId);
+      --pendingHandlers_;
+      http::HttpResponse response(status);
+      for (const auto& [key, value] : headers) response.setHeader(key, value);
+      if (ok) {
+        response.setHeader("Content-Encoding",
+                           utils::contentEncodingName(encoding));
+        response.setHeader("Vary", "Accept-Encoding");
+      }
+      response.setBody(body);
+      LOG(INFO) << "Sending compressed response: " << status;
+      sendResponse(clientFd, response);
+    });
   });
+}
 
-  // 发送消息
-  registerHandler(
-      "POST", "/send_message", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("room") || !data.contains("username") ||
-              !data.contains("content"))
-            return std::string("{\"error\":\"Missing required fields\"}");
-          std::string room_name = data["room"];
-          std::string username = data["username"];
-          std::string content = data["content"];
-          int64_t timestamp =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  std::chrono::system_clock::now().time_since_epoch())
-                  .count();
-          dbManager_->checkAndUpdateInactiveUsers(username);
-          if (dbManager_->saveMessage(room_name, username, content,
-                                      timestamp)) {
-            LOG(INFO) << "Message sent in room: " << room_name
-                      << " from user: " << username;
-
-            // Kafka 消息发送
-            nlohmann::json kafka_message = {{"room", room_name},
-                                            {"username", username},
-                                            {"content", content},
-                                            {"timestamp", timestamp},
-                                            {"type", "chat_message"}};
-            if (kafkaProducer_->send(kafka_message.dump())) {
-              LOG(INFO) << "Kafka send success: " << kafka_message.dump();
-            } else {
-              LOG(ERROR) << "Kafka send failed: " << kafka_message.dump();
-            }
-
-            return std::string("{\"status\":\"success\"}");
-          } else {
-            LOG(ERROR) << "Failed to save message in room: " << room_name
-                       << " from user: " << username;
-            return std::string("{\"error\":\"Failed to save message\"}");
-          }
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse send message request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+void ChatroomServerEpoll::sendResponse(int clientFd,
+                                       http::HttpResponse& response) {
+  // 短连接：头部在当前 arena 中生成，和响应体一起 sendmsg 直接发送，
+  // 发不完的部分才拷贝出来等 EPOLLOUT 继续
+  utils::TraceSpan span("send", "http");
+  http::countResponse(response.statusCode());
+  response.setHeader("Connection", "close");
+  response.setHeader("Date", http::httpDate());
+  utils::ArenaString head = response.serializeHeaders();
+  std::string_view body = response.body();
+  PendingWrite pending;
+  if (const auto& file = response.fileBody()) {
+    pending.fileFd = open(file->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (pending.fileFd < 0) {
+      LOG(ERROR) << "Failed to open static file: " << file->path;
+      closeClient(clientFd);
+      return;
+    }
+    pending.fileOffset = static_cast<off_t>(file->offset);
+    pending.fileRemaining = file->length;
+  }
 
-  // 获取消息
-  registerHandler(
-      "POST", "/messages", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (data.contains("username")) {
-            dbManager_->checkAndUpdateInactiveUsers(data["username"]);
-          }
-          if (!data.contains("room") || !data.contains("since"))
-            return std::string("{\"error\":\"Missing required fields\"}");
-          std::string room_name = data["room"];
-          int64_t since =
-              data["since"].is_null() ? 0 : data["since"].get<int64_t>();
-          auto messages = dbManager_->getRoomMessages(room_name, since);
-          if (data.contains("username")) {
-            dbManager_->setUserLastActiveTime(data["username"]);
-          }
-          nlohmann::json resp_json = messages;
-          LOG(INFO) << "Retrieved messages for room: " << room_name;
-          return resp_json.dump();
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse get messages request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+  if (reactor::IoUring* uring = eventLoop_->uring()) {
+    // 请求完成前内核一直读发送缓冲区，所以拷贝出 arena。
+    // 发送和随后的关闭都和其他请求一起批量提交
+    Connection* conn = connection(clientFd);
+    if (!conn) {
+      if (pending.fileFd >= 0) close(pending.fileFd);
+      return;
+    }
+    std::string data;
+    if (pending.fileFd >= 0) conn->write = std::move(pending);
+    auto onSent = [this, clientFd](int res) {
+      handleUringSent(clientFd, res);
+    };
+    // 共享的响应体只增加引用，内核直接从它读取
+    if (!response.sharedBody().empty()) {
+      data.assign(head.data(), head.size());
+      uring->sendAll(clientFd, std::move(data), response.sharedBody(),
+                     onSent);
+      return;
+    }
+    data.reserve(head.size() + body.size());
+    data.append(head.data(), head.size());
+    data.append(body);
+    uring->sendAll(clientFd, std::move(data), onSent);
+    return;
+  }
 
-  // 获取用户列表
-  registerHandler("GET", "/users", [this](const std::string&, const auto&) {
-    auto users = dbManager_->getAllUsers();
-    nlohmann::json response = nlohmann::json::array();
-    for (const auto& user : users) {
-      nlohmann::json user_info = {{"username", user.userName},
-                                  {"is_online", user.isOnline}};
-      response.push_back(user_info);
+  iovec iov[2] = {{head.data(), head.size()},
+                  {const_cast<char*>(body.data()), body.size()}};
+  msghdr msg{};
+  msg.msg_iov = iov;
+  msg.msg_iovlen = body.empty() ? 1 : 2;
+  ssize_t n = sendmsg(clientFd, &msg, MSG_NOSIGNAL);
+  bool failed = n < 0 && errno != EAGAIN && errno != EWOULDBLOCK;
+  size_t sent = n > 0 ? static_cast<size_t>(n) : 0;
+  if (!response.sharedBody().empty() && sent < head.size() + body.size()) {
+    // 剩下的响应体引用共享缓冲区，不复制
+    pending.shared = response.sharedBody();
+    if (sent < head.size()) {
+      pending.buffer.assign(head.data() + sent, head.size() - sent);
+    } else {
+      pending.sent = sent - head.size();
     }
-    LOG(INFO) << "User list retrieved";
-    return response.dump();
-  });
+  } else if (sent < head.size()) {
+    pending.buffer.assign(head.data() + sent, head.size() - sent);
+    pending.buffer.append(body);
+  } else {
+    pending.buffer.assign(body.substr(sent - head.size()));
+  }
+  if (failed || flushPendingWrite(clientFd, pending)) {
+    if (pending.fileFd >= 0) close(pending.fileFd);
+    closeClient(clientFd);
+    return;
+  }
 
-  // 登出
-  registerHandler(
-      "POST", "/logout", [this](const std::string& body, const auto&) {
-        try {
-          auto data = nlohmann::json::parse(body);
-          if (!data.contains("username"))
-            return std::string("{\"error\":\"Missing username\"}");
-          std::string username = data["username"];
-          if (dbManager_->setUserOnlineStatus(username, false)) {
-            LOG(INFO) << "User logged out: " << username;
-            return std::string("{\"status\":\"success\"}");
-          } else {
-            LOG(ERROR) << "Failed to log out user: " << username;
-            return std::string("{\"error\":\"Internal server error\"}");
-          }
-        } catch (...) {
-          LOG(ERROR) << "Failed to parse logout request";
-          return std::string("{\"error\":\"Invalid JSON\"}");
-        }
-      });
+  Connection* conn = connection(clientFd);
+  if (!conn) {
+    if (pending.fileFd >= 0) close(pending.fileFd);
+    return;
+  }
+  reactor::Channel& channel = conn->channel;
+  channel.setEvents(EPOLLOUT | EPOLLET);
+  channel.setReadCallback(nullptr);
+  channel.setWriteCallback(
+      [this, clientFd]() { handleClientWritable(clientFd); });
+  channel.setCloseCallback([this, clientFd]() { closeClient(clientFd); });
+  channel.setErrorCallback([this, clientFd]() { closeClient(clientFd); });
+  conn->write = std::move(pending);
+  eventLoop_->updateChannel(&channel);
+}
+
+bool ChatroomServerEpoll::flushPendingWrite(int clientFd,
+                                            PendingWrite& pending) {
+  size_t total = pending.buffer.size() + pending.shared.size();
+  while (pending.sent < total) {
+    iovec iov[2];
+    size_t count = 0;
+    size_t buffered = pending.buffer.size();
+    if (pending.sent < buffered) {
+      iov[count++] = {pending.buffer.data() + pending.sent,
+                      buffered - pending.sent};
+    }
+    size_t sharedSent = pending.sent > buffered ? pending.sent - buffered : 0;
+    if (sharedSent < pending.shared.size()) {
+      iov[count++] = {const_cast<char*>(pending.shared.data()) + sharedSent,
+                      pending.shared.size() - sharedSent};
+    }
+    msghdr msg{};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    ssize_t n = sendmsg(clientFd, &msg, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno != EAGAIN && errno != EWOULDBLOCK;
+    }
+    pending.sent += n;
+  }
+  // 文件内容由内核直接从页缓存写入 socket
+  while (pending.fileRemaining > 0) {
+    ssize_t n = sendfile(clientFd, pending.fileFd, &pending.fileOffset,
+                         pending.fileRemaining);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return errno != EAGAIN && errno != EWOULDBLOCK;
+    }
+    if (n == 0) return true;  // 文件在发送过程中被截断
+    pending.fileRemaining -= n;
+  }
+  return true;
+}
+
+void ChatroomServerEpoll::handleClientWritable(int clientFd) {
+  Connection* conn = connection(clientFd);
+  if (!conn) return;
+  if (flushPendingWrite(clientFd, conn->write)) closeClient(clientFd);
+}
+
+void ChatroomServerEpoll::handleUringSent(int clientFd, int res) {
+  Connection* conn = connection(clientFd);
+  if (res >= 0 && conn && conn->write.fileRemaining > 0) {
+    // 没有缓存在内存里的大文件：按块读出后继续发送
+    PendingWrite& pending = conn->write;
+    std::string chunk(std::min<uint64_t>(pending.fileRemaining, kFileChunk),
+                      '\0');
+    ssize_t n =
+        pread(pending.fileFd, chunk.data(), chunk.size(), pending.fileOffset);
+    if (n > 0) {
+      chunk.resize(n);
+      pending.fileOffset += n;
+      pending.fileRemaining -= n;
+      eventLoop_->uring()->sendAll(
+          clientFd, std::move(chunk),
+          [this, clientFd](int res) { handleUringSent(clientFd, res); });
+      return;
+    }
+  }
+  closeClient(clientFd);
+}
+
+void ChatroomServerEpoll::closeClient(int clientFd) {
+  Connection* conn = connection(clientFd);
+  if (!conn) return;
+  if (conn->write.fileFd >= 0) {
+    close(conn->write.fileFd);
+    conn->write.fileFd = -1;
+  }
+  stopReading(conn);
+  connections_[clientFd] = nullptr;
+  closed_.push_back(conn);
+  if (reactor::IoUring* uring = eventLoop_->uring()) {
+    // 取消 recv 后由 io_uring 关闭，fd 只关一次
+    uring->cancel(conn->recvToken);
+    uring->close(clientFd);
+  } else {
+    // fd 留到本轮结束再关，之前不会被新连接复用
+    eventLoop_->removeChannel(clientFd);
+  }
+  LOG(INFO) << "Client disconnected: " << clientFd;
+}
+
+http::HttpResponse ChatroomServerEpoll::metricsResponse() const {
+  std::string extra;
+  utils::appendMetric(extra, "chat_connections", "gauge",
+                      "Open client connections", connectionCount());
+  utils::appendMetric(extra, "chat_pending_handlers", "gauge",
+                      "Handlers and compressions yet to send a response",
+                      pendingHandlers_);
+  const AdmissionStats& stats = admissionStats_;
+  utils::appendMetric(extra, "connections_accepted_total", "counter",
+                      "Connections accepted", stats.accepted);
+  utils::appendMetric(extra, "connections_rejected_max_total", "counter",
+                      "Connections refused at the connection cap",
+                      stats.rejectedMaxConnections);
+  utils::appendMetric(extra, "connections_rejected_nofd_total", "counter",
+                      "Connections dropped for lack of file descriptors",
+                      stats.rejectedNoFd);
+  utils::appendMetric(extra, "request_timeouts_total", "counter",
+                      "Connections closed before a full request arrived",
+                      stats.requestTimeouts);
+  utils::appendMetric(extra, "requests_oversized_total", "counter",
+                      "Requests rejected with 413", stats.oversizedRequests);
+  service_->appendMetrics(extra);
+  return http::metricsResponse(extra);
+}
+
+void ChatroomServerEpoll::setupRoutes() {
+  // 静态文件和 /metrics 在 processRequest 中兜底处理
+  service_->mount([this](const std::string& method, const std::string& path,
+                         Handler handler) {
+    registerHandler(method, path, std::move(handler));
+  });
 }
 
 void ChatroomServerEpoll::cleanupPendingChannels() {
-  for (int fd : pendingDeleteFds_) {
-    clientChannels_.erase(fd);
-    close(fd);
+  // 本轮回调都已执行完，关闭的连接可以归还连接池
+  for (Connection* conn : closed_) {
+    if (!eventLoop_->uring()) close(conn->fd);
+    connPool_.destroy(conn);
   }
-  pendingDeleteFds_.clear();
+  closed_.clear();
 }
 
 void ChatroomServerEpoll::registerHandler(const std::string& method,
                                           const std::string& path,
                                           Handler handler) {
-  handlers_[method][path] = handler;
-}
-
-std::string ChatroomServerEpoll::dispatch(
-    const std::string& method, const std::string& path, const std::string& body,
-    const std::unordered_map<std::string, std::string>& headers) {
-  auto mit = handlers_.find(method);
-  if (mit != handlers_.end()) {
-    auto pit = mit->second.find(path);
-    if (pit != mit->second.end()) {
-      LOG(INFO) << "Dispatching request: " << method << " " << path;
-      return pit->second(body, headers);
-    }
-  }
-  return "";
+  router_.add(http::parseMethod(method), path, handlers_.size());
+  handlers_.push_back(std::move(handler));
+  handlerLatency_.push_back(http::routeLatency(method, path));
+}
+
+const ChatroomServerEpoll::Handler* ChatroomServerEpoll::findHandler(
+    http::HttpRequest& request) const {
+  http::PathParams params;
+  size_t index = router_.find(http::parseMethod(request.method()),
+                              request.path(), params);
+  if (index == http::Router::kNotFound) return nullptr;
+  request.setPathParams(params);
+  return &handlers_[index];
 }
\ No newline at end of file
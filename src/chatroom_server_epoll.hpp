@@ -1,57 +1,204 @@
 #pragma once
+#include <sys/types.h>
+
 #include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include <memory>
+#include <optional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 
-#include "db/database_manager.hpp"
+#include "chat/chat_service.hpp"
+#include "chat/room_shards.hpp"
+#include "http/http_request.hpp"
+#include "http/http_response.hpp"
+#include "http/rate_limiter.hpp"
+#include "http/response_compression.hpp"
+#include "http/router.hpp"
+#include "http/static_file_cache.hpp"
 #include "reactor/channel.hpp"
 #include "reactor/epoller.hpp"
 #include "reactor/event_loop.hpp"
-#include "utils/kafka_producer.hpp"
+#include "utils/arena.hpp"
+#include "utils/object_pool.hpp"
+#include "utils/shared_buffer.hpp"
+#include "utils/thread_pool.hpp"
 
 class ChatroomServerEpoll {
  public:
+  // port 为 0 时由系统分配端口；kafka_brokers 为空时不发送 Kafka 事件
   ChatroomServerEpoll(const std::string& static_dir_path,
                       const std::string& db_file_path, int port,
                       const std::string& kafka_brokers = "localhost:9092");
+  // 挂载共用的业务层。reusePort 时监听 socket 设置 SO_REUSEPORT，
+  // 多个实例（各自一个事件循环线程）监听同一端口，由内核分配连接
+  ChatroomServerEpoll(std::shared_ptr<ChatService> service,
+                      const std::string& static_dir_path, int port,
+                      bool reusePort = false);
+  ~ChatroomServerEpoll();
+
+  // 实际监听的端口
+  int port() const { return port_; }
 
   void cleanupPendingChannels();
   void startServer();
   void stopServer();
+  // 在 startServer() 之前调用。io_uring 不可用时记录错误、保持 epoll，
+  // 返回 false
+  bool setIoBackend(reactor::IoBackend backend);
+  // 在 startServer() 之前调用
+  void setCompression(const http::CompressionOptions& options);
+  // 在 startServer() 之前调用，设置在共用的业务层上
+  void setRateLimit(const http::RateLimitOptions& options) {
+    service_->setRateLimit(options);
+  }
+
+  // 在 startServer() 之前调用：本循环拥有 shards 的第 index 个分片，
+  // 在事件循环线程上执行其他循环投递给这些房间的操作
+  void setRoomShard(RoomShards* shards, size_t index) {
+    roomShards_ = shards;
+    shardIndex_ = index;
+  }
+
+  // 连接准入控制，在 startServer() 之前调用
+  struct AdmissionOptions {
+    size_t maxConnections = 10000;
+    // 从 accept 到收齐请求（头部和 Content-Length 指定的请求体）的期限，
+    // 防止慢速连接（slowloris）一直占着连接
+    std::chrono::milliseconds requestTimeout{10000};
+    size_t maxRequestBytes = 1024 * 1024;
+  };
+  void setAdmission(const AdmissionOptions& options) { admission_ = options; }
+
+  // 接受的连接数和各拒绝原因的计数，可在任意线程读取
+  struct AdmissionStats {
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> rejectedMaxConnections{0};
+    std::atomic<uint64_t> rejectedNoFd{0};
+    std::atomic<uint64_t> requestTimeouts{0};
+    std::atomic<uint64_t> oversizedRequests{0};
+  };
+  const AdmissionStats& admissionStats() const { return admissionStats_; }
 
  private:
   void setupRoutes();
-  // 静态文件处理
-  // 返回内容和Content-Type
-  struct StaticFileResult {
-    std::string content;
-    std::string contentType;
+  // 关闭监听、计时器和预留的 fd，只在事件循环退出后或析构时调用
+  void closeServerFds();
+  void handleNewConnection();
+  // fd 用尽时让出预留的 fd，接受并立即关闭一个连接，返回是否成功
+  bool shedWithReserveFd();
+  // 连接数已满时回 503 并关闭 clientFd，返回 false
+  bool admitConnection(int clientFd);
+
+  // 一次没发完的响应：先发内存中的报文和共享的响应体，再用 sendfile
+  // 发送文件区间。共享的响应体只保留引用，不复制
+  struct PendingWrite {
+    std::string buffer;
+    utils::SharedBuffer shared;  // 在 buffer 之后发送
+    size_t sent{0};              // buffer 和 shared 中已发送的字节数
+    int fileFd{-1};
+    off_t fileOffset{0};
+    uint64_t fileRemaining{0};
   };
-  StaticFileResult handleStaticFile(const std::string& path);
+  // 一个客户端连接的全部状态，从 connPool_ 分配并按 fd 登记在
+  // connections_ 里，建连和断连不用再分配内存。关闭后先放进 closed_，
+  // 本轮回调都执行完才归还连接池
+  struct Connection {
+    Connection(int fd, uint32_t ip) : fd(fd), ip(ip), channel(fd) {}
+    int fd;
+    uint32_t ip;               // 网络字节序的 IPv4 地址，用于按 IP 限流
+    reactor::Channel channel;  // epoll 后端
+    uint64_t recvToken{0};     // io_uring 后端的 multishot recv
+    // 还没收齐请求：收到的部分留在 readBuffer 里，等下一次可读事件。
+    // 所有连接的期限相同，等待中的连接按 accept 顺序串成链表，
+    // 表头总是最早到期
+    bool reading{true};
+    bool handling{false};  // 处理函数协程未完成
+    std::string readBuffer;
+    std::chrono::steady_clock::time_point deadline;
+    Connection* prevReading{nullptr};
+    Connection* nextReading{nullptr};
+    PendingWrite write;
+  };
+  // 开始等待请求：分配连接，登记读取期限
+  Connection* openConnection(int clientFd, uint32_t clientIp);
+  // 已关闭或不存在时返回 nullptr
+  Connection* connection(int clientFd) const {
+    size_t index = static_cast<size_t>(clientFd);
+    return index < connections_.size() ? connections_[index] : nullptr;
+  }
+  // 请求已收齐或连接关闭：移出等待链表，不再受读取期限约束
+  void stopReading(Connection* conn);
+  size_t connectionCount() const { return connPool_.size() - closed_.size(); }
+  void handleClientEvent(Connection* conn);
+  // request 为目前收到的全部字节：没收齐时存回 readBuffer，
+  // 收齐后解析、分发并发送响应
+  void processRequest(Connection* conn, utils::ArenaString& request);
+  // 启动 handlers_[index] 的协程，完成（可能在挂起之后）时发送响应
+  void runHandler(Connection* conn, size_t index,
+                  const http::HttpRequest& request);
+  // 按 Accept-Encoding 压缩后发送
+  void respond(int clientFd, std::optional<std::string_view> acceptEncoding,
+               http::HttpResponse& response);
 
-  void handleNewConnection();
-  void handleClientEvent(int clientFd);
+  // io_uring 后端：multishot accept 和 recv 的完成回调，
+  // 发送完成后再关闭连接
+  void startAccepting();
+  // 退出时调用：停止接受连接，关闭还在等请求的连接
+  void stopAccepting();
+  void handleAccepted(int res);
+  void handleClientData(Connection* conn, std::string_view data);
+  void handleUringSent(int clientFd, int res);
+
+  void armDeadlineTimer();
+  void handleReadDeadlines();
+  void sendResponse(int clientFd, http::HttpResponse& response);
+  // 写到 EAGAIN 为止，返回 true 表示已发完或出错，可以关闭连接
+  bool flushPendingWrite(int clientFd, PendingWrite& pending);
+  void handleClientWritable(int clientFd);
+  // 把响应体交给压缩线程池，压缩完成后回到事件循环发送
+  void compressInPool(int clientFd, const http::HttpResponse& response,
+                      utils::ContentEncoding encoding);
+  void closeClient(int clientFd);
+  // GET /metrics：注册表中的指标，加上现取的连接、会话和准入计数
+  http::HttpResponse metricsResponse() const;
 
-  // 路由表
-  using Handler = std::function<std::string(
-      const std::string&, const std::unordered_map<std::string, std::string>&)>;
-  std::unordered_map<std::string, std::unordered_map<std::string, Handler>>
-      handlers_;
+  // 路由表：router_ 只保存 handlers_ 的下标
+  using Handler = ChatService::Handler;
+  http::Router router_;
+  std::vector<Handler> handlers_;
+  std::vector<utils::Histogram> handlerLatency_;  // 与 handlers_ 一一对应
 
   void registerHandler(const std::string& method, const std::string& path,
                        Handler handler);
-  std::string dispatch(
-      const std::string& method, const std::string& path,
-      const std::string& body,
-      const std::unordered_map<std::string, std::string>& headers);
+  // 匹配到的路径参数写入 request，未注册时返回 nullptr
+  const Handler* findHandler(http::HttpRequest& request) const;
 
+  std::shared_ptr<ChatService> service_;
   std::string staticDirPath_;
-  std::shared_ptr<DatabaseManager> dbManager_;
-  std::unique_ptr<KafkaProducer> kafkaProducer_;
+  http::StaticFileCache staticCache_;
   std::unique_ptr<reactor::EventLoop> eventLoop_;
+  http::CompressionOptions compression_;
+  // 声明在 eventLoop_ 之后，先于它析构，压缩任务结束后事件循环仍然有效
+  std::unique_ptr<utils::ThreadPool> compressPool_;
   int listenFd_{-1};
-  std::unordered_map<int, std::shared_ptr<reactor::Channel>> clientChannels_;
-  std::vector<int> pendingDeleteFds_;
+  uint64_t acceptToken_{0};  // io_uring 后端的 multishot accept
+  int port_{0};
+  utils::ObjectPool<Connection> connPool_;
+  std::vector<Connection*> connections_;  // 按 fd 下标
+  std::vector<Connection*> closed_;
+  Connection* readingHead_{nullptr};
+  Connection* readingTail_{nullptr};
+  // 挂起中的处理函数和还没发送的压缩任务，只在事件循环线程上读写
+  size_t pendingHandlers_{0};
+  RoomShards* roomShards_{nullptr};
+  size_t shardIndex_{0};
+  int deadlineTimerFd_{-1};  // timerfd，按队头期限触发
+  int reserveFd_{-1};        // 预留的 fd，见 shedWithReserveFd()
+  AdmissionOptions admission_;
+  AdmissionStats admissionStats_;
   std::atomic<bool> running_{false};
 };
\ No newline at end of file
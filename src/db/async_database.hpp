@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "database_manager.hpp"
+#include "reactor/offload.hpp"
+#include "utils/thread_pool.hpp"
+
+/**
+ * @brief DatabaseManager 的协程接口
+ * 每个调用返回一个可 co_await 的 reactor::Offload：在事件循环线程上
+ * 查询交给数据库线程池执行，完成后回到原循环恢复协程，SQLite 的阻塞
+ * 不占用事件循环；没有事件循环的线程上直接同步执行。
+ * string_view 参数在 co_await 结束前必须有效。
+ */
+class AsyncDatabase {
+ public:
+  // threads 为 0 时不建线程池，所有调用都同步执行
+  AsyncDatabase(std::shared_ptr<DatabaseManager> db, size_t threads)
+      : db_(std::move(db)),
+        pool_(threads > 0 ? std::make_unique<utils::ThreadPool>(threads, "db")
+                          : nullptr) {}
+
+  DatabaseManager& sync() { return *db_; }
+
+  // fn(DatabaseManager&) 在数据库线程池中执行
+  template <typename F>
+  auto call(F fn) {
+    return reactor::offload(pool_.get(), [db = db_.get(), fn = std::move(fn)] {
+      return fn(*db);
+    });
+  }
+
+  auto createUser(std::string_view userName, std::string_view pwHash) {
+    return call([=](DatabaseManager& db) {
+      return db.createUser(userName, pwHash);
+    });
+  }
+  auto isUserExists(std::string_view userName) {
+    return call([=](DatabaseManager& db) { return db.isUserExists(userName); });
+  }
+  auto validateUser(std::string_view userName, std::string_view pwHash) {
+    return call([=](DatabaseManager& db) {
+      return db.validateUser(userName, pwHash);
+    });
+  }
+  auto setUserOnlineStatus(std::string_view userName, bool online) {
+    return call([=](DatabaseManager& db) {
+      return db.setUserOnlineStatus(userName, online);
+    });
+  }
+  auto getUserList() {
+    return call([](DatabaseManager& db) { return db.getUserList(); });
+  }
+  auto createRoom(std::string_view roomName, std::string_view creator) {
+    return call([=](DatabaseManager& db) {
+      return db.createRoom(roomName, creator);
+    });
+  }
+  auto addUserToRoom(std::string_view roomName, std::string_view userName) {
+    return call([=](DatabaseManager& db) {
+      return db.addUserToRoom(roomName, userName);
+    });
+  }
+  auto getRoomList() {
+    return call([](DatabaseManager& db) { return db.getRoomList(); });
+  }
+  auto saveMessage(std::string_view roomName, std::string_view userName,
+                   std::string_view message, int64_t timestamp) {
+    return call([=](DatabaseManager& db) {
+      return db.saveMessage(roomName, userName, message, timestamp);
+    });
+  }
+  auto getRoomMessages(std::string_view roomName, int64_t since) {
+    return call([=](DatabaseManager& db) {
+      return db.getRoomMessages(roomName, since);
+    });
+  }
+
+ private:
+  std::shared_ptr<DatabaseManager> db_;
+  // 最后声明，先于 db_ 停止
+  std::unique_ptr<utils::ThreadPool> pool_;
+};
@@ -4,6 +4,36 @@
 #include <iostream>
 #include <nlohmann/json.hpp>
 #include <sstream>
+#include <string_view>
+
+#include "utils/json_writer.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+
+namespace {
+
+std::string_view columnText(sqlite3_stmt* stmt, int col) {
+  const unsigned char* text = sqlite3_column_text(stmt, col);
+  if (!text) return {};
+  return {reinterpret_cast<const char*>(text),
+          static_cast<size_t>(sqlite3_column_bytes(stmt, col))};
+}
+
+utils::Histogram queryLatency(const char* method) {
+  return utils::metrics().histogram(
+      "db_query_duration_seconds",
+      "DatabaseManager call latency including lock wait, by method",
+      {{"method", method}});
+}
+
+}  // namespace
+
+// 每个公开方法的耗时（含等锁），直方图按方法名在首次调用时注册；
+// 被采样的请求中同时记为一个阶段
+#define DB_TIMED()                                                  \
+  static const utils::Histogram kLatency = queryLatency(__func__); \
+  utils::ScopedTimer timer(kLatency);                               \
+  utils::TraceSpan span(__func__, "db")
 
 DatabaseManager::DatabaseManager(const std::string& dbPath)
     : dbPath_(dbPath), db_(nullptr) {
@@ -58,6 +88,11 @@ bool DatabaseManager::initializeDatabase() {
          executeQuery(roomUserTable) && executeQuery(messageTable);
 }
 
+std::unique_lock<std::recursive_mutex> DatabaseManager::lockDb() {
+  utils::TraceSpan span("dbMutex_ wait", "db");
+  return std::unique_lock<std::recursive_mutex>(dbMutex_);
+}
+
 bool DatabaseManager::executeQuery(const std::string& query) {
   std::lock_guard<std::recursive_mutex> lock(dbMutex_);
   char* errMsg = nullptr;
@@ -70,18 +105,20 @@ bool DatabaseManager::executeQuery(const std::string& query) {
   return true;
 }
 
-bool DatabaseManager::createUser(const std::string& userName,
-                                 const std::string& pwHash) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::createUser(std::string_view userName,
+                                 std::string_view pwHash) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "INSERT INTO users (username, password) VALUES ('" << userName << "', '"
      << pwHash << "');";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::validateUser(const std::string& userName,
-                                   const std::string& pwHash) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::validateUser(std::string_view userName,
+                                   std::string_view pwHash) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "SELECT COUNT(*) FROM users WHERE username='" << userName
      << "' AND password='" << pwHash << "';";
@@ -95,17 +132,19 @@ bool DatabaseManager::validateUser(const std::string& userName,
   return valid;
 }
 
-bool DatabaseManager::setUserOnlineStatus(const std::string& userName,
+bool DatabaseManager::setUserOnlineStatus(std::string_view userName,
                                           bool onlineStatus) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "UPDATE users SET is_online=" << (onlineStatus ? 1 : 0)
      << " WHERE username='" << userName << "';";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::setUserLastActiveTime(const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::setUserLastActiveTime(std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   int64_t now = std::chrono::system_clock::now().time_since_epoch().count();
   std::stringstream ss;
   ss << "UPDATE users SET last_active_time=" << now << " WHERE username='"
@@ -113,8 +152,9 @@ bool DatabaseManager::setUserLastActiveTime(const std::string& userName) {
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::isUserOnline(const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::isUserOnline(std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "SELECT is_online FROM users WHERE username='" << userName << "';";
   sqlite3_stmt* stmt = nullptr;
@@ -127,8 +167,9 @@ bool DatabaseManager::isUserOnline(const std::string& userName) {
   return online;
 }
 
-bool DatabaseManager::isUserExists(const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::isUserExists(std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "SELECT COUNT(*) FROM users WHERE username='" << userName << "';";
   sqlite3_stmt* stmt = nullptr;
@@ -141,7 +182,8 @@ bool DatabaseManager::isUserExists(const std::string& userName) {
   return exists;
 }
 
-bool DatabaseManager::checkAndUpdateInactiveUsers(const std::string& userName) {
+bool DatabaseManager::checkAndUpdateInactiveUsers(std::string_view userName) {
+  DB_TIMED();
   // 这里简单实现为：如果用户在线，更新时间，否则不处理
   if (isUserOnline(userName)) {
     return setUserLastActiveTime(userName);
@@ -150,7 +192,8 @@ bool DatabaseManager::checkAndUpdateInactiveUsers(const std::string& userName) {
 }
 
 std::vector<User> DatabaseManager::getOnlineUsers() {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::vector<User> users;
   const char* query =
       "SELECT username, password, is_online FROM users WHERE is_online=1;";
@@ -170,7 +213,8 @@ std::vector<User> DatabaseManager::getOnlineUsers() {
 }
 
 std::vector<User> DatabaseManager::getAllUsers() {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::vector<User> users;
   const char* query = "SELECT username, password, is_online FROM users;";
   sqlite3_stmt* stmt = nullptr;
@@ -188,43 +232,71 @@ std::vector<User> DatabaseManager::getAllUsers() {
   return users;
 }
 
-bool DatabaseManager::createRoom(const std::string& roomName,
-                                 const std::string& creator) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+std::string DatabaseManager::getUserList() {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
+  std::string json;
+  utils::JsonWriter writer(json);
+  writer.beginArray();
+  const char* query = "SELECT username, is_online FROM users;";
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, query, -1, &stmt, nullptr) == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      writer.beginObject()
+          .key("is_online")
+          .value(sqlite3_column_int(stmt, 1) > 0)
+          .key("username")
+          .value(columnText(stmt, 0))
+          .endObject();
+    }
+  }
+  if (stmt) sqlite3_finalize(stmt);
+  writer.endArray();
+  return json;
+}
+
+bool DatabaseManager::createRoom(std::string_view roomName,
+                                 std::string_view creator) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "INSERT INTO rooms (name, creator) VALUES ('" << roomName << "', '"
      << creator << "');";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::deleteRoom(const std::string& roomName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::deleteRoom(std::string_view roomName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "DELETE FROM rooms WHERE name='" << roomName << "';";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::addUserToRoom(const std::string& roomName,
-                                    const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::addUserToRoom(std::string_view roomName,
+                                    std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "INSERT OR IGNORE INTO room_users (room_name, username) VALUES ('"
      << roomName << "', '" << userName << "');";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::removeUserFromRoom(const std::string& roomName,
-                                         const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::removeUserFromRoom(std::string_view roomName,
+                                         std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "DELETE FROM room_users WHERE room_name='" << roomName
      << "' AND username='" << userName << "';";
   return executeQuery(ss.str());
 }
 
-bool DatabaseManager::isUserInRoom(const std::string& roomName,
-                                   const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::isUserInRoom(std::string_view roomName,
+                                   std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "SELECT COUNT(*) FROM room_users WHERE room_name='" << roomName
      << "' AND username='" << userName << "';";
@@ -238,8 +310,9 @@ bool DatabaseManager::isUserInRoom(const std::string& roomName,
   return exists;
 }
 
-bool DatabaseManager::isRoomExists(const std::string& roomName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+bool DatabaseManager::isRoomExists(std::string_view roomName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "SELECT COUNT(*) FROM rooms WHERE name='" << roomName << "';";
   sqlite3_stmt* stmt = nullptr;
@@ -253,8 +326,9 @@ bool DatabaseManager::isRoomExists(const std::string& roomName) {
 }
 
 std::vector<std::string> DatabaseManager::getRoomUsers(
-    const std::string& roomName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+    std::string_view roomName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::vector<std::string> users;
   std::stringstream ss;
   ss << "SELECT username FROM room_users WHERE room_name='" << roomName << "';";
@@ -271,8 +345,9 @@ std::vector<std::string> DatabaseManager::getRoomUsers(
 }
 
 std::vector<std::string> DatabaseManager::getUserRooms(
-    const std::string& userName) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+    std::string_view userName) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::vector<std::string> rooms;
   std::stringstream ss;
   ss << "SELECT room_name FROM room_users WHERE username='" << userName << "';";
@@ -289,7 +364,8 @@ std::vector<std::string> DatabaseManager::getUserRooms(
 }
 
 std::vector<std::string> DatabaseManager::getRooms() {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::vector<std::string> rooms;
   const char* query = "SELECT name FROM rooms;";
   sqlite3_stmt* stmt = nullptr;
@@ -303,11 +379,45 @@ std::vector<std::string> DatabaseManager::getRooms() {
   return rooms;
 }
 
-bool DatabaseManager::saveMessage(const std::string& roomName,
-                                  const std::string& userName,
-                                  const std::string& message,
-                                  int64_t timestamp) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
+std::string DatabaseManager::getRoomList() {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
+  std::string json;
+  utils::JsonWriter writer(json);
+  writer.beginArray();
+  // 一次 LEFT JOIN 取出所有房间及成员，同一房间的行相邻
+  const char* query =
+      "SELECT r.name, ru.username FROM rooms r "
+      "LEFT JOIN room_users ru ON ru.room_name = r.name "
+      "ORDER BY r.rowid, ru.username;";
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, query, -1, &stmt, nullptr) == SQLITE_OK) {
+    std::string current;
+    bool open = false;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      std::string_view name = columnText(stmt, 0);
+      if (!open || name != current) {
+        if (open) writer.endArray().key("name").value(current).endObject();
+        current.assign(name);
+        writer.beginObject().key("members").beginArray();
+        open = true;
+      }
+      if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) {
+        writer.value(columnText(stmt, 1));
+      }
+    }
+    if (open) writer.endArray().key("name").value(current).endObject();
+  }
+  if (stmt) sqlite3_finalize(stmt);
+  writer.endArray();
+  return json;
+}
+
+bool DatabaseManager::saveMessage(std::string_view roomName,
+                                  std::string_view userName,
+                                  std::string_view message, int64_t timestamp) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
   std::stringstream ss;
   ss << "INSERT INTO messages (room_name, username, message, timestamp) VALUES "
         "('"
@@ -316,10 +426,13 @@ bool DatabaseManager::saveMessage(const std::string& roomName,
   return executeQuery(ss.str());
 }
 
-std::vector<nlohmann::json> DatabaseManager::getRoomMessages(
-    const std::string& roomName, int64_t since) {
-  std::lock_guard<std::recursive_mutex> lock(dbMutex_);
-  std::vector<nlohmann::json> messages;
+std::string DatabaseManager::getRoomMessages(std::string_view roomName,
+                                             int64_t since) {
+  DB_TIMED();
+  std::unique_lock<std::recursive_mutex> lock = lockDb();
+  std::string json;
+  utils::JsonWriter writer(json);
+  writer.beginArray();
   std::stringstream ss;
   ss << "SELECT username, message, timestamp FROM messages WHERE room_name='"
      << roomName << "'";
@@ -328,18 +441,21 @@ std::vector<nlohmann::json> DatabaseManager::getRoomMessages(
   }
   ss << " ORDER BY timestamp ASC;";
   sqlite3_stmt* stmt = nullptr;
-  if (sqlite3_prepare_v2(db_, ss.str().c_str(), -1, &stmt, nullptr) !=
-      SQLITE_OK)
-    return messages;
-  while (sqlite3_step(stmt) == SQLITE_ROW) {
-    nlohmann::json msg;
-    msg["username"] =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
-    msg["content"] =
-        reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-    msg["timestamp"] = sqlite3_column_int64(stmt, 2);
-    messages.push_back(msg);
+  if (sqlite3_prepare_v2(db_, ss.str().c_str(), -1, &stmt, nullptr) ==
+      SQLITE_OK) {
+    // 键按字典序输出，与之前 nlohmann::json (std::map) 的结果保持一致
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      writer.beginObject()
+          .key("content")
+          .value(columnText(stmt, 1))
+          .key("timestamp")
+          .value(sqlite3_column_int64(stmt, 2))
+          .key("username")
+          .value(columnText(stmt, 0))
+          .endObject();
+    }
   }
   if (stmt) sqlite3_finalize(stmt);
-  return messages;
+  writer.endArray();
+  return json;
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "chat/user.hpp"
@@ -14,35 +15,41 @@ class DatabaseManager {
   DatabaseManager(const std::string& dbPath);
   ~DatabaseManager();
 
-  bool createUser(const std::string& userName, const std::string& pwHash);
-  bool validateUser(const std::string& userName, const std::string& pwHash);
-  bool setUserOnlineStatus(const std::string& userName, bool onlineStatus);
-  bool setUserLastActiveTime(const std::string& userName);
-  bool isUserOnline(const std::string& userName);
-  bool isUserExists(const std::string& userName);
-  bool checkAndUpdateInactiveUsers(const std::string& userName);
+  bool createUser(std::string_view userName, std::string_view pwHash);
+  bool validateUser(std::string_view userName, std::string_view pwHash);
+  bool setUserOnlineStatus(std::string_view userName, bool onlineStatus);
+  bool setUserLastActiveTime(std::string_view userName);
+  bool isUserOnline(std::string_view userName);
+  bool isUserExists(std::string_view userName);
+  bool checkAndUpdateInactiveUsers(std::string_view userName);
   std::vector<User> getOnlineUsers();
   std::vector<User> getAllUsers();
-
-  bool createRoom(const std::string& roomName, const std::string& creator);
-  bool deleteRoom(const std::string& roomName);
-  bool addUserToRoom(const std::string& roomName, const std::string& userName);
-  bool removeUserFromRoom(const std::string& roomName,
-                          const std::string& userName);
-  bool isUserInRoom(const std::string& roomName, const std::string& userName);
-  bool isRoomExists(const std::string& roomName);
-  std::vector<std::string> getRoomUsers(const std::string& roomName);
-  std::vector<std::string> getUserRooms(const std::string& userName);
+  // [{"is_online":bool,"username":str}, ...]
+  std::string getUserList();
+
+  bool createRoom(std::string_view roomName, std::string_view creator);
+  bool deleteRoom(std::string_view roomName);
+  bool addUserToRoom(std::string_view roomName, std::string_view userName);
+  bool removeUserFromRoom(std::string_view roomName, std::string_view userName);
+  bool isUserInRoom(std::string_view roomName, std::string_view userName);
+  bool isRoomExists(std::string_view roomName);
+  std::vector<std::string> getRoomUsers(std::string_view roomName);
+  std::vector<std::string> getUserRooms(std::string_view userName);
   std::vector<std::string> getRooms();
+  // [{"members":[str...],"name":str}, ...]
+  std::string getRoomList();
 
-  bool saveMessage(const std::string& roomName, const std::string& userName,
-                   const std::string& message, int64_t timestamp);
-  std::vector<nlohmann::json> getRoomMessages(const std::string& roomName,
-                                              int64_t since = 0);
+  bool saveMessage(std::string_view roomName, std::string_view userName,
+                   std::string_view message, int64_t timestamp);
+  // [{"content":str,"timestamp":int,"username":str}, ...]
+  // 直接从 sqlite 行流式序列化为 JSON 文本，不构建 DOM
+  std::string getRoomMessages(std::string_view roomName, int64_t since = 0);
 
  private:
   bool initializeDatabase();
   bool executeQuery(const std::string& query);
+  // 加 dbMutex_，被采样的请求中等锁时间单独记为一个阶段
+  std::unique_lock<std::recursive_mutex> lockDb();
 
   std::string dbPath_;
   sqlite3* db_;
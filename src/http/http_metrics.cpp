@@ -0,0 +1,54 @@
+#include "http_metrics.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace http {
+namespace {
+
+struct StatusCounters {
+  static constexpr int kMaxStatus = 600;
+  std::mutex mutex;
+  std::atomic<bool> ready[kMaxStatus] = {};
+  utils::Counter counters[kMaxStatus];
+};
+
+StatusCounters& statusCounters() {
+  static StatusCounters counters;
+  return counters;
+}
+
+}  // namespace
+
+utils::Histogram routeLatency(std::string_view method,
+                              std::string_view route) {
+  return utils::metrics().histogram(
+      "http_handler_duration_seconds",
+      "Time spent in request handlers, by registered route",
+      {{"method", std::string(method)}, {"route", std::string(route)}});
+}
+
+void countResponse(int status) {
+  StatusCounters& counters = statusCounters();
+  if (status < 0 || status >= StatusCounters::kMaxStatus) return;
+  if (!counters.ready[status].load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(counters.mutex);
+    if (!counters.ready[status].load(std::memory_order_relaxed)) {
+      counters.counters[status] = utils::metrics().counter(
+          "http_responses_total", "Responses sent, by status code",
+          {{"code", std::to_string(status)}});
+      counters.ready[status].store(true, std::memory_order_release);
+    }
+  }
+  counters.counters[status].inc();
+}
+
+HttpResponse metricsResponse(std::string_view extra) {
+  std::string body = utils::metrics().render();
+  body.append(extra);
+  HttpResponse response(200, body);
+  response.setHeader("Content-Type", "text/plain; version=0.0.4");
+  return response;
+}
+}  // namespace http
@@ -0,0 +1,16 @@
+#pragma once
+#include <string_view>
+
+#include "http_response.hpp"
+#include "utils/metrics.hpp"
+
+namespace http {
+// 每个路由的处理时间，在注册路由时创建；_count 即该路由的请求数
+utils::Histogram routeLatency(std::string_view method, std::string_view route);
+
+// 按状态码计数，每个状态码第一次出现时注册
+void countResponse(int status);
+
+// GET /metrics 的响应：注册表中的指标，后接调用方现取的 extra
+HttpResponse metricsResponse(std::string_view extra = {});
+}  // namespace http
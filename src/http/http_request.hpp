@@ -1,6 +1,11 @@
 #pragma once
-#include <string>
-#include <unordered_map>
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "utils/arena.hpp"
 
 /**
  * POST /login?username=alice&id=1 HTTP/1.1\r\n
@@ -13,30 +18,91 @@
  */
 
 namespace http {
-class HttpRequest {
+/**
+ * @brief 路由匹配出的路径参数（如 /rooms/:name 中的 name）
+ * 定长数组，不分配内存，构造时也不初始化数组（每个请求都会构造一次）。
+ * 名字指向路由表，值指向请求路径且未经 URL 解码。
+ * 一条路由最多 kMax 个参数（含末尾的 "*"），由 Router::add 检查。
+ */
+class PathParams {
  public:
-  static HttpRequest parse(const std::string& request_str);
+  struct Param {
+    std::string_view first;  // 参数名
+    std::string_view second;  // 参数值
+  };
+  static constexpr size_t kMax = 8;
 
-  const std::string& method() const { return method_; }
-  const std::string& path() const { return path_; }
-  const std::string& body() const { return body_; }
-  const std::unordered_map<std::string, std::string>& headers() const {
-    return headers_;
+  PathParams() {}
+  PathParams(const PathParams& other) : size_(other.size_) {
+    std::copy(other.begin(), other.end(), storage_.items);
+  }
+  PathParams& operator=(const PathParams& other) {
+    size_ = other.size_;
+    std::copy(other.begin(), other.end(), storage_.items);
+    return *this;
   }
-  const std::unordered_map<std::string, std::string>& query_params() const {
+
+  void push(std::string_view name, std::string_view value) {
+    storage_.items[size_++] = Param{name, value};
+  }
+  void pop() { --size_; }
+  void clear() { size_ = 0; }
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const Param& operator[](size_t i) const { return storage_.items[i]; }
+  const Param* begin() const { return storage_.items; }
+  const Param* end() const { return storage_.items + size_; }
+
+ private:
+  union Storage {
+    Storage() {}  // 不初始化，只读取 [0, size_) 范围内已写入的元素
+    Param items[kMax];
+  } storage_;
+  size_t size_{0};
+};
+
+/**
+ * 请求行、头部和请求体都是指向原始报文的 string_view，解析时不拷贝，
+ * 原始报文必须比 HttpRequest 活得久。
+ * 头部表和 URL 解码后的查询参数从当前 ArenaScope 分配（见 utils/arena.hpp）。
+ */
+class HttpRequest {
+ public:
+  using Header = std::pair<std::string_view, std::string_view>;
+  using QueryParam = std::pair<utils::ArenaString, utils::ArenaString>;
+
+  static HttpRequest parse(std::string_view request_str);
+
+  std::string_view method() const { return method_; }
+  std::string_view path() const { return path_; }
+  std::string_view body() const { return body_; }
+  const utils::ArenaVector<Header>& headers() const { return headers_; }
+  const utils::ArenaVector<QueryParam>& query_params() const {
     return query_params_;
   }
 
+  // 头部名不区分大小写，重复出现时取最后一个
+  std::optional<std::string_view> header(std::string_view name) const;
+  std::optional<std::string_view> queryParam(std::string_view name) const;
+
+  // 由路由器在分发前填入
+  std::optional<std::string_view> pathParam(std::string_view name) const;
+  const PathParams& pathParams() const { return path_params_; }
+  void setPathParams(const PathParams& params) { path_params_ = params; }
+
+  static utils::ArenaString urlDecode(std::string_view encoded);
+
  private:
   HttpRequest() = default;
-  static std::unordered_map<std::string, std::string> parseQueryParams(
-      const std::string& query_string);
-  static std::string urlDecode(const std::string& encoded);
-
-  std::string method_;
-  std::string path_;
-  std::string body_;
-  std::unordered_map<std::string, std::string> headers_;
-  std::unordered_map<std::string, std::string> query_params_;
+  static void parseQueryParams(std::string_view query_string,
+                               utils::ArenaVector<QueryParam>& params);
+
+  std::string_view method_;
+  std::string_view path_;
+  std::string_view body_;
+  utils::ArenaVector<Header> headers_;
+  utils::ArenaVector<QueryParam> query_params_;
+  PathParams path_params_;
 };
 }  // namespace http
\ No newline at end of file
@@ -1,68 +1,167 @@
 #include "http_response.hpp"
 
-#include <sstream>
+#include <charconv>
+#include <ctime>
 
 namespace http {
+namespace {
+template <typename T>
+void appendNumber(utils::ArenaString& out, T value) {
+  char buf[24];
+  auto result = std::to_chars(buf, buf + sizeof(buf), value);
+  out.append(buf, result.ptr - buf);
+}
+}  // namespace
 
 void HttpResponse::setStatus(int code) { statusCode_ = code; }
 
-void HttpResponse::setHeader(const std::string& key, const std::string& value) {
-  headers_[key] = value;
+void HttpResponse::setHeader(std::string_view key, std::string_view value) {
+  for (auto& header : headers_) {
+    if (header.first == key) {
+      header.second.assign(value.data(), value.size());
+      return;
+    }
+  }
+  headers_.emplace_back(utils::ArenaString(key.data(), key.size()),
+                        utils::ArenaString(value.data(), value.size()));
 }
 
-void HttpResponse::setBody(const std::string& body) {
-  body_ = body;
-  headers_["Content-Length"] = std::to_string(body.length());
-  if (headers_.find("Content-Type") == headers_.end()) {
-    if (!body.empty() && ((body.front() == '{' && body.back() == '}') ||
-                          (body.front() == '[' && body.back() == ']'))) {
-      headers_["Content-Type"] = "application/json";
-    } else {
-      headers_["Content-Type"] = "text/plain";
-    }
+std::optional<std::string_view> HttpResponse::header(
+    std::string_view key) const {
+  for (const auto& header : headers_) {
+    if (header.first == key) return std::string_view(header.second);
+  }
+  return std::nullopt;
+}
+
+void HttpResponse::setBody(std::string_view body) {
+  body_.assign(body.data(), body.size());
+  sharedBody_ = utils::SharedBuffer();  // body 可能指向它，复制之后再释放
+  setDefaultContentType(body_);
+}
+
+void HttpResponse::setBody(utils::SharedBuffer body) {
+  body_.clear();
+  sharedBody_ = std::move(body);
+  setDefaultContentType(sharedBody_.view());
+}
+
+void HttpResponse::setDefaultContentType(std::string_view body) {
+  for (const auto& header : headers_) {
+    if (header.first == "Content-Type") return;
   }
+  if (!body.empty() && ((body.front() == '{' && body.back() == '}') ||
+                        (body.front() == '[' && body.back() == ']'))) {
+    setHeader("Content-Type", "application/json");
+  } else {
+    setHeader("Content-Type", "text/plain");
+  }
+}
+
+void HttpResponse::setFileBody(std::string_view path, uint64_t offset,
+                               uint64_t length) {
+  body_.clear();
+  sharedBody_ = utils::SharedBuffer();
+  fileBody_ = FileBody{utils::ArenaString(path.data(), path.size()), offset,
+                       length};
 }
 
-HttpResponse::HttpResponse(int status_code, const std::string& body)
+HttpResponse::HttpResponse(int status_code, std::string_view body)
     : statusCode_(status_code) {
+  headers_.reserve(8);
   setBody(body);
 }
 
-std::string HttpResponse::toString() const {
-  std::stringstream ss;
-  ss << "HTTP/1.1 " << statusCode_ << " " << getStatusText(statusCode_)
-     << "\r\n";
-  ss << "Content-Length: " << body_.length() << "\r\n";
+utils::ArenaString HttpResponse::serializeHeaders() const {
+  std::string_view line = statusLine(statusCode_);
+  size_t size = 64 + line.size();
+  for (const auto& header : headers_) {
+    size += header.first.size() + header.second.size() + 4;
+  }
+
+  utils::ArenaString out;
+  out.reserve(size);
+  if (!line.empty()) {
+    out += line;
+  } else {
+    out += "HTTP/1.1 ";
+    appendNumber(out, statusCode_);
+    out += " Unknown Status\r\n";
+  }
+  // 204/304 不带 Content-Length，避免与实际资源长度矛盾
+  if (statusCode_ != 204 && statusCode_ != 304) {
+    out += "Content-Length: ";
+    appendNumber(out, fileBody_ ? fileBody_->length : body().size());
+    out += "\r\n";
+  }
   for (const auto& header : headers_) {
     if (header.first == "Content-Length") continue;
-    ss << header.first << ": " << header.second << "\r\n";
+    out += header.first;
+    out += ": ";
+    out += header.second;
+    out += "\r\n";
   }
-  ss << "\r\n";
-  ss << body_;
-  return ss.str();
+  out += "\r\n";
+  return out;
+}
+
+utils::ArenaString HttpResponse::toString() const {
+  utils::ArenaString out = serializeHeaders();
+  out += body();
+  return out;
 }
 
-std::string HttpResponse::getStatusText(int code) {
+// 常用状态码的完整状态行，序列化时直接拷贝
+std::string_view HttpResponse::statusLine(int code) {
   switch (code) {
     case 200:
-      return "OK";
+      return "HTTP/1.1 200 OK\r\n";
     case 201:
-      return "Created";
+      return "HTTP/1.1 201 Created\r\n";
+    case 206:
+      return "HTTP/1.1 206 Partial Content\r\n";
     case 302:
-      return "Found";
+      return "HTTP/1.1 302 Found\r\n";
+    case 304:
+      return "HTTP/1.1 304 Not Modified\r\n";
     case 400:
-      return "Bad Request";
+      return "HTTP/1.1 400 Bad Request\r\n";
     case 401:
-      return "Unauthorized";
+      return "HTTP/1.1 401 Unauthorized\r\n";
     case 403:
-      return "Forbidden";
+      return "HTTP/1.1 403 Forbidden\r\n";
     case 404:
-      return "Not Found";
+      return "HTTP/1.1 404 Not Found\r\n";
+    case 416:
+      return "HTTP/1.1 416 Range Not Satisfiable\r\n";
+    case 413:
+      return "HTTP/1.1 413 Payload Too Large\r\n";
+    case 429:
+      return "HTTP/1.1 429 Too Many Requests\r\n";
     case 500:
-      return "Internal Server Error";
+      return "HTTP/1.1 500 Internal Server Error\r\n";
     default:
-      return "Unknown Status";
+      return {};
+  }
+}
+
+std::string_view httpDate() {
+  thread_local time_t cachedSecond = 0;
+  thread_local char buffer[40];
+  thread_local size_t length = 0;
+  time_t now = time(nullptr);
+  if (now != cachedSecond) {
+    tm utc;
+#ifdef _WIN32
+    gmtime_s(&utc, &now);
+#else
+    gmtime_r(&now, &utc);
+#endif
+    length = strftime(buffer, sizeof(buffer), "%a, %d %b %Y %H:%M:%S GMT",
+                      &utc);
+    cachedSecond = now;
   }
+  return std::string_view(buffer, length);
 }
 
-}  // namespace http
\ No newline at end of file
+}  // namespace http
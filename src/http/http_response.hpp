@@ -1,30 +1,68 @@
 #pragma once
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "utils/arena.hpp"
+#include "utils/shared_buffer.hpp"
 
 namespace http {
 
+/**
+ * 响应体和头部都从当前 ArenaScope 分配（作用域外退化为普通堆分配），
+ * 头部按设置顺序存放在扁平数组中。响应体也可以引用一个共享的
+ * SharedBuffer，同一份报文发给多个连接时不复制。
+ */
 class HttpResponse {
  public:
-  HttpResponse(int status_code = 200, const std::string& body = "");
+  using Header = std::pair<utils::ArenaString, utils::ArenaString>;
+  // 文件中的一段，由发送方用 sendfile 直接发送，不读入用户态
+  struct FileBody {
+    utils::ArenaString path;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  HttpResponse(int status_code = 200, std::string_view body = "");
 
   void setStatus(int code);
-  void setHeader(const std::string& key, const std::string& value);
-  void setBody(const std::string& body);
+  void setHeader(std::string_view key, std::string_view value);
+  void setBody(std::string_view body);
+  // 引用共享的响应体，不复制；发送方通过 iovec 直接发送这块内存
+  void setBody(utils::SharedBuffer body);
+  // 以文件区间作为响应体，会清空 body()
+  void setFileBody(std::string_view path, uint64_t offset, uint64_t length);
 
   int statusCode() const { return statusCode_; };
-  const std::string& body() const { return body_; }
-  const std::unordered_map<std::string, std::string>& headers() const {
-    return headers_;
-  };
+  std::string_view body() const {
+    return sharedBody_ ? sharedBody_.view() : std::string_view(body_);
+  }
+  // 响应体是共享缓冲区时非空，发送方可以保留引用代替复制
+  const utils::SharedBuffer& sharedBody() const { return sharedBody_; }
+  const utils::ArenaVector<Header>& headers() const { return headers_; };
+  std::optional<std::string_view> header(std::string_view key) const;
+  const std::optional<FileBody>& fileBody() const { return fileBody_; }
 
-  std::string toString() const;
+  // 状态行和头部（以空行结束）。响应体不拷贝，发送方把它和 body()
+  // 一起 writev 出去；有 fileBody 时文件内容由发送方随后 sendfile。
+  // Content-Length 总是按响应体长度生成（204/304 除外）
+  utils::ArenaString serializeHeaders() const;
+  // 头部加响应体的完整报文，用于测试和日志
+  utils::ArenaString toString() const;
 
  private:
   int statusCode_;
-  std::string body_;
-  std::unordered_map<std::string, std::string> headers_;
+  utils::ArenaString body_;
+  utils::SharedBuffer sharedBody_;
+  utils::ArenaVector<Header> headers_;
+  std::optional<FileBody> fileBody_;
 
-  static std::string getStatusText(int code);
+  static std::string_view statusLine(int code);
+  // 没有设置 Content-Type 时按响应体猜测
+  void setDefaultContentType(std::string_view body);
 };
+
+// 当前时间的 HTTP-date（RFC 7231），按线程缓存，每秒最多格式化一次
+std::string_view httpDate();
 }  // namespace http
\ No newline at end of file
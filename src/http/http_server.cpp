@@ -1,18 +1,108 @@
 #include "http_server.hpp"
 
+#include <algorithm>
 #include <cstring>
-#include <fstream> 
-#include <iterator>
+#include <fstream>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#endif
+#ifndef _WIN32
+#include <sys/uio.h>
+#endif
 
 #include "http_request.hpp"
 #include "http_response.hpp"
 #include "socket_compat.hpp"
 #include "utils/logger.hpp"
+#include "utils/tracing.hpp"
 
 namespace http {
+namespace {
+// 阻塞写完整个缓冲区，被信号中断时重试
+bool writeAll(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = SOCKET_WRITE(fd, data, size);
+    if (n < 0) {
+      if (SOCKET_ERROR_MSG() == EINTR) continue;
+      LOG(ERROR) << "Failed to send response: "
+                 << strerror(SOCKET_ERROR_MSG());
+      return false;
+    }
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+// 头部和响应体分散写，一次系统调用发出，响应体不拼接到头部后面
+bool writeResponse(int fd, std::string_view head, std::string_view body) {
+#ifdef _WIN32
+  return writeAll(fd, head.data(), head.size()) &&
+         writeAll(fd, body.data(), body.size());
+#else
+  iovec iov[2] = {{const_cast<char*>(head.data()), head.size()},
+                  {const_cast<char*>(body.data()), body.size()}};
+  iovec* cur = iov;
+  int count = body.empty() ? 1 : 2;
+  while (count > 0) {
+    ssize_t n = writev(fd, cur, count);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      LOG(ERROR) << "Failed to send response: " << strerror(errno);
+      return false;
+    }
+    // 跳过已写完的段，调整写了一部分的段
+    while (count > 0 && static_cast<size_t>(n) >= cur->iov_len) {
+      n -= cur->iov_len;
+      ++cur;
+      --count;
+    }
+    if (count > 0) {
+      cur->iov_base = static_cast<char*>(cur->iov_base) + n;
+      cur->iov_len -= n;
+    }
+  }
+  return true;
+#endif
+}
+
+// 发送文件区间：Linux 上用 sendfile，内容不经过用户态；其他平台分块读写
+bool sendFileBody(int fd, const HttpResponse::FileBody& file) {
+#ifdef __linux__
+  int fileFd = open(file.path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fileFd < 0) {
+    LOG(ERROR) << "Failed to open file: " << file.path;
+    return false;
+  }
+  off_t offset = static_cast<off_t>(file.offset);
+  uint64_t remaining = file.length;
+  while (remaining > 0) {
+    ssize_t n = sendfile(fd, fileFd, &offset, remaining);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;  // 出错或文件被截断
+    remaining -= n;
+  }
+  close(fileFd);
+  return remaining == 0;
+#else
+  std::ifstream in(file.path.c_str(), std::ios::binary);
+  in.seekg(static_cast<std::streamoff>(file.offset));
+  char buffer[16 * 1024];
+  uint64_t remaining = file.length;
+  while (remaining > 0 && in) {
+    in.read(buffer, std::min<uint64_t>(remaining, sizeof(buffer)));
+    if (in.gcount() <= 0 || !writeAll(fd, buffer, in.gcount())) break;
+    remaining -= in.gcount();
+  }
+  return remaining == 0;
+#endif
+}
+}  // namespace
+
 HttpServer::HttpServer(int port, size_t thread_num)
-    : port_(port), running_(false), threadPool_(thread_num) {
-  staticDir_ = "./static";
+    : port_(port), running_(false), threadPool_(thread_num, "http") {
   serverFd_ = socket(AF_INET, SOCK_STREAM, 0);
   if (serverFd_ < 0) {
     throw std::runtime_error("Failed to create socket");
@@ -42,7 +132,9 @@ HttpServer::~HttpServer() {
 
 void HttpServer::addHandler(const std::string& method, const std::string& path,
                             RequestHandler handler) {
-  handlers_[method][path] = std::move(handler);
+  router_.add(parseMethod(method), path, handlers_.size());
+  handlers_.push_back(std::move(handler));
+  handlerLatency_.push_back(routeLatency(method, path));
 }
 
 void HttpServer::run() {
@@ -65,8 +157,9 @@ void HttpServer::run() {
               << ")";
 
     // 2 创建一个新线程处理客户端请求
-    threadPool_.enqueue([this, client_fd] {
-      handleClient(client_fd);
+    uint32_t client_ip = client_addr.sin_addr.s_addr;
+    threadPool_.enqueue([this, client_fd, client_ip] {
+      handleClient(client_fd, client_ip);
       return 0;  // For future compatibility
     });
   }
@@ -77,65 +170,70 @@ void HttpServer::stop() {
   LOG(INFO) << "HTTP server is stopping";
 }
 
-void HttpServer::handleClient(int client_fd) {
+void HttpServer::handleClient(int client_fd, uint32_t client_ip) {
+  // 解析、处理和响应都从本线程的 arena 分配，处理完整体回收
+  utils::ArenaScope arena(utils::threadArena());
+  utils::TraceRequest trace("handleClient");
   char buffer[4096];
+  utils::TraceSpan read_span("read", "http");
   ssize_t bytes_read = SOCKET_READ(client_fd, buffer, sizeof(buffer) - 1);
+  read_span.end();
 
   if (bytes_read > 0) {
     buffer[bytes_read] = '\0';
     LOG(DEBUG) << "Received request:\n" << buffer;
 
-    HttpRequest request = HttpRequest::parse(buffer);
+    utils::TraceSpan parse_span("parse", "http");
+    HttpRequest request =
+        HttpRequest::parse(std::string_view(buffer, bytes_read));
+    parse_span.end();
     HttpResponse response;
 
-    std::string content_length;
-    auto request_headers = request.headers();
-    auto it = request_headers.find("Content-Length");
-    if (it != request_headers.end()) {
-      content_length = it->second;
-    } else {
-      content_length = "N/A";
-    }
+    std::string_view content_length =
+        request.header("Content-Length").value_or("N/A");
     LOG(INFO) << "Request: " << request.method() << " " << request.path()
               << " (Content-Length: " << content_length << ")";
     LOG(DEBUG) << "Request body: " << request.body();
 
-    auto handler = findHandler(request.method(), request.path());
-    if (handler) {
-      response = handler(request);
+    // 按 IP 限流在分发之前，被拒绝的请求不进入处理函数
+    uint32_t retry_after =
+        rateLimiter_ ? rateLimiter_->acquireForIp(client_ip, request.method(),
+                                                  request.path())
+                     : 0;
+    if (retry_after) {
+      response = tooManyRequests(retry_after);
+      LOG(WARN) << "Rate limited: " << request.method() << " "
+                << request.path();
+    } else if (const RequestHandler* handler = findHandler(request)) {
+      utils::ScopedTimer timer(handlerLatency_[handler - handlers_.data()]);
+      utils::TraceSpan span("handler", "http");
+      response = (*handler)(request);
       //   LOG(DEBUG) << "Response: " << response.toString();
     } else {
       response =
           HttpResponse(404, "{\"status\":\"error\",\"message\":\"Not found\"}");
       LOG(WARN) << "Not found: " << request.path();
     }
+    countResponse(response.statusCode());
 
     // Add CORS headers
     response.setHeader("Access-Control-Allow-Origin", "*");
     response.setHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
     response.setHeader("Access-Control-Allow-Headers", "Content-Type");
-
-    std::string response_str = response.toString();
-    ssize_t total_bytes_written = 0;
-    const char* data = response_str.c_str();
-    size_t remaining = response_str.length();
-
-    // 循环发送响应数据
-    while (remaining > 0) {
-      ssize_t bytes_written =
-          SOCKET_WRITE(client_fd, data + total_bytes_written, remaining);
-      if (bytes_written < 0) {
-        if (SOCKET_ERROR_MSG() == EINTR) {
-          continue;  // 如果被信号中断，重试
-        }
-        LOG(ERROR) << "Failed to send response: " << strerror(SOCKET_ERROR_MSG());
-        break;
-      }
-      total_bytes_written += bytes_written;
-      remaining -= bytes_written;
+    {
+      utils::TraceSpan span("compress", "http");
+      compressResponse(request, response, compression_);
     }
+    response.setHeader("Date", httpDate());
 
-    LOG(DEBUG) << "Sent " << total_bytes_written << " bytes";
+    utils::TraceSpan send_span("send", "http");
+    utils::ArenaString head = response.serializeHeaders();
+    bool ok = writeResponse(client_fd, head, response.body());
+    if (ok && response.fileBody()) {
+      ok = sendFileBody(client_fd, *response.fileBody());
+    }
+    LOG(DEBUG) << "Sent response " << response.statusCode()
+               << (ok ? "" : " (failed)");
   } else if (bytes_read < 0) {
     LOG(ERROR) << "Failed to read from client: " << strerror(SOCKET_ERROR_MSG());
   }
@@ -143,44 +241,13 @@ void HttpServer::handleClient(int client_fd) {
   SOCKET_CLOSE(client_fd);
 }
 
-void HttpServer::sendStaticFile(const std::string& absFilePath, int client_fd) {
-  struct stat sb;
-  if (stat(absFilePath.c_str(), &sb) != 0) {
-    LOG(ERROR) << "File not found: " << absFilePath;
-    HttpResponse response(404, "File not found");
-    SOCKET_WRITE(client_fd, response.toString().c_str(), response.toString().length());
-    return;
-  }
-
-  std::ifstream file(absFilePath, std::ios::binary);
-  if (!file) {
-    LOG(ERROR) << "Failed to open file: " << absFilePath;
-    HttpResponse response(500, "Internal Server Error");
-    SOCKET_WRITE(client_fd, response.toString().c_str(), response.toString().length());
-    return;
-  }
-
-  std::string content((std::istreambuf_iterator<char>(file)),
-                      std::istreambuf_iterator<char>());
-  HttpResponse response(200, content);
-  response.setHeader("Content-Length", std::to_string(content.length()));
-  SOCKET_WRITE(client_fd, response.toString().c_str(), response.toString().length());
-}
-
-HttpServer::RequestHandler HttpServer::findHandler(
-    const std::string& method, const std::string& path) const {
-  auto methodIt = handlers_.find(method);
-  if (methodIt != handlers_.end()) {
-    auto pathIt = methodIt->second.find(path);
-    if (pathIt != methodIt->second.end()) {
-      return pathIt->second;
-    }
-    // 通配符匹配
-    auto wildcardIt = methodIt->second.find("/*");
-    if (wildcardIt != methodIt->second.end()) {
-      return wildcardIt->second;
-    }
-  }
-  return nullptr;  // 没有找到处理函数
+const HttpServer::RequestHandler* HttpServer::findHandler(
+    HttpRequest& request) const {
+  PathParams params;
+  size_t index =
+      router_.find(parseMethod(request.method()), request.path(), params);
+  if (index == Router::kNotFound) return nullptr;
+  request.setPathParams(params);
+  return &handlers_[index];
 }
 }  // namespace http
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 #include <functional>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 
+#include "http_metrics.hpp"
 #include "http_request.hpp"
 #include "http_response.hpp"
+#include "rate_limiter.hpp"
+#include "response_compression.hpp"
+#include "router.hpp"
 #include "utils/thread_pool.hpp"
 
 #ifdef _WIN32
@@ -26,22 +31,29 @@ class HttpServer {
                   RequestHandler handler);
   void run();
   void stop();
+  // 在 run() 之前调用；压缩在处理请求的工作线程中完成
+  void setCompression(const CompressionOptions& options) {
+    compression_ = options;
+  }
+  // 在 run() 之前调用；limiter 由调用方持有，须比 HttpServer 活得久
+  void setRateLimiter(RateLimiter* limiter) { rateLimiter_ = limiter; }
 
  private:
   socket_t serverFd_{-1};
   int port_{0};
   std::atomic<bool> running_{false};
   utils::ThreadPool threadPool_;
-  std::string staticDir_{"./static"};
-
-  // method -> path -> handler
-  std::unordered_map<std::string,
-                     std::unordered_map<std::string, RequestHandler>>
-      handlers_;
-
-  void handleClient(int clientFd);
-  void sendStaticFile(const std::string& absFilePath, int clientFd);
-  RequestHandler findHandler(const std::string& method,
-                             const std::string& path) const;
+  CompressionOptions compression_;
+  RateLimiter* rateLimiter_{nullptr};
+
+  // 路由只保存 handlers_ 的下标，处理函数不随请求拷贝
+  Router router_;
+  std::vector<RequestHandler> handlers_;
+  std::vector<utils::Histogram> handlerLatency_;  // 与 handlers_ 一一对应
+
+  // clientIp 为网络字节序的 IPv4 地址，用于按 IP 限流
+  void handleClient(int clientFd, uint32_t clientIp);
+  // 匹配到的路径参数写入 request
+  const RequestHandler* findHandler(HttpRequest& request) const;
 };
 }  // namespace http
@@ -0,0 +1,119 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+namespace http {
+namespace {
+size_t shardOf(uint64_t key) {
+  // 乘法散列取高位，IP 这类低位相近的键也能分散
+  return (key * 0x9E3779B97F4A7C15ULL) >> 60;
+}
+}  // namespace
+
+RateLimiter::RateLimiter(const RateLimitOptions& options)
+    : options_(options), start_(Clock::now()) {
+  // 路由下标占键的低 8 位
+  if (options_.routes.size() > 255) options_.routes.resize(255);
+}
+
+uint32_t RateLimiter::acquireForIp(uint32_t ip, std::string_view method,
+                                   std::string_view path) {
+  size_t route = routeIndex(method, path);
+  uint64_t key = (static_cast<uint64_t>(ip) << 8) | route;
+  return acquire(key, route ? options_.routes[route - 1].perIp
+                            : options_.perIp);
+}
+
+uint32_t RateLimiter::acquireForUser(std::string_view user,
+                                     std::string_view method,
+                                     std::string_view path) {
+  size_t route = routeIndex(method, path);
+  uint64_t key =
+      (std::hash<std::string_view>()(user) << 8) | route | kUserBit;
+  return acquire(key, route ? options_.routes[route - 1].perUser
+                            : options_.perUser);
+}
+
+size_t RateLimiter::bucketCount() const {
+  size_t total = 0;
+  for (const Shard& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.buckets.size();
+  }
+  return total;
+}
+
+size_t RateLimiter::routeIndex(std::string_view method,
+                               std::string_view path) const {
+  for (size_t i = 0; i < options_.routes.size(); ++i) {
+    const RouteRateLimit& route = options_.routes[i];
+    if (route.path == path && route.method == method) return i + 1;
+  }
+  return 0;
+}
+
+const RateLimit& RateLimiter::limitFor(uint64_t key) const {
+  size_t route = key & 0xff;
+  bool user = key & kUserBit;
+  if (route == 0) return user ? options_.perUser : options_.perIp;
+  const RouteRateLimit& limits = options_.routes[route - 1];
+  return user ? limits.perUser : limits.perIp;
+}
+
+uint32_t RateLimiter::acquire(uint64_t key, const RateLimit& limit) {
+  if (limit.rate <= 0) return 0;
+  uint32_t nowMs = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                            start_)
+          .count());
+  Shard& shard = shards_[shardOf(key)];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto [it, inserted] = shard.buckets.try_emplace(
+      key, Bucket{static_cast<float>(limit.burst), nowMs});
+  Bucket& bucket = it->second;
+  if (!inserted) {
+    // 无符号相减，时间戳回绕（约 49 天）时差值仍然正确
+    double refill = (nowMs - bucket.lastMs) * limit.rate / 1000.0;
+    bucket.tokens = static_cast<float>(
+        std::min(limit.burst, bucket.tokens + refill));
+    bucket.lastMs = nowMs;
+  }
+
+  uint32_t retryAfter = 0;
+  if (bucket.tokens >= 1.0f) {
+    bucket.tokens -= 1.0f;
+  } else {
+    double wait = std::ceil((1.0 - bucket.tokens) / limit.rate);
+    retryAfter = std::max<uint32_t>(1, static_cast<uint32_t>(wait));
+  }
+  if (inserted && shard.buckets.size() >= shard.sweepAt) sweep(shard, nowMs);
+  return retryAfter;
+}
+
+bool RateLimiter::refilled(const Bucket& bucket, const RateLimit& limit,
+                           uint32_t nowMs) {
+  double refill = (nowMs - bucket.lastMs) * limit.rate / 1000.0;
+  return bucket.tokens + refill >= limit.burst;
+}
+
+void RateLimiter::sweep(Shard& shard, uint32_t nowMs) {
+  for (auto it = shard.buckets.begin(); it != shard.buckets.end();) {
+    if (refilled(it->second, limitFor(it->first), nowMs)) {
+      it = shard.buckets.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  // 下次清理等到桶数再翻一倍，均摊到每次插入是常数时间
+  shard.sweepAt = std::max(kMinSweep, shard.buckets.size() * 2);
+}
+
+HttpResponse tooManyRequests(uint32_t retryAfterSeconds) {
+  HttpResponse response(429, "{\"error\":\"Too many requests\"}");
+  response.setHeader("Content-Type", "application/json");
+  response.setHeader("Retry-After", std::to_string(retryAfterSeconds));
+  return response;
+}
+}  // namespace http
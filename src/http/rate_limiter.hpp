@@ -0,0 +1,98 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "http_response.hpp"
+
+namespace http {
+// 令牌桶参数：每秒补充 rate 个令牌，最多攒 burst 个；rate <= 0 表示不限制
+struct RateLimit {
+  double rate = 0;
+  double burst = 0;
+};
+
+// 单个路由的限制，按方法和路径（注册时的写法）精确匹配，替换默认限制
+struct RouteRateLimit {
+  std::string method;
+  std::string path;
+  RateLimit perIp;
+  RateLimit perUser;
+};
+
+/**
+ * @brief 请求限流配置，默认关闭
+ * perIp 按客户端 IP 计数，在分发前检查；perUser 按会话用户计数，
+ * 在解析请求体和访问数据库之前检查。
+ */
+struct RateLimitOptions {
+  bool enabled = false;
+  RateLimit perIp{50, 100};
+  RateLimit perUser{10, 20};
+  std::vector<RouteRateLimit> routes = {
+      {"POST", "/login", {2, 10}, {}},
+      {"POST", "/register", {1, 5}, {}},
+      {"POST", "/send_message", {20, 40}, {5, 20}},
+  };
+};
+
+/**
+ * @brief 按 IP 和用户的令牌桶限流器
+ * 每个（键, 路由）一个 8 字节的桶，访问时按流逝的时间补充令牌，
+ * 不需要定时器。分片加锁，分片中的桶数翻倍时顺带清理已经补满的桶，
+ * 补满的桶与不存在等价，清理不改变限流结果。
+ * 线程安全。
+ */
+class RateLimiter {
+ public:
+  static constexpr size_t kShards = 16;
+
+  explicit RateLimiter(const RateLimitOptions& options);
+
+  RateLimiter(const RateLimiter&) = delete;
+  RateLimiter& operator=(const RateLimiter&) = delete;
+
+  // 各取一个令牌：返回 0 表示放行，否则为建议的 Retry-After 秒数
+  uint32_t acquireForIp(uint32_t ip, std::string_view method,
+                        std::string_view path);
+  uint32_t acquireForUser(std::string_view user, std::string_view method,
+                          std::string_view path);
+
+  size_t bucketCount() const;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  struct Bucket {
+    float tokens;
+    uint32_t lastMs;  // 相对 start_ 的毫秒数
+  };
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<uint64_t, Bucket> buckets;
+    size_t sweepAt = kMinSweep;
+  };
+  static constexpr size_t kMinSweep = 1024;
+  // 键的最高位区分用户和 IP，低 8 位是路由下标（0 为默认）
+  static constexpr uint64_t kUserBit = 1ULL << 63;
+
+  // 0 为默认限制，i + 1 对应 options.routes[i]
+  size_t routeIndex(std::string_view method, std::string_view path) const;
+  const RateLimit& limitFor(uint64_t key) const;
+  uint32_t acquire(uint64_t key, const RateLimit& limit);
+  static bool refilled(const Bucket& bucket, const RateLimit& limit,
+                       uint32_t nowMs);
+  void sweep(Shard& shard, uint32_t nowMs);
+
+  RateLimitOptions options_;
+  Clock::time_point start_;
+  Shard shards_[kShards];
+};
+
+// 429 响应，带 Retry-After
+HttpResponse tooManyRequests(uint32_t retryAfterSeconds);
+}  // namespace http
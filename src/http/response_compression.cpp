@@ -0,0 +1,57 @@
+#include "response_compression.hpp"
+
+#include <string>
+
+namespace http {
+utils::ContentEncoding chooseEncoding(const HttpRequest& request,
+                                      const HttpResponse& response,
+                                      const CompressionOptions& options) {
+  return chooseEncoding(request.header("Accept-Encoding"), response, options);
+}
+
+utils::ContentEncoding chooseEncoding(
+    std::optional<std::string_view> acceptEncoding,
+    const HttpResponse& response, const CompressionOptions& options) {
+  using utils::ContentEncoding;
+  if (!options.enabled || response.fileBody() ||
+      response.body().size() < options.minSize ||
+      response.header("Content-Encoding")) {
+    return ContentEncoding::Identity;
+  }
+  auto contentType = response.header("Content-Type");
+  if (!contentType || !utils::compressibleContentType(*contentType)) {
+    return ContentEncoding::Identity;
+  }
+  if (!acceptEncoding) return ContentEncoding::Identity;
+  return utils::negotiateEncoding(
+      *acceptEncoding,
+      utils::contentEncodingAvailable(ContentEncoding::Gzip),
+      utils::contentEncodingAvailable(ContentEncoding::Brotli));
+}
+
+bool compressResponse(const HttpRequest& request, HttpResponse& response,
+                      const CompressionOptions& options) {
+  return compressResponse(request.header("Accept-Encoding"), response,
+                          options);
+}
+
+bool compressResponse(std::optional<std::string_view> acceptEncoding,
+                      HttpResponse& response,
+                      const CompressionOptions& options) {
+  utils::ContentEncoding encoding =
+      chooseEncoding(acceptEncoding, response, options);
+  if (encoding == utils::ContentEncoding::Identity) return false;
+  // 输出缓冲按线程复用，容量随最大响应增长后不再分配
+  thread_local std::string buffer;
+  if (!utils::compressTo(encoding, response.body(),
+                         options.levelFor(encoding), buffer) ||
+      buffer.size() >= response.body().size()) {
+    return false;
+  }
+  response.setBody(buffer);
+  response.setHeader("Content-Encoding",
+                     utils::contentEncodingName(encoding));
+  response.setHeader("Vary", "Accept-Encoding");
+  return true;
+}
+}  // namespace http
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "utils/compress.hpp"
+
+namespace http {
+/**
+ * @brief 动态响应压缩配置，默认关闭
+ * 只压缩不小于 minSize 的文本响应。级别越高越省带宽、越耗 CPU，
+ * 各级别的取舍见 bench/bench_compression.cpp。
+ * workerThreads 只对 epoll 服务器有效：大于 0 时压缩交给线程池，
+ * 不阻塞事件循环。
+ */
+struct CompressionOptions {
+  bool enabled = false;
+  size_t minSize = 1024;
+  int gzipLevel = 6;
+  int brotliQuality = 4;
+  size_t workerThreads = 0;
+
+  int levelFor(utils::ContentEncoding encoding) const {
+    return encoding == utils::ContentEncoding::Brotli ? brotliQuality
+                                                      : gzipLevel;
+  }
+};
+
+// 该响应应使用的编码；不满足压缩条件时返回 Identity
+utils::ContentEncoding chooseEncoding(const HttpRequest& request,
+                                      const HttpResponse& response,
+                                      const CompressionOptions& options);
+
+// 按 chooseEncoding 的结果就地压缩响应体，并设置 Content-Encoding 和 Vary。
+// 使用本线程复用的压缩缓冲，返回是否压缩
+bool compressResponse(const HttpRequest& request, HttpResponse& response,
+                      const CompressionOptions& options);
+
+// 同上，只需要请求的 Accept-Encoding 头。请求报文已释放时（如处理函数
+// 挂起后恢复）使用
+utils::ContentEncoding chooseEncoding(
+    std::optional<std::string_view> acceptEncoding,
+    const HttpResponse& response, const CompressionOptions& options);
+bool compressResponse(std::optional<std::string_view> acceptEncoding,
+                      HttpResponse& response,
+                      const CompressionOptions& options);
+}  // namespace http
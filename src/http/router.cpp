@@ -0,0 +1,192 @@
+#include "router.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace http {
+namespace {
+// "/a/b" -> 段 "a"，剩余 "/b"；"/" -> 段 ""，剩余 ""
+std::string_view nextSegment(std::string_view& rest) {
+  rest.remove_prefix(1);  // 跳过 '/'
+  size_t slash = rest.find('/');
+  std::string_view segment = rest.substr(0, slash);
+  rest = slash == std::string_view::npos ? std::string_view()
+                                         : rest.substr(slash);
+  return segment;
+}
+
+// 子节点按加入顺序存放，长度不同的段只比较一次整数
+template <typename Children>
+auto findChild(Children& children, std::string_view segment) {
+  return std::find_if(children.begin(), children.end(),
+                      [segment](const auto& child) {
+                        return child.first.size() == segment.size() &&
+                               child.first == segment;
+                      });
+}
+
+// 根路径 "/" 视为零段
+std::string_view normalize(std::string_view path) {
+  return path == "/" ? std::string_view() : path;
+}
+}  // namespace
+
+Method parseMethod(std::string_view method) {
+  switch (method.size()) {
+    case 3:
+      if (method == "GET") return Method::Get;
+      if (method == "PUT") return Method::Put;
+      break;
+    case 4:
+      if (method == "POST") return Method::Post;
+      if (method == "HEAD") return Method::Head;
+      break;
+    case 5:
+      if (method == "PATCH") return Method::Patch;
+      break;
+    case 6:
+      if (method == "DELETE") return Method::Delete;
+      break;
+    case 7:
+      if (method == "OPTIONS") return Method::Options;
+      break;
+  }
+  return Method::Unknown;
+}
+
+Router::Router() { newNode(); }
+
+uint32_t Router::newNode() {
+  nodes_.emplace_back();
+  nodes_.back().handlers.fill(kNotFound);
+  return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void Router::add(Method method, std::string_view pattern, size_t handler) {
+  if (pattern.empty() || pattern.front() != '/') {
+    throw std::invalid_argument("route must start with '/'");
+  }
+  uint32_t index = 0;
+  size_t paramCount = 0;
+  std::string_view rest = normalize(pattern);
+  while (!rest.empty()) {
+    std::string_view segment = nextSegment(rest);
+    if (segment == "*" || (!segment.empty() && segment.front() == ':')) {
+      if (++paramCount > PathParams::kMax) {
+        throw std::invalid_argument("too many route parameters");
+      }
+    }
+    // nodes_ 可能扩容，每次都通过下标重新取节点
+    if (segment == "*") {
+      if (!rest.empty()) {
+        throw std::invalid_argument("'*' must be the last route segment");
+      }
+      if (nodes_[index].wildcard == kNone) {
+        uint32_t child = newNode();
+        nodes_[index].wildcard = child;
+      }
+      index = nodes_[index].wildcard;
+    } else if (!segment.empty() && segment.front() == ':') {
+      if (nodes_[index].param == kNone) {
+        uint32_t child = newNode();
+        nodes_[index].param = child;
+        nodes_[index].paramName = std::string(segment.substr(1));
+      } else if (nodes_[index].paramName != segment.substr(1)) {
+        throw std::invalid_argument("conflicting route parameter names");
+      }
+      index = nodes_[index].param;
+    } else {
+      auto& children = nodes_[index].children;
+      auto it = findChild(children, segment);
+      if (it != children.end()) {
+        index = it->second;
+      } else {
+        uint32_t child = newNode();
+        nodes_[index].children.emplace_back(std::string(segment), child);
+        index = child;
+      }
+    }
+  }
+  nodes_[index].handlers[static_cast<size_t>(method)] = handler;
+  if (paramCount == 0) addExact(pattern, index);
+}
+
+void Router::addExact(std::string_view path, uint32_t node) {
+  if (findExact(path) != kNone) return;
+  std::vector<ExactSlot> old;
+  old.swap(exact_);
+  size_t count = 1;
+  for (const auto& slot : old) count += slot.node != kNone;
+  // 装载因子不超过 1/2，线性探测平均一两次就能命中或遇到空槽
+  size_t capacity = 8;
+  while (capacity < count * 2) capacity *= 2;
+  exact_.resize(capacity);
+  for (auto& slot : old) {
+    if (slot.node != kNone) insertExact(std::move(slot.path), slot.node);
+  }
+  insertExact(std::string(path), node);
+}
+
+void Router::insertExact(std::string path, uint32_t node) {
+  size_t mask = exact_.size() - 1;
+  size_t i = std::hash<std::string_view>()(path) & mask;
+  while (exact_[i].node != kNone) i = (i + 1) & mask;
+  exact_[i].path = std::move(path);
+  exact_[i].node = node;
+}
+
+uint32_t Router::findExact(std::string_view path) const {
+  if (exact_.empty()) return kNone;
+  size_t mask = exact_.size() - 1;
+  for (size_t i = std::hash<std::string_view>()(path) & mask;
+       exact_[i].node != kNone; i = (i + 1) & mask) {
+    if (exact_[i].path == path) return exact_[i].node;
+  }
+  return kNone;
+}
+
+size_t Router::find(Method method, std::string_view path,
+                    PathParams& params) const {
+  if (path.empty() || path.front() != '/') return kNotFound;
+  // 不含参数的路由先查哈希表，命中时不用逐段走树
+  uint32_t exact = findExact(path);
+  if (exact != kNone) {
+    size_t handler = nodes_[exact].handlers[static_cast<size_t>(method)];
+    if (handler != kNotFound) return handler;
+  }
+  return match(0, method, normalize(path), params);
+}
+
+size_t Router::match(uint32_t index, Method method, std::string_view rest,
+                     PathParams& params) const {
+  const Node& node = nodes_[index];
+  if (rest.empty()) {
+    size_t handler = node.handlers[static_cast<size_t>(method)];
+    if (handler != kNotFound) return handler;
+  } else {
+    std::string_view tail = rest;
+    std::string_view segment = nextSegment(tail);
+    auto it = findChild(node.children, segment);
+    if (it != node.children.end()) {
+      size_t handler = match(it->second, method, tail, params);
+      if (handler != kNotFound) return handler;
+    }
+    if (node.param != kNone && !segment.empty()) {
+      params.push(node.paramName, segment);
+      size_t handler = match(node.param, method, tail, params);
+      if (handler != kNotFound) return handler;
+      params.pop();
+    }
+  }
+  if (node.wildcard != kNone) {
+    size_t handler =
+        nodes_[node.wildcard].handlers[static_cast<size_t>(method)];
+    if (handler != kNotFound) {
+      params.push("*", rest.empty() ? rest : rest.substr(1));
+      return handler;
+    }
+  }
+  return kNotFound;
+}
+}  // namespace http
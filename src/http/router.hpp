@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "http_request.hpp"
+
+namespace http {
+enum class Method : uint8_t {
+  Get,
+  Head,
+  Post,
+  Put,
+  Delete,
+  Options,
+  Patch,
+  Unknown,
+};
+constexpr size_t kMethodCount = static_cast<size_t>(Method::Unknown) + 1;
+
+Method parseMethod(std::string_view method);
+
+/**
+ * @brief 按路径段组织的前缀树路由
+ * 启动时注册，节点存放在一个连续数组里，运行时只读（多线程查找安全）。
+ * 不含参数的路由另外放进整路径哈希表，查找时先查表，未命中再走树。
+ * 每段依次尝试：静态段 > ":name" 参数段 > "*" 通配，
+ * 静态段在更深处失败时回溯到参数段。
+ * "*" 只能是最后一段，匹配剩余路径（可以为空），参数名为 "*"。
+ * find 返回注册时给出的处理函数下标，不拷贝处理函数。
+ */
+class Router {
+ public:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  Router();
+
+  // 同一方法和路径重复注册时后者覆盖
+  void add(Method method, std::string_view pattern, size_t handler);
+  // 匹配到的路径参数追加到 params，值指向 path
+  size_t find(Method method, std::string_view path, PathParams& params) const;
+
+ private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  struct Node {
+    std::vector<std::pair<std::string, uint32_t>> children;  // 静态段
+    uint32_t param{kNone};
+    std::string paramName;
+    uint32_t wildcard{kNone};
+    std::array<size_t, kMethodCount> handlers;
+  };
+
+  // 不含参数和通配的路由：整条路径 -> 节点，开放寻址哈希表
+  struct ExactSlot {
+    std::string path;
+    uint32_t node{kNone};
+  };
+
+  uint32_t newNode();
+  void addExact(std::string_view path, uint32_t node);
+  void insertExact(std::string path, uint32_t node);
+  uint32_t findExact(std::string_view path) const;
+  size_t match(uint32_t index, Method method, std::string_view rest,
+               PathParams& params) const;
+
+  std::vector<Node> nodes_;  // nodes_[0] 为根节点
+  std::vector<ExactSlot> exact_;
+};
+}  // namespace http
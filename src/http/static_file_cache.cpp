@@ -0,0 +1,336 @@
+#include "static_file_cache.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+
+#include "utils/logger.hpp"
+
+namespace fs = std::filesystem;
+
+namespace http {
+namespace {
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string contentTypeFor(const fs::path& file) {
+  std::string ext = file.extension().string();
+  if (ext == ".html" || ext == ".htm") return "text/html";
+  if (ext == ".css") return "text/css";
+  if (ext == ".js") return "application/javascript";
+  if (ext == ".json") return "application/json";
+  if (ext == ".svg") return "image/svg+xml";
+  if (ext == ".png") return "image/png";
+  if (ext == ".jpg" || ext == ".jpeg") return "image/jpeg";
+  if (ext == ".ico") return "image/x-icon";
+  return "text/plain";
+}
+
+// FNV-1a，作为强 ETag 足够区分同一路径的不同内容
+std::string contentHash(std::string_view data) {
+  uint64_t hash = 14695981039346656037ull;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ull;
+  }
+  static const char kHex[] = "0123456789abcdef";
+  std::string out(16, '0');
+  for (int i = 15; i >= 0; --i, hash >>= 4) out[i] = kHex[hash & 0xf];
+  return out;
+}
+
+bool unchanged(const StaticFileCache::Asset& asset,
+               const std::optional<fs::path>& file) {
+  if (!file) return false;
+  std::error_code ec;
+  auto mtime = fs::last_write_time(*file, ec);
+  if (ec || mtime != asset.mtime) return false;
+  auto size = fs::file_size(*file, ec);
+  return !ec && size == asset.size;
+}
+
+enum class RangeResult { None, Satisfiable, Unsatisfiable };
+
+bool parseNumber(std::string_view text, uint64_t& value) {
+  if (text.empty()) return false;
+  auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+  return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// 只支持单段 bytes=first-last / first- / -suffix，其余写法按没有 Range 处理
+RangeResult parseRange(std::string_view range, uint64_t size, uint64_t& first,
+                       uint64_t& last) {
+  if (range.substr(0, 6) != "bytes=") return RangeResult::None;
+  range.remove_prefix(6);
+  size_t dash = range.find('-');
+  if (dash == std::string_view::npos ||
+      range.find(',') != std::string_view::npos) {
+    return RangeResult::None;
+  }
+  std::string_view begin = range.substr(0, dash);
+  std::string_view end = range.substr(dash + 1);
+  if (begin.empty()) {
+    uint64_t suffix;
+    if (!parseNumber(end, suffix)) return RangeResult::None;
+    if (suffix == 0 || size == 0) return RangeResult::Unsatisfiable;
+    first = suffix >= size ? 0 : size - suffix;
+    last = size - 1;
+    return RangeResult::Satisfiable;
+  }
+  if (!parseNumber(begin, first)) return RangeResult::None;
+  if (end.empty()) {
+    last = size - 1;
+  } else if (!parseNumber(end, last) || last < first) {
+    return RangeResult::None;
+  }
+  if (first >= size) return RangeResult::Unsatisfiable;
+  if (last >= size) last = size - 1;
+  return RangeResult::Satisfiable;
+}
+
+// If-None-Match 按弱比较匹配，支持列表和 *
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+  while (!ifNoneMatch.empty()) {
+    size_t comma = ifNoneMatch.find(',');
+    std::string_view tag = ifNoneMatch.substr(0, comma);
+    size_t begin = tag.find_first_not_of(" \t");
+    size_t end = tag.find_last_not_of(" \t");
+    if (begin != std::string_view::npos) {
+      tag = tag.substr(begin, end - begin + 1);
+      if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+      if (tag == "*" || tag == etag) return true;
+    }
+    if (comma == std::string_view::npos) break;
+    ifNoneMatch.remove_prefix(comma + 1);
+  }
+  return false;
+}
+}  // namespace
+
+const StaticFileCache::Variant& StaticFileCache::Asset::variant(
+    utils::ContentEncoding encoding) const {
+  switch (encoding) {
+    case utils::ContentEncoding::Gzip:
+      return gzip;
+    case utils::ContentEncoding::Brotli:
+      return brotli;
+    default:
+      return identity;
+  }
+}
+
+StaticFileCache::StaticFileCache(std::string rootDir, uintmax_t maxCachedSize)
+    : rootDir_(std::move(rootDir)), maxCachedSize_(maxCachedSize) {
+  std::error_code ec;
+  int64_t now = nowMs();
+  for (fs::recursive_directory_iterator it(rootDir_, ec), end;
+       !ec && it != end; it.increment(ec)) {
+    if (!it->is_regular_file()) continue;
+    auto asset = load(it->path());
+    if (!asset) continue;
+    std::string path =
+        "/" + it->path().lexically_relative(rootDir_).generic_string();
+    Entry& entry = entries_[path];
+    entry.asset = std::move(asset);
+    entry.checkedAtMs = now;
+  }
+  LOG(INFO) << "Static file cache loaded " << entries_.size()
+            << " files from " << rootDir_;
+}
+
+size_t StaticFileCache::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return entries_.size();
+}
+
+HttpResponse StaticFileCache::respond(const HttpRequest& request) {
+  std::string_view path = request.path();
+  if (path.empty() || path == "/") path = "/login.html";
+
+  auto asset = find(path);
+  if (!asset) {
+    LOG(WARN) << "File not found: " << path;
+    utils::ArenaString body =
+        "<html><body><h1>404 Not Found</h1><p>File not found: ";
+    body.append(path.data(), path.size());
+    body += "</p></body></html>";
+    HttpResponse response(404);
+    response.setHeader("Content-Type", "text/html");
+    response.setBody(body);
+    return response;
+  }
+
+  auto encoding = utils::negotiateEncoding(
+      request.header("Accept-Encoding").value_or(""), !asset->gzip.body.empty(),
+      !asset->brotli.body.empty());
+  const Variant* variant = &asset->variant(encoding);
+  bool notModified =
+      etagMatches(request.header("If-None-Match").value_or(""), variant->etag);
+
+  // Range 只作用于未压缩版本，If-Range 与当前 ETag 不一致时返回完整内容
+  uint64_t first = 0;
+  uint64_t last = 0;
+  RangeResult range = RangeResult::None;
+  auto rangeHeader = request.header("Range");
+  auto ifRange = request.header("If-Range");
+  if (!notModified && rangeHeader &&
+      (!ifRange || *ifRange == asset->identity.etag)) {
+    range = parseRange(*rangeHeader, asset->size, first, last);
+  }
+  if (range != RangeResult::None) {
+    encoding = utils::ContentEncoding::Identity;
+    variant = &asset->identity;
+  }
+
+  int status = 200;
+  if (notModified) {
+    status = 304;
+  } else if (range == RangeResult::Satisfiable) {
+    status = 206;
+  } else if (range == RangeResult::Unsatisfiable) {
+    status = 416;
+  }
+  HttpResponse response(status);
+  response.setHeader("Content-Type", asset->contentType);
+  response.setHeader("ETag", variant->etag);
+  response.setHeader("Cache-Control", asset->cacheControl);
+  response.setHeader("Vary", "Accept-Encoding");
+  response.setHeader("Accept-Ranges", "bytes");
+  if (encoding != utils::ContentEncoding::Identity) {
+    response.setHeader("Content-Encoding",
+                       utils::contentEncodingName(encoding));
+  }
+
+  char contentRange[64];
+  if (status == 416) {
+    snprintf(contentRange, sizeof(contentRange), "bytes */%ju", asset->size);
+    response.setHeader("Content-Range", contentRange);
+    return response;
+  }
+  if (status == 304) return response;
+
+  uint64_t offset = 0;
+  uint64_t length = asset->size;
+  if (status == 206) {
+    offset = first;
+    length = last - first + 1;
+    snprintf(contentRange, sizeof(contentRange), "bytes %llu-%llu/%ju",
+             static_cast<unsigned long long>(first),
+             static_cast<unsigned long long>(last), asset->size);
+    response.setHeader("Content-Range", contentRange);
+  }
+  if (!asset->inMemory) {
+    response.setFileBody(asset->file, offset, length);
+  } else if (status == 206) {
+    response.setBody(std::string_view(variant->body).substr(offset, length));
+  } else {
+    response.setBody(variant->body);
+  }
+  return response;
+}
+
+std::shared_ptr<const StaticFileCache::Asset> StaticFileCache::find(
+    std::string_view path) {
+  int64_t now = nowMs();
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = entries_.find(path);
+    if (it != entries_.end()) {
+      Entry& entry = it->second;
+      int64_t checked = entry.checkedAtMs.load(std::memory_order_relaxed);
+      // 未到检查间隔，或者其他线程正在检查，直接用缓存
+      if (now - checked < kRecheckIntervalMs ||
+          !entry.checkedAtMs.compare_exchange_strong(checked, now)) {
+        return entry.asset;
+      }
+      if (unchanged(*entry.asset, resolve(path))) return entry.asset;
+    }
+  }
+
+  // 未命中或文件已变化，重新从磁盘加载
+  auto file = resolve(path);
+  auto asset = file ? load(*file) : nullptr;
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  auto it = entries_.find(path);
+  if (!asset) {
+    if (it != entries_.end()) entries_.erase(it);
+    return nullptr;
+  }
+  if (it == entries_.end()) {
+    it = entries_.try_emplace(std::string(path)).first;
+  }
+  it->second.asset = asset;
+  it->second.checkedAtMs = now;
+  LOG(INFO) << "Static file (re)loaded: " << path;
+  return asset;
+}
+
+std::optional<fs::path> StaticFileCache::resolve(std::string_view path) const {
+  if (path.empty() || path.front() != '/') return std::nullopt;
+  fs::path relative =
+      fs::path(std::string(path.substr(1))).lexically_normal();
+  // 拒绝 ../ 等越出根目录的路径
+  if (relative.empty() || relative.is_absolute() ||
+      *relative.begin() == "..") {
+    return std::nullopt;
+  }
+  return fs::path(rootDir_) / relative;
+}
+
+std::shared_ptr<const StaticFileCache::Asset> StaticFileCache::load(
+    const fs::path& file) const {
+  std::error_code ec;
+  if (!fs::is_regular_file(file, ec)) return nullptr;
+  auto mtime = fs::last_write_time(file, ec);
+  if (ec) return nullptr;
+  auto size = fs::file_size(file, ec);
+  if (ec) return nullptr;
+
+  auto asset = std::make_shared<Asset>();
+  asset->file = file.string();
+  asset->mtime = mtime;
+  asset->size = size;
+  asset->contentType = contentTypeFor(file);
+  // 页面每次都向服务器验证，其余资源缓存一小时
+  asset->cacheControl = asset->contentType == "text/html"
+                            ? "no-cache"
+                            : "public, max-age=3600";
+  if (size > maxCachedSize_) {
+    // 大文件不读入内存，ETag 由大小和 mtime 生成
+    asset->inMemory = false;
+    char etag[48];
+    snprintf(etag, sizeof(etag), "\"%jx-%llx\"", size,
+             static_cast<unsigned long long>(mtime.time_since_epoch().count()));
+    asset->identity.etag = etag;
+    return asset;
+  }
+
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    LOG(ERROR) << "Failed to open file: " << file;
+    return nullptr;
+  }
+  std::string content((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+  asset->size = content.size();
+  std::string hash = contentHash(content);
+  if (utils::compressibleContentType(asset->contentType)) {
+    auto gzip = utils::gzipCompress(content);
+    if (gzip && gzip->size() < content.size()) {
+      asset->gzip = {std::move(*gzip), "\"" + hash + "-gzip\""};
+    }
+    auto brotli = utils::brotliCompress(content);
+    if (brotli && brotli->size() < content.size()) {
+      asset->brotli = {std::move(*brotli), "\"" + hash + "-br\""};
+    }
+  }
+  asset->identity = {std::move(content), "\"" + hash + "\""};
+  return asset;
+}
+}  // namespace http
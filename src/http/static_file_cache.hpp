@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include "http_request.hpp"
+#include "http_response.hpp"
+#include "utils/compress.hpp"
+
+namespace http {
+/**
+ * @brief 静态资源内存缓存
+ * 启动时加载目录下的所有文件，预先算好 Content-Type、Cache-Control、强 ETag
+ * 以及 gzip/br 压缩版本（压缩后没有变小则不保留）。命中时按 Accept-Encoding
+ * 选择版本，If-None-Match 匹配时返回 304。
+ * 超过 maxCachedSize 的文件只记录元数据，响应体为 FileBody，由服务器用
+ * sendfile 发送，不压缩。支持单段 Range/If-Range（只针对未压缩版本）。
+ * 每个文件最多每秒 stat 一次，mtime 或大小变化时重新加载；缓存里没有的路径
+ * 会尝试从磁盘加载，因此启动后新增的文件也能访问。线程安全。
+ */
+class StaticFileCache {
+ public:
+  struct Variant {
+    std::string body;  // 为空表示没有该编码的版本
+    std::string etag;
+  };
+  struct Asset {
+    std::string file;  // 磁盘路径
+    bool inMemory{true};
+    std::string contentType;
+    std::string cacheControl;
+    Variant identity;
+    Variant gzip;
+    Variant brotli;
+    std::filesystem::file_time_type mtime;
+    uintmax_t size{0};
+
+    const Variant& variant(utils::ContentEncoding encoding) const;
+  };
+
+  static constexpr uintmax_t kDefaultMaxCachedSize = 64 * 1024;
+
+  explicit StaticFileCache(std::string rootDir,
+                           uintmax_t maxCachedSize = kDefaultMaxCachedSize);
+
+  // 生成 200/206/304/404/416 响应，"/" 映射到 /login.html
+  HttpResponse respond(const HttpRequest& request);
+  // path 为 URL 路径，文件不存在时返回 nullptr
+  std::shared_ptr<const Asset> find(std::string_view path);
+
+  size_t size() const;
+
+ private:
+  struct Entry {
+    std::shared_ptr<const Asset> asset;
+    std::atomic<int64_t> checkedAtMs{0};
+  };
+  static constexpr int64_t kRecheckIntervalMs = 1000;
+
+  std::optional<std::filesystem::path> resolve(std::string_view path) const;
+  std::shared_ptr<const Asset> load(const std::filesystem::path& file) const;
+
+  std::string rootDir_;
+  uintmax_t maxCachedSize_;
+  mutable std::shared_mutex mutex_;
+  std::map<std::string, Entry, std::less<>> entries_;
+};
+}  // namespace http
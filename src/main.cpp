@@ -1,20 +1,24 @@
 #include <unistd.h>
 
-#include <atomic>
-#include <chrono>
 #include <csignal>
+#include <functional>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include "chatroom_server.hpp"
 #include "chatroom_server_epoll.hpp"
 #include "http/socket_compat.hpp"
+#include "multi_reactor_server.hpp"
+#include "transport_options.hpp"
 #include "utils/logger.hpp"
+#include "utils/tracing.hpp"
 
-std::atomic<bool> running{true};
-// ========== 换 ==========
-ChatroomServer* global_application = nullptr;
-// ChatroomServerEpoll* global_application = nullptr;  // epoll
+// 当前传输方式的 stopServer()
+std::function<void()> global_stop;
 
 /**
  * @brief 信号处理函数
@@ -22,10 +26,7 @@ ChatroomServer* global_application = nullptr;
  */
 void signalHandler(int sig) {
   LOG(INFO) << "Received signal " << sig << ", shutting down...";
-  running = false;
-  if (global_application) {
-    global_application->stopServer();
-  }
+  if (global_stop) global_stop();
 }
 
 /**
@@ -59,34 +60,61 @@ int main(int argc, char* argv[]) {
     // 注册信号处理，保证可以优雅退出
     setupSignalHandlers();
 
+    std::vector<std::string> args(argv + 1, argv + argc);
+    TransportOptions transport = parseTransport(args);
+    size_t argCount = args.size();
+
     int port = 8080;
     std::string static_dir_path = "static";
     std::string db_file_path = "chat.db";
 
-    if (argc > 1) port = std::stoi(argv[1]);
-    if (argc > 2) static_dir_path = argv[2];
-    if (argc > 3) db_file_path = argv[3];
-
-    // ============== 换 ==============
-    ChatroomServer app(static_dir_path, db_file_path, port, "localhost:9092");
-    // ChatroomServerEpoll app(static_dir_path, db_file_path, port,
-    //                         "localhost:9092"); // epoll
-    global_application = &app;
-
-    LOG(INFO) << "Server listening on port " << port;
-
-    app.startServer();
-
-    LOG(INFO) << "Server running. Press Ctrl+C to stop.";
-
-    // 主循环，等待信号终止
-    while (running) {
-      std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
-
-    if (global_application) {
-      global_application->stopServer();
-      global_application = nullptr;
+    if (argCount > 0) port = std::stoi(args[0]);
+    if (argCount > 1) static_dir_path = args[1];
+    if (argCount > 2) db_file_path = args[2];
+    // 第 4 个参数为动态响应的 gzip 压缩级别，0 或不传表示不压缩
+    http::CompressionOptions compression;
+    if (argCount > 3) compression.gzipLevel = std::stoi(args[3]);
+    compression.enabled = argCount > 3 && compression.gzipLevel > 0;
+    // 第 5 个参数为每个 IP 每秒的请求数，0 或不传表示不限流；
+    // 其余限制（按用户、按路由）使用 RateLimitOptions 的默认值
+    http::RateLimitOptions rateLimit;
+    if (argCount > 4) rateLimit.perIp.rate = std::stod(args[4]);
+    rateLimit.perIp.burst = rateLimit.perIp.rate * 2;
+    rateLimit.enabled = argCount > 4 && rateLimit.perIp.rate > 0;
+    // 第 6 个参数为追踪的采样率（0 到 1），0 或不传表示关闭，
+    // 开启后 GET /debug/trace 导出最近的采样
+    if (argCount > 5) utils::tracer().setSampleRate(std::stod(args[5]));
+
+    // 三种传输方式的接口相同：startServer() 阻塞到 stopServer() 被调用
+    auto run = [&](auto& app) {
+      app.setCompression(compression);
+      app.setRateLimit(rateLimit);
+      global_stop = [&app]() { app.stopServer(); };
+      LOG(INFO) << "Server listening on port " << port;
+      app.startServer();
+      global_stop = nullptr;
+      app.stopServer();
+    };
+    if (transport.transport == Transport::Threaded) {
+      LOG(INFO) << "Transport: threaded";
+      ChatroomServer app(static_dir_path, db_file_path, port, "localhost:9092");
+      run(app);
+    } else if (transport.transport == Transport::Epoll) {
+      LOG(INFO) << "Transport: epoll";
+      ChatroomServerEpoll app(static_dir_path, db_file_path, port,
+                              "localhost:9092");
+      if (transport.io) app.setIoBackend(*transport.io);
+      run(app);
+    } else {
+      int loops = transport.loops > 0
+                      ? transport.loops
+                      : static_cast<int>(std::thread::hardware_concurrency());
+      LOG(INFO) << "Transport: multi-reactor, " << loops << " loops";
+      MultiReactorServer app(static_dir_path, db_file_path, port, loops,
+                             "localhost:9092");
+      if (transport.io) app.setIoBackend(*transport.io);
+      if (transport.roomAffinity) app.enableRoomAffinity();
+      run(app);
     }
 
     LOG(INFO) << "Server shutdown complete";
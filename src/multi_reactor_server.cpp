@@ -0,0 +1,71 @@
+#include "multi_reactor_server.hpp"
+
+#include <algorithm>
+
+#include "utils/logger.hpp"
+
+MultiReactorServer::MultiReactorServer(const std::string& static_dir_path,
+                                       const std::string& db_file_path,
+                                       int port, int loops,
+                                       const std::string& kafka_brokers)
+    : service_(std::make_shared<ChatService>(db_file_path, kafka_brokers)) {
+  loops = std::max(loops, 1);
+  // 第一个循环先绑定，port 为 0 时其余循环复用系统分配的端口
+  for (int i = 0; i < loops; ++i) {
+    servers_.push_back(std::make_unique<ChatroomServerEpoll>(
+        service_, static_dir_path, i == 0 ? port : port_, true));
+    port_ = servers_.front()->port();
+  }
+  LOG(INFO) << "Multi-reactor server: " << loops << " loops on port "
+            << port_;
+}
+
+MultiReactorServer::~MultiReactorServer() {
+  if (threads_.empty()) return;
+  stopServer();
+  joinLoops();
+}
+
+void MultiReactorServer::setCompression(
+    const http::CompressionOptions& options) {
+  for (auto& server : servers_) server->setCompression(options);
+}
+
+void MultiReactorServer::setAdmission(
+    const ChatroomServerEpoll::AdmissionOptions& options) {
+  for (auto& server : servers_) server->setAdmission(options);
+}
+
+bool MultiReactorServer::setIoBackend(reactor::IoBackend backend) {
+  for (auto& server : servers_) {
+    if (!server->setIoBackend(backend)) return false;
+  }
+  return true;
+}
+
+void MultiReactorServer::enableRoomAffinity() {
+  roomShards_ = std::make_unique<RoomShards>(servers_.size());
+  service_->setRoomShards(roomShards_.get());
+  for (size_t i = 0; i < servers_.size(); ++i) {
+    servers_[i]->setRoomShard(roomShards_.get(), i);
+  }
+}
+
+void MultiReactorServer::startServer() {
+  // 第一个循环在调用线程上运行，与单循环服务器一样阻塞到 stopServer()
+  for (size_t i = 1; i < servers_.size(); ++i) {
+    ChatroomServerEpoll* loop = servers_[i].get();
+    threads_.emplace_back([loop]() { loop->startServer(); });
+  }
+  servers_.front()->startServer();
+  joinLoops();
+}
+
+void MultiReactorServer::stopServer() {
+  for (auto& server : servers_) server->stopServer();
+}
+
+void MultiReactorServer::joinLoops() {
+  for (std::thread& thread : threads_) thread.join();
+  threads_.clear();
+}
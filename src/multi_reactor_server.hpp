@@ -0,0 +1,57 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chat/chat_service.hpp"
+#include "chat/room_shards.hpp"
+#include "chatroom_server_epoll.hpp"
+
+/**
+ * @brief 多 Reactor 服务器
+ * 每个事件循环是一个独立的 ChatroomServerEpoll，运行在自己的线程上，
+ * 监听 socket 都设置 SO_REUSEPORT 绑定同一端口，由内核把新连接分给
+ * 各个循环；连接此后只在所属的循环上处理，循环之间不共享连接状态。
+ * 所有循环挂载同一个 ChatService，会话、数据库和限流器全局一致；
+ * 启用房间亲和后房间的内存状态按房间分给各循环，见 RoomShards。
+ */
+class MultiReactorServer {
+ public:
+  // loops 为事件循环（线程）数，小于 1 时按 1 处理
+  MultiReactorServer(const std::string& static_dir_path,
+                     const std::string& db_file_path, int port, int loops,
+                     const std::string& kafka_brokers = "localhost:9092");
+  ~MultiReactorServer();
+
+  // 以下设置在 startServer() 之前调用，作用于每个循环
+  void setCompression(const http::CompressionOptions& options);
+  void setRateLimit(const http::RateLimitOptions& options) {
+    service_->setRateLimit(options);
+  }
+  void setAdmission(const ChatroomServerEpoll::AdmissionOptions& options);
+  // 任一循环切换失败时返回 false，已切换的循环保持新后端
+  bool setIoBackend(reactor::IoBackend backend);
+  // 房间按名字哈希给各个循环：每个循环缓存自己房间的最近消息，
+  // 其他循环经无锁信箱把操作投递给它，见 RoomShards
+  void enableRoomAffinity();
+
+  // 其余循环各启动一个线程，第一个循环在调用线程上运行，
+  // 阻塞到 stopServer() 后所有循环退出
+  void startServer();
+  // 通知所有循环退出，可在其他线程或信号处理函数中调用
+  void stopServer();
+
+  int port() const { return port_; }
+  size_t loopCount() const { return servers_.size(); }
+
+ private:
+  void joinLoops();
+
+  std::shared_ptr<ChatService> service_;
+  // 声明在 servers_ 之前，循环都析构之后才释放
+  std::unique_ptr<RoomShards> roomShards_;
+  std::vector<std::unique_ptr<ChatroomServerEpoll>> servers_;
+  std::vector<std::thread> threads_;
+  int port_{0};
+};
@@ -8,7 +8,7 @@
 
 namespace reactor {
 
-Epoller::Epoller() {
+Epoller::Epoller() : events_(kMaxEvents) {
   epollFd_ = epoll_create1(EPOLL_CLOEXEC);
   if (epollFd_ < 0) {
     LOG(ERROR) << "Failed to create epoll instance: " << strerror(errno);
@@ -22,48 +22,30 @@ Epoller::~Epoller() {
   }
 }
 
-bool Epoller::addFd(int fd, uint32_t events) {
+bool Epoller::addFd(int fd, uint32_t events, void* ptr) {
   epoll_event ev;
   std::memset(&ev, 0, sizeof(ev));
   ev.events = events;
-  ev.data.fd = fd;
-  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == 0) {
-    fdEventsMap_[fd] = events;
-    return true;
-  }
-  return false;
+  ev.data.ptr = ptr;
+  return epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) == 0;
 }
 
-bool Epoller::modFd(int fd, uint32_t events) {
+bool Epoller::modFd(int fd, uint32_t events, void* ptr) {
   epoll_event ev;
   std::memset(&ev, 0, sizeof(ev));
   ev.events = events;
-  ev.data.fd = fd;
-  if (epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0) {
-    fdEventsMap_[fd] = events;
-    return true;
-  }
-  return false;
+  ev.data.ptr = ptr;
+  return epoll_ctl(epollFd_, EPOLL_CTL_MOD, fd, &ev) == 0;
 }
 
 bool Epoller::delFd(int fd) {
   epoll_event ev;
   std::memset(&ev, 0, sizeof(ev));
-  ev.data.fd = fd;
-  if (epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &ev) == 0) {
-    fdEventsMap_.erase(fd);
-    return true;
-  }
-  return false;
+  return epoll_ctl(epollFd_, EPOLL_CTL_DEL, fd, &ev) == 0;
 }
 
-int Epoller::wait(std::vector<epoll_event>& activeEvents, int timeoutMs) {
-  epoll_event events[kMaxEvents];
-  int n = epoll_wait(epollFd_, events, kMaxEvents, timeoutMs);
-  if (n > 0) {
-    activeEvents.assign(events, events + n);
-  }
-  return n;
+int Epoller::wait(int timeoutMs) {
+  return epoll_wait(epollFd_, events_.data(), kMaxEvents, timeoutMs);
 }
 
 }  // namespace reactor
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 #include <sys/epoll.h>
 
-#include <map>
 #include <vector>
 
 namespace reactor {
@@ -13,15 +12,19 @@ class Epoller {
   Epoller(const Epoller&) = delete;
   Epoller& operator=(const Epoller&) = delete;
 
-  bool addFd(int fd, uint32_t events);
-  bool modFd(int fd, uint32_t events);
+  // ptr 原样放进 epoll_event.data.ptr，就绪时不必再按 fd 查找
+  bool addFd(int fd, uint32_t events, void* ptr);
+  bool modFd(int fd, uint32_t events, void* ptr);
   bool delFd(int fd);
 
-  int wait(std::vector<epoll_event>& activeEvents, int timeoutMs = -1);
+  // 返回就绪事件数，事件在 events() 中，下次 wait() 前有效
+  int wait(int timeoutMs = -1);
+  const epoll_event* events() const { return events_.data(); }
 
  private:
   int epollFd_;
-  std::map<int, uint32_t> fdEventsMap_;
+  // 内核直接写入，每轮复用
+  std::vector<epoll_event> events_;
   static constexpr int kMaxEvents = 1024;  // Maximum number of events to handle
 };
-}  // namespace reactor
\ No newline at end of file
+}  // namespace reactor
@@ -1,59 +1,208 @@
 #include "event_loop.hpp"
 
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
-#include "chatroom_server_epoll.hpp"
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
 
 namespace reactor {
+namespace {
+thread_local EventLoop* t_currentLoop = nullptr;
 
-EventLoop::EventLoop() : running_(false), epoller_() {}
+// runOnce() 期间登记为当前线程的事件循环，返回时恢复
+class CurrentLoop {
+ public:
+  explicit CurrentLoop(EventLoop* loop) : previous_(t_currentLoop) {
+    t_currentLoop = loop;
+  }
+  ~CurrentLoop() { t_currentLoop = previous_; }
+
+ private:
+  EventLoop* previous_;
+};
+}  // namespace
 
-EventLoop::~EventLoop() { quit(); }
+EventLoop* EventLoop::current() { return t_currentLoop; }
 
-void EventLoop::loop() {
-  running_ = true;
-  std::vector<epoll_event> activeEvents;
-  while (running_) {
-    activeEvents.clear();
-    int n = epoller_.wait(activeEvents, 1000);  // 1秒超时
-    for (int i = 0; i < n; ++i) {
-      int fd = activeEvents[i].data.fd;
-      auto it = channels_.find(fd);
-      if (it != channels_.end()) {
-        it->second->setRevents(activeEvents[i].events);
-        it->second->handleEvent();
-      }
-    }
-    if (chatroomServerEpoll_) {
-      chatroomServerEpoll_->cleanupPendingChannels();
-    }
+EventLoop::EventLoop(IoBackend backend)
+    : quit_(false),
+      iterationTime_(utils::metrics().histogram(
+          "event_loop_iteration_seconds",
+          "Time per event loop iteration, excluding epoll_wait")) {
+  if (backend == IoBackend::IoUring) {
+    uring_ = std::make_unique<IoUring>();
+  } else {
+    epoller_ = std::make_unique<Epoller>();
   }
+  wakeupFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeupFd_ < 0) throw std::runtime_error("Failed to create eventfd");
+  auto wakeupChannel = std::make_shared<Channel>(wakeupFd_);
+  wakeupChannel->setEvents(EPOLLIN);
+  wakeupChannel->setReadCallback([this]() { handleWakeup(); });
+  addChannel(wakeupChannel);
 }
 
-void EventLoop::quit() {
-  running_ = false;
-  for (const auto& pair : channels_) {
-    int fd = pair.first;
-    epoller_.delFd(fd);  // 清理所有通道
+EventLoop::~EventLoop() { close(wakeupFd_); }
+
+void EventLoop::loop() { loop(nullptr); }
+
+void EventLoop::loop(const std::function<bool()>& busy) {
+  while (!quit_) runOnce(1000);  // 1秒超时
+  // 收尾阶段缩短等待，及时看到 busy() 变为 false
+  while (busy && busy()) runOnce(10);
+  for (Channel* channel : channels_) {
+    if (channel) unregister(channel->getFd());  // 清理所有通道
   }
   channels_.clear();
+  owned_.clear();
+  removed_.clear();
+}
+
+int EventLoop::runOnce(int timeoutMs) {
+  CurrentLoop current(this);
+  int n = uring_ ? uring_->wait(timeoutMs) : epoller_->wait(timeoutMs);
+  auto start = std::chrono::steady_clock::now();
+  const epoll_event* events = nullptr;
+  size_t count = 0;
+  if (uring_) {
+    // io_uring 的完成回调在这里执行，就绪通知和 epoll 一样带 Channel 指针
+    activeEvents_.clear();
+    uring_->dispatch(activeEvents_);
+    events = activeEvents_.data();
+    count = activeEvents_.size();
+  } else if (n > 0) {
+    events = epoller_->events();
+    count = static_cast<size_t>(n);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto* channel = static_cast<Channel*>(events[i].data.ptr);
+    // 同一批里排在前面的回调可能已移除这个 Channel，fd 也可能被新连接
+    // 复用；被移除的 Channel 活到本轮结束，可以安全比较
+    size_t fd = static_cast<size_t>(channel->getFd());
+    if (fd >= channels_.size() || channels_[fd] != channel) continue;
+    channel->setRevents(events[i].events);
+    channel->handleEvent();
+  }
+  doPendingFunctors();
+  // 排队的任务（如协程恢复后发送响应）也会关闭连接，清理放在它们之后，
+  // 否则要等下一轮，而下一轮可能阻塞到超时
+  if (cleanupCallback_) cleanupCallback_();
+  removed_.clear();
+  // 空闲超时返回的轮次不计入
+  if (n > 0) iterationTime_.record(std::chrono::steady_clock::now() - start);
+  return n;
+}
+
+void EventLoop::quit() {
+  quit_ = true;
+  wakeup();
+}
+
+void EventLoop::ensureSlot(int fd) {
+  if (static_cast<size_t>(fd) >= channels_.size()) {
+    channels_.resize(fd + 1);
+    owned_.resize(fd + 1);
+  }
+}
+
+void EventLoop::setSlot(int fd, Channel* channel) {
+  ensureSlot(fd);
+  channels_[fd] = channel;
+  if (owned_[fd].get() != channel) retire(std::move(owned_[fd]));
+}
+
+void EventLoop::own(std::shared_ptr<Channel> channel) {
+  int fd = channel->getFd();
+  ensureSlot(fd);
+  if (owned_[fd] != channel) {
+    retire(std::move(owned_[fd]));
+    owned_[fd] = std::move(channel);
+  }
 }
 
 void EventLoop::addChannel(std::shared_ptr<Channel> channel) {
+  Channel* ptr = channel.get();
+  own(std::move(channel));
+  addChannel(ptr);
+}
+
+void EventLoop::addChannel(Channel* channel) {
   int fd = channel->getFd();
-  channels_[fd] = channel;
-  epoller_.addFd(fd, channel->getEvents());
+  setSlot(fd, channel);
+  if (uring_) {
+    uring_->addFd(fd, channel->getEvents(), channel);
+  } else {
+    epoller_->addFd(fd, channel->getEvents(), channel);
+  }
 }
 
 void EventLoop::updateChannel(std::shared_ptr<Channel> channel) {
+  Channel* ptr = channel.get();
+  own(std::move(channel));
+  updateChannel(ptr);
+}
+
+void EventLoop::updateChannel(Channel* channel) {
   int fd = channel->getFd();
-  channels_[fd] = channel;
-  epoller_.modFd(fd, channel->getEvents());
+  setSlot(fd, channel);
+  if (uring_) {
+    uring_->modFd(fd, channel->getEvents(), channel);
+  } else {
+    epoller_->modFd(fd, channel->getEvents(), channel);
+  }
 }
 
 void EventLoop::removeChannel(int fd) {
-  channels_.erase(fd);
-  epoller_.delFd(fd);
+  if (static_cast<size_t>(fd) < channels_.size()) {
+    channels_[fd] = nullptr;
+    retire(std::move(owned_[fd]));
+  }
+  unregister(fd);
+}
+
+void EventLoop::retire(std::shared_ptr<Channel> channel) {
+  if (channel) removed_.push_back(std::move(channel));
+}
+
+void EventLoop::unregister(int fd) {
+  if (uring_) {
+    uring_->delFd(fd);
+  } else {
+    epoller_->delFd(fd);
+  }
+}
+
+void EventLoop::queueInLoop(std::function<void()> cb) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pendingFunctors_.push_back(std::move(cb));
+  }
+  wakeup();
+}
+
+void EventLoop::wakeup() {
+  uint64_t one = 1;
+  ssize_t n = write(wakeupFd_, &one, sizeof(one));
+  (void)n;  // 计数器非零时写失败也不影响唤醒
+}
+
+void EventLoop::handleWakeup() {
+  uint64_t count;
+  ssize_t n = read(wakeupFd_, &count, sizeof(count));
+  (void)n;
+}
+
+void EventLoop::doPendingFunctors() {
+  std::vector<std::function<void()>> functors;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    functors.swap(pendingFunctors_);
+  }
+  // 回调中可能再次 queueInLoop，交换出来后执行避免死锁
+  for (auto& functor : functors) functor();
 }
 
 }  // namespace reactor
\ No newline at end of file
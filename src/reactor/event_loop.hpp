@@ -1,35 +1,94 @@
 #pragma once
 #include <atomic>
+#include <functional>
 #include <memory>
-#include <unordered_map>
+#include <mutex>
 #include <vector>
 
 #include "channel.hpp"
 #include "epoller.hpp"
-
-class ChatroomServerEpoll;
+#include "io_uring.hpp"
+#include "utils/metrics.hpp"
 
 namespace reactor {
+// 事件循环使用的 I/O 后端，启动时选定
+enum class IoBackend { Epoll, IoUring };
+
 class EventLoop {
  public:
-  EventLoop();
+  // io_uring 不可用时抛出 std::runtime_error
+  explicit EventLoop(IoBackend backend = IoBackend::Epoll);
   ~EventLoop();
 
+  IoBackend backend() const {
+    return uring_ ? IoBackend::IoUring : IoBackend::Epoll;
+  }
+  // io_uring 后端的完成式接口，epoll 后端时为空。Channel 在两种后端
+  // 上都可用
+  IoUring* uring() { return uring_.get(); }
+
   void loop();
+  // 同 loop()，但 quit() 之后继续处理事件，直到 busy() 返回 false 才
+  // 注销所有通道并返回。用来在通道仍然注册时等进行中的请求发完响应
+  void loop(const std::function<bool()>& busy);
+  // 等待最多 timeoutMs 并处理一轮事件、排队的任务和清理回调，
+  // 返回就绪的事件数。loop() 反复调用它，基准测试也直接调用
+  int runOnce(int timeoutMs);
+  // 可在任意线程调用：唤醒循环，本轮结束后 loop() 注销所有通道并返回，
+  // 之后再调用 loop() 会立即返回
   void quit();
 
-  void setChatroomServerEpoll(ChatroomServerEpoll* ptr) {
-    chatroomServerEpoll_ = ptr;
+  // 每轮事件和排队的任务都处理完后调用，用来释放本轮关闭的连接：
+  // Channel 不能在它自己的回调里析构
+  void setCleanupCallback(std::function<void()> cb) {
+    cleanupCallback_ = std::move(cb);
   }
 
+  // 事件循环持有 Channel，直到 removeChannel() 所在的这轮结束
   void addChannel(std::shared_ptr<Channel> channel);
   void updateChannel(std::shared_ptr<Channel> channel);
+  // Channel 由调用方持有（如连接池中的连接），removeChannel() 之后
+  // 也要保持有效到本轮事件处理完，即清理回调里再释放
+  void addChannel(Channel* channel);
+  void updateChannel(Channel* channel);
   void removeChannel(int fd);
 
+  // 可在任意线程调用：把 cb 交给事件循环线程，在本轮事件处理完后执行
+  void queueInLoop(std::function<void()> cb);
+
+  // 当前线程正在 runOnce() 中运行的事件循环，没有时为空。
+  // 回调里用它找到自己所在的循环，如协程挂起后回到原循环恢复
+  static EventLoop* current();
+
  private:
-  std::atomic<bool> running_{false};
-  Epoller epoller_;
-  std::unordered_map<int, std::shared_ptr<Channel>> channels_;
-  ChatroomServerEpoll* chatroomServerEpoll_{nullptr};
+  // 表不够大时按 fd 扩容
+  void ensureSlot(int fd);
+  // 登记 fd 的 Channel，原来由事件循环持有的另一个 Channel 随之移出
+  void setSlot(int fd, Channel* channel);
+  void own(std::shared_ptr<Channel> channel);
+  // 移出表的 Channel 留到本轮结束再释放，已取出的事件还指向它
+  void retire(std::shared_ptr<Channel> channel);
+  void wakeup();
+  void unregister(int fd);
+  void handleWakeup();
+  void doPendingFunctors();
+
+  std::atomic<bool> quit_{false};  // 先于 loop() 调用 quit() 也有效
+  // 两者恰有一个非空
+  std::unique_ptr<Epoller> epoller_;
+  std::unique_ptr<IoUring> uring_;
+  // 按 fd 下标的通道表，就绪事件的 data.ptr 指向其中的 Channel。
+  // owned_ 同样按 fd 下标，只放以 shared_ptr 注册的 Channel
+  std::vector<Channel*> channels_;
+  std::vector<std::shared_ptr<Channel>> owned_;
+  std::vector<std::shared_ptr<Channel>> removed_;
+  std::function<void()> cleanupCallback_;
+  std::vector<epoll_event> activeEvents_;  // io_uring 的就绪通知，每轮复用
+
+  int wakeupFd_{-1};  // eventfd，用于唤醒阻塞在等待中的循环
+  std::mutex mutex_;
+  std::vector<std::function<void()>> pendingFunctors_;
+  // 每轮处理事件和回调的耗时，不含阻塞等待的时间
+  utils::Histogram iterationTime_;
 };
 }  // namespace reactor
@@ -0,0 +1,432 @@
+#include "io_uring.hpp"
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "utils/logger.hpp"
+
+namespace reactor {
+
+namespace {
+
+int ioUringSetup(unsigned entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete,
+                 unsigned flags, const void* arg, size_t argSize) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit,
+                                  minComplete, flags, arg, argSize));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* arg, unsigned count) {
+  return static_cast<int>(
+      syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+// multishot recv 在 6.0 加入，无法通过 probe 探测，只能看内核版本
+bool kernelAtLeast(int major, int minor) {
+  utsname name{};
+  if (uname(&name) != 0) return false;
+  int kernelMajor = 0;
+  int kernelMinor = 0;
+  if (sscanf(name.release, "%d.%d", &kernelMajor, &kernelMinor) != 2) {
+    return false;
+  }
+  return kernelMajor > major ||
+         (kernelMajor == major && kernelMinor >= minor);
+}
+
+void* mapRing(int fd, size_t size, off_t offset) {
+  void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, offset);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+template <typename T>
+T* at(void* base, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+IoUring::IoUring(unsigned entries)
+    : enterCalls_(utils::metrics().counter("io_uring_enter_total",
+                                           "io_uring_enter system calls")),
+      submittedSqes_(utils::metrics().counter(
+          "io_uring_sqes_total", "Submission queue entries submitted")) {
+  if (!kernelAtLeast(6, 0)) {
+    throw std::runtime_error("io_uring backend needs Linux 6.0 or later");
+  }
+  io_uring_params params{};
+  // 完成队列留得比提交队列大，大量连接同时有数据时不易溢出
+  params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL |
+                 IORING_SETUP_COOP_TASKRUN;
+  params.cq_entries = entries * 4;
+  ringFd_ = ioUringSetup(entries, &params);
+  if (ringFd_ < 0) {
+    LOG(ERROR) << "Failed to create io_uring instance: " << strerror(errno);
+    throw std::runtime_error("Failed to create io_uring instance");
+  }
+  features_ = params.features;
+  if (!(features_ & IORING_FEAT_EXT_ARG) ||
+      !(features_ & IORING_FEAT_NODROP)) {
+    ::close(ringFd_);
+    throw std::runtime_error("io_uring lacks EXT_ARG or NODROP");
+  }
+
+  sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMmap = features_ & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap) {
+    sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+  }
+  sqRing_ = mapRing(ringFd_, sqRingSize_, IORING_OFF_SQ_RING);
+  cqRing_ = singleMmap ? sqRing_
+                       : mapRing(ringFd_, cqRingSize_, IORING_OFF_CQ_RING);
+  sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = static_cast<io_uring_sqe*>(
+      mapRing(ringFd_, sqesSize_, IORING_OFF_SQES));
+  if (!sqRing_ || !cqRing_ || !sqes_) {
+    release();
+    throw std::runtime_error("Failed to map io_uring rings");
+  }
+  sqHead_ = at<unsigned>(sqRing_, params.sq_off.head);
+  sqTail_ = at<unsigned>(sqRing_, params.sq_off.tail);
+  sqMask_ = *at<unsigned>(sqRing_, params.sq_off.ring_mask);
+  sqEntries_ = params.sq_entries;
+  sqLocalTail_ = *sqTail_;
+  // 提交项与数组下标一一对应，之后不再改动
+  unsigned* sqArray = at<unsigned>(sqRing_, params.sq_off.array);
+  for (unsigned i = 0; i < sqEntries_; ++i) sqArray[i] = i;
+  cqHead_ = at<unsigned>(cqRing_, params.cq_off.head);
+  cqTail_ = at<unsigned>(cqRing_, params.cq_off.tail);
+  cqMask_ = *at<unsigned>(cqRing_, params.cq_off.ring_mask);
+  cqes_ = at<io_uring_cqe>(cqRing_, params.cq_off.cqes);
+
+  bufRingSize_ = kBufferCount * sizeof(io_uring_buf);
+  void* bufRing = mmap(nullptr, bufRingSize_, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (bufRing == MAP_FAILED) {
+    release();
+    throw std::runtime_error("Failed to allocate io_uring buffer ring");
+  }
+  bufRing_ = static_cast<io_uring_buf_ring*>(bufRing);
+  io_uring_buf_reg reg{};
+  reg.ring_addr = reinterpret_cast<uint64_t>(bufRing_);
+  reg.ring_entries = kBufferCount;
+  reg.bgid = kBufferGroup;
+  if (ioUringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    LOG(ERROR) << "Failed to register buffer ring: " << strerror(errno);
+    release();
+    throw std::runtime_error("Failed to register io_uring buffer ring");
+  }
+  buffers_.resize(kBufferCount * kBufferSize);
+  for (unsigned bid = 0; bid < kBufferCount; ++bid) recycleBuffer(bid);
+}
+
+IoUring::~IoUring() { release(); }
+
+void IoUring::release() {
+  // 关闭 ring fd 时内核取消所有未完成的请求
+  if (bufRing_) munmap(bufRing_, bufRingSize_);
+  if (sqes_) munmap(sqes_, sqesSize_);
+  if (cqRing_ && cqRing_ != sqRing_) munmap(cqRing_, cqRingSize_);
+  if (sqRing_) munmap(sqRing_, sqRingSize_);
+  if (ringFd_ >= 0) ::close(ringFd_);
+  bufRing_ = nullptr;
+  sqes_ = nullptr;
+  cqRing_ = sqRing_ = nullptr;
+  ringFd_ = -1;
+}
+
+bool IoUring::addFd(int fd, uint32_t events, void* ptr) {
+  if (pollTokens_.count(fd)) return false;
+  Op op{};
+  op.kind = OpKind::Poll;
+  op.fd = fd;
+  op.events = events;
+  op.ptr = ptr;
+  uint64_t token = addOp(std::move(op));
+  pollTokens_[fd] = token;
+  prepPoll(token, ops_.at(token));
+  return true;
+}
+
+bool IoUring::modFd(int fd, uint32_t events, void* ptr) {
+  // 移除旧的 poll 再按新事件重新提交，两者在同一批里按顺序执行
+  return delFd(fd) && addFd(fd, events, ptr);
+}
+
+bool IoUring::delFd(int fd) {
+  auto it = pollTokens_.find(fd);
+  if (it == pollTokens_.end()) return false;
+  uint64_t token = it->second;
+  pollTokens_.erase(it);
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = token;
+  cancel(token);
+  return true;
+}
+
+uint64_t IoUring::acceptMultishot(int listenFd, Completion cb) {
+  Op op{};
+  op.kind = OpKind::Accept;
+  op.fd = listenFd;
+  op.done = std::move(cb);
+  uint64_t token = addOp(std::move(op));
+  prepAccept(token, ops_.at(token));
+  return token;
+}
+
+uint64_t IoUring::recvMultishot(int fd, RecvCallback cb) {
+  Op op{};
+  op.kind = OpKind::Recv;
+  op.fd = fd;
+  op.recv = std::move(cb);
+  uint64_t token = addOp(std::move(op));
+  prepRecv(token, ops_.at(token));
+  return token;
+}
+
+void IoUring::sendAll(int fd, std::string data, Completion cb) {
+  sendAll(fd, std::move(data), utils::SharedBuffer(), std::move(cb));
+}
+
+void IoUring::sendAll(int fd, std::string data, utils::SharedBuffer body,
+                      Completion cb) {
+  Op op{};
+  op.kind = OpKind::Send;
+  op.fd = fd;
+  op.data = std::move(data);
+  op.body = std::move(body);
+  op.done = std::move(cb);
+  uint64_t token = addOp(std::move(op));
+  prepSend(token, ops_.at(token));
+}
+
+void IoUring::cancel(uint64_t token) {
+  auto it = ops_.find(token);
+  if (it == ops_.end()) return;
+  if (!it->second.finished && it->second.kind != OpKind::Poll) {
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = token;
+  }
+  finish(token, it->second);
+}
+
+void IoUring::close(int fd) {
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_CLOSE;
+  sqe->fd = fd;
+}
+
+int IoUring::wait(int timeoutMs) {
+  unsigned head = *cqHead_;
+  bool ready = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE) != head;
+  if (ready) {
+    // 已有完成事件时只提交，不等待
+    if (sqLocalTail_ != __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE)) {
+      submit(0, 0, nullptr, 0);
+    }
+  } else {
+    __kernel_timespec ts{};
+    io_uring_getevents_arg arg{};
+    arg.sigmask_sz = _NSIG / 8;
+    if (timeoutMs >= 0) {
+      ts.tv_sec = timeoutMs / 1000;
+      ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+      arg.ts = reinterpret_cast<uint64_t>(&ts);
+    }
+    if (submit(1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg,
+               sizeof(arg)) < 0 &&
+        errno != ETIME && errno != EINTR && errno != EBUSY) {
+      LOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+    }
+  }
+
+  unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+  completions_.clear();
+  for (; head != tail; ++head) completions_.push_back(cqes_[head & cqMask_]);
+  __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+  return static_cast<int>(completions_.size());
+}
+
+void IoUring::dispatch(std::vector<epoll_event>& activeEvents) {
+  for (const io_uring_cqe& cqe : completions_) {
+    bool hasBuffer = cqe.flags & IORING_CQE_F_BUFFER;
+    uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    bool more = cqe.flags & IORING_CQE_F_MORE;
+    auto it = ops_.find(cqe.user_data);
+    if (it == ops_.end() || it->second.finished) {
+      // 已取消的操作和不关心结果的请求
+      if (hasBuffer) recycleBuffer(bid);
+      continue;
+    }
+    uint64_t token = it->first;
+    Op& op = it->second;
+    switch (op.kind) {
+      case OpKind::Poll:
+        if (cqe.res < 0) {
+          LOG(WARN) << "io_uring poll failed on fd " << op.fd << ": "
+                    << strerror(-cqe.res);
+          pollTokens_.erase(op.fd);
+          finish(token, op);
+          break;
+        }
+        activeEvents.push_back({static_cast<uint32_t>(cqe.res), {}});
+        activeEvents.back().data.ptr = op.ptr;
+        if (!more) prepPoll(token, op);  // 单次 poll，或 multishot 被内核终止
+        break;
+      case OpKind::Accept:
+        if (cqe.res < 0) finish(token, op);
+        op.done(cqe.res);
+        if (cqe.res >= 0 && !more && !op.finished) prepAccept(token, op);
+        break;
+      case OpKind::Recv:
+        if (cqe.res > 0) {
+          op.recv(cqe.res, &buffers_[size_t{bid} * kBufferSize]);
+          if (!more && !op.finished) prepRecv(token, op);
+        } else if (cqe.res == -ENOBUFS) {
+          // 缓冲区暂时用完，multishot 已终止，回调归还后重新提交
+          if (!more) prepRecv(token, op);
+        } else {
+          finish(token, op);
+          op.recv(cqe.res, nullptr);
+        }
+        break;
+      case OpKind::Send:
+        if (cqe.res > 0) op.sent += cqe.res;
+        if (cqe.res > 0 && op.sent < op.data.size() + op.body.size()) {
+          prepSend(token, op);
+        } else {
+          finish(token, op);
+          op.done(cqe.res < 0 ? cqe.res : static_cast<int>(op.sent));
+        }
+        break;
+    }
+    if (hasBuffer) recycleBuffer(bid);
+  }
+  for (uint64_t token : finished_) ops_.erase(token);
+  finished_.clear();
+}
+
+io_uring_sqe* IoUring::getSqe() {
+  // 提交队列满时先提交已有的，不等待完成
+  if (sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >=
+      sqEntries_) {
+    submit(0, 0, nullptr, 0);
+  }
+  io_uring_sqe* sqe = &sqes_[sqLocalTail_ & sqMask_];
+  std::memset(sqe, 0, sizeof(*sqe));
+  ++sqLocalTail_;
+  return sqe;
+}
+
+int IoUring::submit(unsigned minComplete, unsigned flags, const void* arg,
+                    size_t argSize) {
+  __atomic_store_n(sqTail_, sqLocalTail_, __ATOMIC_RELEASE);
+  unsigned toSubmit =
+      sqLocalTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+  enterCalls_.inc();
+  int n = ioUringEnter(ringFd_, toSubmit, minComplete, flags, arg, argSize);
+  if (n > 0) submittedSqes_.inc(n);
+  return n;
+}
+
+uint64_t IoUring::addOp(Op op) {
+  uint64_t token = nextToken_++;
+  ops_.emplace(token, std::move(op));
+  return token;
+}
+
+void IoUring::prepPoll(uint64_t token, const Op& op) {
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = op.fd;
+  sqe->poll32_events = op.events & ~static_cast<uint32_t>(EPOLLET);
+  // multishot poll 总是边沿触发。水平触发用单次 poll，dispatch() 中
+  // 每次事件后重新提交，提交时 fd 仍就绪就会立即再次完成
+  if (op.events & EPOLLET) sqe->len = IORING_POLL_ADD_MULTI;
+  sqe->user_data = token;
+}
+
+void IoUring::prepAccept(uint64_t token, const Op& op) {
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = op.fd;
+  sqe->accept_flags = SOCK_CLOEXEC;
+  sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+  sqe->user_data = token;
+}
+
+void IoUring::prepRecv(uint64_t token, const Op& op) {
+  io_uring_sqe* sqe = getSqe();
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = op.fd;
+  sqe->ioprio = IORING_RECV_MULTISHOT;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = kBufferGroup;
+  sqe->user_data = token;
+}
+
+void IoUring::prepSend(uint64_t token, Op& op) {
+  io_uring_sqe* sqe = getSqe();
+  sqe->fd = op.fd;
+  sqe->msg_flags = MSG_NOSIGNAL;
+  sqe->user_data = token;
+  if (op.body.empty()) {
+    sqe->opcode = IORING_OP_SEND;
+    sqe->addr = reinterpret_cast<uint64_t>(op.data.data() + op.sent);
+    sqe->len = static_cast<uint32_t>(op.data.size() - op.sent);
+    return;
+  }
+  // data 剩余部分和 body 剩余部分各一个 iovec
+  size_t count = 0;
+  if (op.sent < op.data.size()) {
+    op.iov[count++] = {op.data.data() + op.sent, op.data.size() - op.sent};
+  }
+  size_t bodySent = op.sent > op.data.size() ? op.sent - op.data.size() : 0;
+  op.iov[count++] = {const_cast<char*>(op.body.data()) + bodySent,
+                     op.body.size() - bodySent};
+  op.msg = msghdr{};
+  op.msg.msg_iov = op.iov;
+  op.msg.msg_iovlen = count;
+  sqe->opcode = IORING_OP_SENDMSG;
+  sqe->addr = reinterpret_cast<uint64_t>(&op.msg);
+  sqe->len = 1;
+}
+
+void IoUring::finish(uint64_t token, Op& op) {
+  if (op.finished) return;
+  op.finished = true;
+  finished_.push_back(token);
+}
+
+void IoUring::recycleBuffer(uint16_t bid) {
+  // 头文件里的 bufs 在 C++ 下不在偏移 0（__DECLARE_FLEX_ARRAY 多了一个
+  // 空结构体），直接按 io_uring_buf 数组访问，tail 与 bufs[0].resv 重叠
+  io_uring_buf& buf = reinterpret_cast<io_uring_buf*>(
+      bufRing_)[bufTail_ & (kBufferCount - 1)];
+  buf.addr = reinterpret_cast<uint64_t>(&buffers_[size_t{bid} * kBufferSize]);
+  buf.len = kBufferSize;
+  buf.bid = bid;
+  ++bufTail_;
+  __atomic_store_n(&bufRing_->tail, bufTail_, __ATOMIC_RELEASE);
+}
+
+}  // namespace reactor
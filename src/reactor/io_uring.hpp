@@ -0,0 +1,140 @@
+#pragma once
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils/metrics.hpp"
+#include "utils/shared_buffer.hpp"
+
+namespace reactor {
+/**
+ * @brief io_uring 后端，直接使用系统调用，不依赖 liburing
+ * 两类接口：
+ * - 就绪通知：addFd/modFd/delFd 与 Epoller 相同，事件位与 epoll 一致，
+ *   ptr 放进 data.ptr。
+ *   EPOLLET 用 multishot poll，否则每次事件后重新提交单次 poll；
+ * - 完成式操作：multishot accept、使用提供缓冲区环的 multishot recv、
+ *   发送和关闭。
+ * 所有请求先放进提交队列，wait() 用一次 io_uring_enter 提交并等待，
+ * 所以一轮事件循环里的 send/close 只有一次系统调用。
+ * 只能在事件循环线程使用。需要 Linux 6.0+，否则构造函数抛出
+ * std::runtime_error。
+ */
+class IoUring {
+ public:
+  // res 为结果或 -errno
+  using Completion = std::function<void(int res)>;
+  // res > 0 时 data 指向收到的 res 字节，回调返回后缓冲区即归还内核
+  using RecvCallback = std::function<void(int res, const char* data)>;
+
+  explicit IoUring(unsigned entries = 1024);
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  bool addFd(int fd, uint32_t events, void* ptr);
+  bool modFd(int fd, uint32_t events, void* ptr);
+  bool delFd(int fd);
+
+  // 提交排队的请求，没有已完成的请求时最多等待 timeoutMs，
+  // 返回收到的完成事件数
+  int wait(int timeoutMs = -1);
+  // 执行 wait() 收到的完成回调，就绪通知追加到 activeEvents
+  void dispatch(std::vector<epoll_event>& activeEvents);
+
+  // 持续接受连接，res 为新连接的 fd（SOCK_CLOEXEC、阻塞模式）。
+  // 出错时回调 -errno 后停止，需要重新调用。返回值用于 cancel()
+  uint64_t acceptMultishot(int listenFd, Completion cb);
+  // 持续接收，内核从提供缓冲区环中选缓冲区。res 为 0（对端关闭）
+  // 或负数时是最后一次回调
+  uint64_t recvMultishot(int fd, RecvCallback cb);
+  // 发送全部 data，短写时自动续发，res 为发送的总字节数或 -errno
+  void sendAll(int fd, std::string data, Completion cb);
+  // 先发 data 再发 body，body 只增加引用、不复制（IORING_OP_SENDMSG）
+  void sendAll(int fd, std::string data, utils::SharedBuffer body,
+               Completion cb);
+  // 取消操作，之后不再回调
+  void cancel(uint64_t token);
+  // 排在之前提交的请求之后关闭 fd
+  void close(int fd);
+
+ private:
+  enum class OpKind : uint8_t { Poll, Accept, Recv, Send };
+  struct Op {
+    OpKind kind{OpKind::Poll};
+    int fd{-1};
+    uint32_t events{0};  // Poll
+    void* ptr{nullptr};  // Poll：就绪时放进 data.ptr
+    bool finished{false};
+    Completion done;     // Accept、Send
+    RecvCallback recv;   // Recv
+    std::string data;    // Send：请求完成前内核一直在读这块内存
+    utils::SharedBuffer body;  // Send：在 data 之后发送
+    size_t sent{0};
+    iovec iov[2]{};  // Send 带 body 时：ops_ 中的节点地址不变
+    msghdr msg{};
+  };
+
+  // 解除映射并关闭 ring fd，构造失败时也用它清理
+  void release();
+  io_uring_sqe* getSqe();
+  // 发布提交队列尾指针并调用 io_uring_enter，返回提交的请求数
+  int submit(unsigned minComplete, unsigned flags, const void* arg,
+             size_t argSize);
+  uint64_t addOp(Op op);
+  void prepPoll(uint64_t token, const Op& op);
+  void prepAccept(uint64_t token, const Op& op);
+  void prepRecv(uint64_t token, const Op& op);
+  void prepSend(uint64_t token, Op& op);
+  // 标记完成，dispatch() 结束时删除，回调执行中不会被析构
+  void finish(uint64_t token, Op& op);
+  void recycleBuffer(uint16_t bid);
+
+  int ringFd_{-1};
+  unsigned features_{0};
+
+  void* sqRing_{nullptr};
+  size_t sqRingSize_{0};
+  void* cqRing_{nullptr};
+  size_t cqRingSize_{0};
+  io_uring_sqe* sqes_{nullptr};
+  size_t sqesSize_{0};
+  unsigned* sqHead_{nullptr};
+  unsigned* sqTail_{nullptr};
+  unsigned sqMask_{0};
+  unsigned sqEntries_{0};
+  unsigned sqLocalTail_{0};  // 已填写的提交项，submit() 时发布
+  unsigned* cqHead_{nullptr};
+  unsigned* cqTail_{nullptr};
+  unsigned cqMask_{0};
+  io_uring_cqe* cqes_{nullptr};
+
+  // 提供缓冲区环：recv 时由内核挑选缓冲区，不必为每个连接预留
+  static constexpr unsigned kBufferCount = 256;
+  static constexpr size_t kBufferSize = 8192;
+  static constexpr uint16_t kBufferGroup = 0;
+  io_uring_buf_ring* bufRing_{nullptr};
+  size_t bufRingSize_{0};
+  std::vector<char> buffers_;
+  uint16_t bufTail_{0};
+
+  // 令牌即请求的 user_data，单调递增不复用，迟到的完成事件不会
+  // 误投给新操作。0 号用于不关心结果的取消、关闭和移除 poll
+  std::unordered_map<uint64_t, Op> ops_;
+  uint64_t nextToken_{1};
+  std::unordered_map<int, uint64_t> pollTokens_;  // fd -> poll 的令牌
+  std::vector<io_uring_cqe> completions_;
+  std::vector<uint64_t> finished_;
+
+  utils::Counter enterCalls_;
+  utils::Counter submittedSqes_;
+};
+}  // namespace reactor
@@ -0,0 +1,76 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "event_loop.hpp"
+#include "utils/arena.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/tracing.hpp"
+
+namespace reactor {
+/**
+ * @brief 把阻塞调用交给线程池的 awaitable
+ * 在事件循环线程上 co_await 时协程挂起，fn 在 pool 中执行，完成后
+ * 通过 queueInLoop() 回到原事件循环恢复协程，循环在此期间照常处理
+ * 其他连接。当前线程没有运行事件循环（如线程池服务器的工作线程）
+ * 或 pool 为空时直接在当前线程执行，不挂起。
+ * 恢复时与 handleClientEvent 一样处在本线程 arena 的作用域内；
+ * 协程中从 arena 分配的对象不能跨 co_await 存活。
+ * 创建时正在追踪的请求在 pool 中执行 fn 和恢复协程时保持不变。
+ */
+template <typename F>
+class Offload {
+ public:
+  using Result = std::invoke_result_t<F&>;
+
+  Offload(utils::ThreadPool* pool, F fn)
+      : pool_(pool),
+        fn_(std::move(fn)),
+        traceId_(utils::trace_detail::activeRequest) {}
+
+  bool await_ready() {
+    loop_ = EventLoop::current();
+    return !pool_ || !loop_;
+  }
+  void await_suspend(std::coroutine_handle<> handle) {
+    pool_->enqueue([this, handle]() {
+      uint64_t traceId = traceId_;
+      {
+        utils::TraceScope trace(traceId);
+        try {
+          result_.emplace(fn_());
+        } catch (...) {
+          error_ = std::current_exception();
+        }
+      }
+      loop_->queueInLoop([handle, traceId]() {
+        utils::ArenaScope arena(utils::threadArena());
+        utils::TraceScope trace(traceId);
+        handle.resume();
+      });
+    });
+  }
+  Result await_resume() {
+    if (error_) std::rethrow_exception(error_);
+    if (result_) return std::move(*result_);
+    return fn_();  // 没有挂起，在当前线程执行
+  }
+
+ private:
+  utils::ThreadPool* pool_;
+  F fn_;
+  uint64_t traceId_;
+  EventLoop* loop_{nullptr};
+  std::optional<Result> result_;
+  std::exception_ptr error_;
+};
+
+template <typename F>
+Offload<F> offload(utils::ThreadPool* pool, F fn) {
+  return Offload<F>(pool, std::move(fn));
+}
+}  // namespace reactor
@@ -0,0 +1,116 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace reactor {
+/**
+ * @brief 协程的返回类型，结果为 T
+ * 惰性启动：调用协程函数时不执行，被 co_await 或 spawn() 时才开始，
+ * 结束后直接转到等待它的协程（对称转移，不增加栈深度）。挂起期间只占
+ * 一个协程帧，不占线程。协程中抛出的异常在 co_await 处重新抛出。
+ */
+template <typename T>
+class [[nodiscard]] Task {
+ public:
+  struct promise_type;
+  using Handle = std::coroutine_handle<promise_type>;
+
+  struct FinalAwaiter {
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(Handle handle) noexcept {
+      if (std::coroutine_handle<> next = handle.promise().continuation) {
+        return next;
+      }
+      return std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+  };
+
+  struct promise_type {
+    std::optional<T> value;
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;
+
+    Task get_return_object() { return Task(Handle::from_promise(*this)); }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwaiter final_suspend() noexcept { return {}; }
+    template <typename U>
+    void return_value(U&& result) {
+      value.emplace(std::forward<U>(result));
+    }
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&&) = delete;
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+  T await_resume() {
+    promise_type& promise = handle_.promise();
+    if (promise.error) std::rethrow_exception(promise.error);
+    return std::move(*promise.value);
+  }
+
+ private:
+  explicit Task(Handle handle) : handle_(handle) {}
+
+  Handle handle_;
+};
+
+namespace detail {
+// 立即执行、结束时自行销毁的协程，用来在普通函数里启动 Task
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() noexcept { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept { std::terminate(); }
+  };
+};
+
+template <typename T, typename F>
+Detached runDetached(Task<T> task, F done) {
+  done(co_await task);
+}
+
+template <typename T>
+Detached runSync(Task<T> task, std::optional<T>& result,
+                 std::exception_ptr& error) {
+  try {
+    result.emplace(co_await task);
+  } catch (...) {
+    error = std::current_exception();
+  }
+}
+}  // namespace detail
+
+// 启动 task，完成时在最后恢复它的线程上调用 done(结果)；没有挂起时
+// 在 spawn() 返回前就已调用。task 不应抛出异常，否则 std::terminate()
+template <typename T, typename F>
+void spawn(Task<T> task, F done) {
+  detail::runDetached(std::move(task), std::move(done));
+}
+
+// 在当前线程运行 task 直到完成。只用于不会挂起的场合：没有事件循环的
+// 线程上 Offload 直接执行，整个 task 同步完成。挂起时抛出 logic_error
+template <typename T>
+T syncWait(Task<T> task) {
+  std::optional<T> result;
+  std::exception_ptr error;
+  detail::runSync(std::move(task), result, error);
+  if (error) std::rethrow_exception(error);
+  if (!result) throw std::logic_error("syncWait: task suspended");
+  return std::move(*result);
+}
+}  // namespace reactor
@@ -0,0 +1,49 @@
+#include "transport_options.hpp"
+
+#include <stdexcept>
+#include <string_view>
+
+TransportOptions parseTransport(std::vector<std::string>& args) {
+  TransportOptions options;
+  std::vector<std::string> positional;
+  for (const std::string& arg : args) {
+    std::string_view view(arg);
+    if (view.rfind("--transport=", 0) == 0) {
+      std::string_view name = view.substr(12);
+      if (name == "threaded") {
+        options.transport = Transport::Threaded;
+      } else if (name == "epoll") {
+        options.transport = Transport::Epoll;
+      } else if (name == "multi-reactor") {
+        options.transport = Transport::MultiReactor;
+      } else {
+        throw std::invalid_argument("Unknown transport: " + arg);
+      }
+    } else if (view.rfind("--io=", 0) == 0) {
+      std::string_view name = view.substr(5);
+      if (name == "epoll") {
+        options.io = reactor::IoBackend::Epoll;
+      } else if (name == "uring") {
+        options.io = reactor::IoBackend::IoUring;
+      } else {
+        throw std::invalid_argument("Unknown I/O backend: " + arg);
+      }
+    } else if (view.rfind("--loops=", 0) == 0) {
+      options.loops = std::stoi(arg.substr(8));
+    } else if (view == "--room-affinity") {
+      options.roomAffinity = true;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (options.io && options.transport == Transport::Threaded) {
+    throw std::invalid_argument(
+        "--io requires --transport=epoll or --transport=multi-reactor");
+  }
+  if (options.roomAffinity && options.transport != Transport::MultiReactor) {
+    throw std::invalid_argument(
+        "--room-affinity requires --transport=multi-reactor");
+  }
+  args = std::move(positional);
+  return options;
+}
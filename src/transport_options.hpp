@@ -0,0 +1,28 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "reactor/event_loop.hpp"
+
+// 传输方式，业务处理函数（ChatService）在各种方式下相同
+enum class Transport { Threaded, Epoll, MultiReactor };
+
+struct TransportOptions {
+  Transport transport{Transport::Threaded};
+  int loops{0};  // multi-reactor 的事件循环数，0 表示按 CPU 核数
+  bool roomAffinity{false};  // multi-reactor 下房间状态按房间分给各循环
+  // 事件循环的 I/O 后端，只用于 epoll 和 multi-reactor，不指定时为 epoll
+  std::optional<reactor::IoBackend> io;
+};
+
+/**
+ * @brief 取出 --transport=、--io=、--loops= 和 --room-affinity 选项，
+ * 其余参数按位置保留在 args
+ * --transport 取 threaded（默认，线程池）、epoll（单事件循环）或
+ * multi-reactor（每个核一个事件循环，SO_REUSEPORT 共享端口）；
+ * --io 取 epoll 或 uring，线程池传输没有事件循环，指定时报错；
+ * --room-affinity 只用于 multi-reactor，其他传输方式下报错。
+ * 取值非法时抛出 std::invalid_argument
+ */
+TransportOptions parseTransport(std::vector<std::string>& args);
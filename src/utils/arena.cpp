@@ -0,0 +1,89 @@
+#include "arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+namespace utils {
+
+thread_local Arena* ArenaScope::current_ = nullptr;
+
+Arena::Arena(size_t blockSize) : blockSize_(blockSize) {}
+
+Arena::~Arena() { freeBlocks(); }
+
+void* Arena::allocate(size_t bytes, size_t align) {
+  auto p = reinterpret_cast<uintptr_t>(cur_);
+  uintptr_t aligned = (p + align - 1) & ~(uintptr_t(align) - 1);
+  if (!cur_ || aligned + bytes > reinterpret_cast<uintptr_t>(end_)) {
+    addBlock(bytes + align);
+    p = reinterpret_cast<uintptr_t>(cur_);
+    aligned = (p + align - 1) & ~(uintptr_t(align) - 1);
+  }
+  cur_ = reinterpret_cast<char*>(aligned + bytes);
+  used_ += bytes;
+  return reinterpret_cast<void*>(aligned);
+}
+
+bool Arena::owns(const void* p) const {
+  auto* c = static_cast<const char*>(p);
+  for (Block* b = head_; b; b = b->next) {
+    if (c >= b->data() && c < b->data() + b->size) return true;
+  }
+  return false;
+}
+
+void Arena::reset() {
+  if (head_ && head_->next) {
+    // 上次用了多个块：合并为一个足够大的块，下次不再扩容
+    size_t total = 0;
+    for (Block* b = head_; b; b = b->next) total += b->size;
+    freeBlocks();
+    addBlock(std::min(total, kMaxRetained));
+  } else if (head_ && head_->size > kMaxRetained) {
+    freeBlocks();
+  }
+  if (head_) {
+    cur_ = head_->data();
+    end_ = cur_ + head_->size;
+  }
+  used_ = 0;
+}
+
+void Arena::addBlock(size_t minSize) {
+  size_t size = std::max(minSize, blockSize_);
+  void* mem = std::malloc(sizeof(Block) + size);
+  if (!mem) throw std::bad_alloc();
+  auto* block = static_cast<Block*>(mem);
+  block->next = head_;
+  block->size = size;
+  head_ = block;
+  cur_ = block->data();
+  end_ = cur_ + size;
+}
+
+void Arena::freeBlocks() {
+  while (head_) {
+    Block* next = head_->next;
+    std::free(head_);
+    head_ = next;
+  }
+  cur_ = end_ = nullptr;
+}
+
+ArenaScope::ArenaScope(Arena& arena) : arena_(arena), previous_(current_) {
+  current_ = &arena;
+}
+
+ArenaScope::~ArenaScope() {
+  current_ = previous_;
+  // 同一 arena 嵌套使用时由最外层负责回收
+  if (previous_ != &arena_) arena_.reset();
+}
+
+Arena& threadArena() {
+  thread_local Arena arena;
+  return arena;
+}
+
+}  // namespace utils
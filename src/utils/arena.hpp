@@ -0,0 +1,109 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace utils {
+/**
+ * @brief 单调增长的内存池（bump allocator）
+ * 分配只移动指针，单个对象不释放，reset() 时整体回收。
+ * reset() 会保留一块足够容纳上次用量的内存块，稳态下不再调用 malloc。
+ * 非线程安全，每个线程（或每个事件循环）各用一个。
+ */
+class Arena {
+ public:
+  explicit Arena(size_t blockSize = 16 * 1024);
+  ~Arena();
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+  bool owns(const void* p) const;
+  void reset();
+
+  size_t bytesUsed() const { return used_; }
+
+ private:
+  struct Block {
+    Block* next;
+    size_t size;  // 数据区大小，数据紧跟在 Block 头之后
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+  };
+  static constexpr size_t kMaxRetained = 1024 * 1024;  // reset 后最多保留 1MB
+
+  void addBlock(size_t minSize);
+  void freeBlocks();
+
+  Block* head_{nullptr};  // 当前块，next 指向更早的块
+  char* cur_{nullptr};
+  char* end_{nullptr};
+  size_t used_{0};
+  size_t blockSize_;
+};
+
+/**
+ * @brief 在作用域内把 arena 设为当前线程的请求内存池
+ * 离开作用域时恢复之前的设置并 reset arena。
+ * 作用域内创建的 ArenaAllocator 对象（如 chat_json）必须在作用域内销毁。
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena& arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  static Arena* current() { return current_; }
+
+ private:
+  Arena& arena_;
+  Arena* previous_;
+  static thread_local Arena* current_;
+};
+
+/**
+ * @brief 从当前线程的 ArenaScope 分配内存的 STL 分配器
+ * 无状态、可默认构造（nlohmann::basic_json 内部会临时构造分配器），
+ * 不在 ArenaScope 内时退化为 operator new/delete。
+ */
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept = default;
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (Arena* arena = ArenaScope::current()) {
+      return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+    }
+    return static_cast<T*>(::operator new(n * sizeof(T)));
+  }
+
+  void deallocate(T* p, size_t) noexcept {
+    Arena* arena = ArenaScope::current();
+    if (arena && arena->owns(p)) return;  // 随 arena 整体释放
+    ::operator delete(p);
+  }
+
+  friend bool operator==(const ArenaAllocator&, const ArenaAllocator&) {
+    return true;
+  }
+  friend bool operator!=(const ArenaAllocator&, const ArenaAllocator&) {
+    return false;
+  }
+};
+
+using ArenaString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+// 当前线程的请求内存池
+Arena& threadArena();
+}  // namespace utils
@@ -0,0 +1,217 @@
+#include "compress.hpp"
+
+#include <cstdint>
+
+#ifdef CHAT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CHAT_HAVE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+namespace utils {
+namespace {
+std::string_view trim(std::string_view s) {
+  size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string_view::npos) return {};
+  size_t end = s.find_last_not_of(" \t");
+  return s.substr(begin, end - begin + 1);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    char x = a[i] >= 'A' && a[i] <= 'Z' ? a[i] - 'A' + 'a' : a[i];
+    char y = b[i] >= 'A' && b[i] <= 'Z' ? b[i] - 'A' + 'a' : b[i];
+    if (x != y) return false;
+  }
+  return true;
+}
+
+// "gzip;q=0.5" 中的 q 是否为 0
+bool rejected(std::string_view params) {
+  size_t q = params.find("q=");
+  if (q == std::string_view::npos) return false;
+  std::string_view value = trim(params.substr(q + 2));
+  return value.find_first_not_of("0.") == std::string_view::npos;
+}
+
+#ifdef CHAT_HAVE_ZLIB
+// 每个线程一个 deflate 状态，deflateInit 分配的几百 KB 内部缓冲只分配一次
+class GzipStream {
+ public:
+  ~GzipStream() {
+    if (level_ >= 0) deflateEnd(&stream_);
+  }
+
+  z_stream* get(int level) {
+    if (level_ == level) {
+      deflateReset(&stream_);
+      return &stream_;
+    }
+    if (level_ >= 0) deflateEnd(&stream_);
+    level_ = -1;
+    stream_ = z_stream{};
+    // windowBits 15 + 16 输出 gzip 头而不是 zlib 头
+    if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      return nullptr;
+    }
+    level_ = level;
+    return &stream_;
+  }
+
+ private:
+  z_stream stream_{};
+  int level_{-1};
+};
+#endif
+}  // namespace
+
+bool compressibleContentType(std::string_view contentType) {
+  contentType = trim(contentType.substr(0, contentType.find(';')));
+  return contentType.substr(0, 5) == "text/" ||
+         contentType == "application/javascript" ||
+         contentType == "application/json" || contentType == "image/svg+xml";
+}
+
+std::string_view contentEncodingName(ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::Gzip:
+      return "gzip";
+    case ContentEncoding::Brotli:
+      return "br";
+    default:
+      return "";
+  }
+}
+
+bool contentEncodingAvailable(ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::Gzip:
+#ifdef CHAT_HAVE_ZLIB
+      return true;
+#else
+      return false;
+#endif
+    case ContentEncoding::Brotli:
+#ifdef CHAT_HAVE_BROTLI
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return true;
+  }
+}
+
+std::optional<std::string> gzipCompress(std::string_view data, int level) {
+#ifdef CHAT_HAVE_ZLIB
+  z_stream stream{};
+  // windowBits 15 + 16 输出 gzip 头而不是 zlib 头
+  if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return std::nullopt;
+  }
+  std::string out(deflateBound(&stream, data.size()), '\0');
+  stream.next_in =
+      reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = static_cast<uInt>(data.size());
+  stream.next_out = reinterpret_cast<Bytef*>(out.data());
+  stream.avail_out = static_cast<uInt>(out.size());
+  int ret = deflate(&stream, Z_FINISH);
+  deflateEnd(&stream);
+  if (ret != Z_STREAM_END) return std::nullopt;
+  out.resize(stream.total_out);
+  return out;
+#else
+  (void)data;
+  (void)level;
+  return std::nullopt;
+#endif
+}
+
+std::optional<std::string> brotliCompress(std::string_view data,
+                                          int quality) {
+#ifdef CHAT_HAVE_BROTLI
+  size_t size = BrotliEncoderMaxCompressedSize(data.size());
+  if (size == 0) return std::nullopt;
+  std::string out(size, '\0');
+  if (!BrotliEncoderCompress(
+          quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+          reinterpret_cast<const uint8_t*>(data.data()), &size,
+          reinterpret_cast<uint8_t*>(out.data()))) {
+    return std::nullopt;
+  }
+  out.resize(size);
+  return out;
+#else
+  (void)data;
+  (void)quality;
+  return std::nullopt;
+#endif
+}
+
+bool compressTo(ContentEncoding encoding, std::string_view data, int level,
+                std::string& out) {
+  switch (encoding) {
+#ifdef CHAT_HAVE_ZLIB
+    case ContentEncoding::Gzip: {
+      thread_local GzipStream gzip;
+      z_stream* stream = gzip.get(level);
+      if (!stream) return false;
+      out.resize(deflateBound(stream, data.size()));
+      stream->next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+      stream->avail_in = static_cast<uInt>(data.size());
+      stream->next_out = reinterpret_cast<Bytef*>(out.data());
+      stream->avail_out = static_cast<uInt>(out.size());
+      if (deflate(stream, Z_FINISH) != Z_STREAM_END) return false;
+      out.resize(stream->total_out);
+      return true;
+    }
+#endif
+#ifdef CHAT_HAVE_BROTLI
+    case ContentEncoding::Brotli: {
+      size_t size = BrotliEncoderMaxCompressedSize(data.size());
+      if (size == 0) return false;
+      out.resize(size);
+      if (!BrotliEncoderCompress(
+              level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT, data.size(),
+              reinterpret_cast<const uint8_t*>(data.data()), &size,
+              reinterpret_cast<uint8_t*>(out.data()))) {
+        return false;
+      }
+      out.resize(size);
+      return true;
+    }
+#endif
+    default:
+      (void)data;
+      (void)level;
+      (void)out;
+      return false;
+  }
+}
+
+ContentEncoding negotiateEncoding(std::string_view acceptEncoding,
+                                  bool allowGzip, bool allowBrotli) {
+  bool gzip = false;
+  bool brotli = false;
+  while (!acceptEncoding.empty()) {
+    size_t comma = acceptEncoding.find(',');
+    std::string_view item = acceptEncoding.substr(0, comma);
+    size_t semicolon = item.find(';');
+    std::string_view coding = trim(item.substr(0, semicolon));
+    bool ok = semicolon == std::string_view::npos ||
+              !rejected(item.substr(semicolon + 1));
+    if (equalsIgnoreCase(coding, "br")) brotli = ok;
+    if (equalsIgnoreCase(coding, "gzip")) gzip = ok;
+    if (comma == std::string_view::npos) break;
+    acceptEncoding.remove_prefix(comma + 1);
+  }
+  if (brotli && allowBrotli) return ContentEncoding::Brotli;
+  if (gzip && allowGzip) return ContentEncoding::Gzip;
+  return ContentEncoding::Identity;
+}
+}  // namespace utils
@@ -0,0 +1,41 @@
+#pragma once
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace utils {
+/**
+ * @brief HTTP 内容编码
+ * gzip 依赖 zlib（CHAT_HAVE_ZLIB），br 依赖 libbrotlienc（CHAT_HAVE_BROTLI），
+ * 编译时未找到对应库则该编码不可用，压缩函数返回 std::nullopt。
+ */
+enum class ContentEncoding { Identity, Gzip, Brotli };
+
+// Content-Encoding 头的取值，Identity 返回空串
+std::string_view contentEncodingName(ContentEncoding encoding);
+bool contentEncodingAvailable(ContentEncoding encoding);
+
+// 文本类内容（text/*、JSON、JS、SVG）才值得压缩，忽略 ";charset=" 等参数
+bool compressibleContentType(std::string_view contentType);
+
+// level: gzip 为 1-9，brotli 为 0-11
+std::optional<std::string> gzipCompress(std::string_view data, int level = 9);
+std::optional<std::string> brotliCompress(std::string_view data,
+                                          int quality = 11);
+
+/**
+ * @brief 压缩到 out，覆盖原内容但保留其容量
+ * gzip 复用本线程的 z_stream（只在级别变化时重新初始化），
+ * 适合每个请求都要压缩的动态响应。编码不可用或失败时返回 false。
+ */
+bool compressTo(ContentEncoding encoding, std::string_view data, int level,
+                std::string& out);
+
+/**
+ * @brief 按 Accept-Encoding 选择编码
+ * 只在 allowed 中选择，优先 br，其次 gzip；q=0 表示拒绝该编码。
+ * 请求里没有可用编码时返回 Identity。
+ */
+ContentEncoding negotiateEncoding(std::string_view acceptEncoding,
+                                  bool allowGzip, bool allowBrotli);
+}  // namespace utils
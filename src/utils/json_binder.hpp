@@ -0,0 +1,194 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+#include "json_reader.hpp"
+
+namespace utils {
+
+// 字段表中的一项：JSON 键名 -> 结构体成员
+template <typename T, typename M>
+struct JsonField {
+  std::string_view name;
+  M T::*member;
+  bool required;
+};
+
+template <typename T, typename M>
+constexpr JsonField<T, M> requiredField(std::string_view name, M T::*member) {
+  return {name, member, true};
+}
+
+template <typename T, typename M>
+constexpr JsonField<T, M> optionalField(std::string_view name, M T::*member) {
+  return {name, member, false};
+}
+
+enum class BindStatus { Ok, InvalidJson, MissingField };
+
+namespace detail {
+using ScannedField = JsonObjectScanner::Field;
+using ScannedType = JsonObjectScanner::Type;
+
+inline bool assign(std::string_view& out, const ScannedField& field) {
+  if (field.type != ScannedType::String) return false;
+  out = field.value;
+  return true;
+}
+
+inline bool assign(int64_t& out, const ScannedField& field) {
+  return field.type == ScannedType::Integer &&
+         JsonObjectScanner::parseInt(field.value, out);
+}
+
+inline bool assign(bool& out, const ScannedField& field) {
+  if (field.type != ScannedType::Bool) return false;
+  out = field.value == "true";
+  return true;
+}
+
+inline bool assign(std::string_view& out, const nlohmann::json& value) {
+  if (!value.is_string()) return false;
+  out = value.get_ref<const std::string&>();
+  return true;
+}
+
+inline bool assign(int64_t& out, const nlohmann::json& value) {
+  if (!value.is_number()) return false;
+  out = value.get<int64_t>();
+  return true;
+}
+
+inline bool assign(bool& out, const nlohmann::json& value) {
+  if (!value.is_boolean()) return false;
+  out = value.get<bool>();
+  return true;
+}
+
+// std::optional 成员：null 视为未设置
+template <typename M, typename Source>
+bool assign(std::optional<M>& out, const Source& source) {
+  bool isNull;
+  if constexpr (std::is_same_v<Source, nlohmann::json>) {
+    isNull = source.is_null();
+  } else {
+    isNull = source.type == ScannedType::Null;
+  }
+  if (isNull) {
+    out.reset();
+    return true;
+  }
+  M value{};
+  if (!assign(value, source)) return false;
+  out = value;
+  return true;
+}
+}  // namespace detail
+
+/**
+ * @brief 把 JSON 请求体绑定到带有 constexpr 字段表的请求结构体
+ * T 提供 static constexpr auto fields()，返回由 requiredField/optionalField
+ * 组成的 tuple。成员类型支持 std::string_view、int64_t、bool 及其 optional。
+ *
+ * 快速路径在 JsonObjectScanner 扫描的同一遍中按编译期字段表直接写入成员，
+ * 不查表、不分配、不拷贝字符串；扫描器不支持的输入回退到 nlohmann，
+ * 此时 string_view 指向内部持有的 DOM。结果的生命周期不超过请求体和本对象。
+ * 字段类型不符与缺失一样返回 MissingField，未声明的字段忽略。
+ */
+template <typename T>
+class BoundRequest {
+ public:
+  explicit BoundRequest(std::string_view body) : status_(bind(body)) {}
+
+  BoundRequest(const BoundRequest&) = delete;
+  BoundRequest& operator=(const BoundRequest&) = delete;
+
+  BindStatus status() const { return status_; }
+  bool ok() const { return status_ == BindStatus::Ok; }
+
+  const T& operator*() const { return value_; }
+  const T* operator->() const { return &value_; }
+
+ private:
+  using Fields = decltype(T::fields());
+  static constexpr size_t kFieldCount = std::tuple_size_v<Fields>;
+  static_assert(kFieldCount <= 32, "too many fields in request struct");
+
+  template <size_t... I>
+  static constexpr uint32_t requiredMask(std::index_sequence<I...>) {
+    return ((std::get<I>(T::fields()).required ? (1u << I) : 0u) | ... | 0u);
+  }
+  static constexpr uint32_t kRequiredMask =
+      requiredMask(std::make_index_sequence<kFieldCount>{});
+
+  BindStatus bind(std::string_view body) {
+    uint32_t seen = 0;
+    bool typeError = false;
+    JsonObjectScanner scanner(body);
+    JsonObjectScanner::Field field;
+    while (scanner.next(field)) {
+      if (!bindField<0>(field, seen)) typeError = true;
+    }
+    if (!scanner.done()) return bindFromDom(body);
+    return finish(seen, typeError);
+  }
+
+  // 编译期展开为按字段表顺序的一串键名比较
+  template <size_t I>
+  bool bindField(const JsonObjectScanner::Field& field, uint32_t& seen) {
+    if constexpr (I == kFieldCount) {
+      return true;
+    } else {
+      constexpr auto desc = std::get<I>(T::fields());
+      if (field.key != desc.name) return bindField<I + 1>(field, seen);
+      seen |= 1u << I;
+      return detail::assign(value_.*(desc.member), field);
+    }
+  }
+
+  BindStatus bindFromDom(std::string_view body) {
+    value_ = T{};
+    try {
+      dom_ = std::make_unique<nlohmann::json>(nlohmann::json::parse(body));
+    } catch (const nlohmann::json::exception&) {
+      return BindStatus::InvalidJson;
+    }
+    if (!dom_->is_object()) return BindStatus::MissingField;
+    uint32_t seen = 0;
+    bool typeError = false;
+    bindDom(seen, typeError, std::make_index_sequence<kFieldCount>{});
+    return finish(seen, typeError);
+  }
+
+  template <size_t... I>
+  void bindDom(uint32_t& seen, bool& typeError, std::index_sequence<I...>) {
+    (bindDomField<I>(seen, typeError), ...);
+  }
+
+  template <size_t I>
+  void bindDomField(uint32_t& seen, bool& typeError) {
+    constexpr auto desc = std::get<I>(T::fields());
+    auto it = dom_->find(desc.name);
+    if (it == dom_->end()) return;
+    seen |= 1u << I;
+    if (!detail::assign(value_.*(desc.member), *it)) typeError = true;
+  }
+
+  static BindStatus finish(uint32_t seen, bool typeError) {
+    if (typeError || (seen & kRequiredMask) != kRequiredMask) {
+      return BindStatus::MissingField;
+    }
+    return BindStatus::Ok;
+  }
+
+  T value_{};
+  std::unique_ptr<nlohmann::json> dom_;  // 仅在回退时创建
+  BindStatus status_;
+};
+
+}  // namespace utils
@@ -0,0 +1,223 @@
+#include "json_reader.hpp"
+
+#include <charconv>
+#include <cstring>
+
+#include "utf8.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+const char* skipSpace(const char* p, const char* end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+    ++p;
+  }
+  return p;
+}
+
+// p 指向开引号之后，返回闭引号位置。遇到反斜杠、控制字符、非法 UTF-8
+// 或未闭合时返回 nullptr，交给回退路径处理
+const char* scanString(const char* p, const char* end) {
+  const auto* u = reinterpret_cast<const unsigned char*>(p);
+  const auto* uend = reinterpret_cast<const unsigned char*>(end);
+  while (u < uend) {
+#ifdef __SSE2__
+    // 一次检查 16 字节，纯 ASCII 且无特殊字符时整块跳过
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i ctrl = _mm_set1_epi8(0x1F);
+    if (uend - u >= 16) {
+      __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u));
+      __m128i special =
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                    _mm_cmpeq_epi8(chunk, backslash)),
+                       _mm_cmpeq_epi8(_mm_max_epu8(chunk, ctrl), ctrl));
+      // 最高位为 1 的字节（非 ASCII）也需要逐个校验
+      int mask = _mm_movemask_epi8(special) | _mm_movemask_epi8(chunk);
+      if (mask == 0) {
+        u += 16;
+        continue;
+      }
+      u += __builtin_ctz(mask);
+    }
+#endif
+    unsigned char c = *u;
+    if (c == '"') return reinterpret_cast<const char*>(u);
+    if (c == '\\' || c < 0x20) return nullptr;
+    if (c < 0x80) {
+      ++u;
+    } else {
+      size_t len = utf8SequenceLength(u, uend);
+      if (len == 0) return nullptr;
+      u += len;
+    }
+  }
+  return nullptr;
+}
+
+const char* matchLiteral(const char* p, const char* end, const char* literal) {
+  size_t len = std::strlen(literal);
+  if (static_cast<size_t>(end - p) < len || std::memcmp(p, literal, len) != 0)
+    return nullptr;
+  return p + len;
+}
+
+}  // namespace
+
+bool JsonObjectScanner::next(Field& field) {
+  if (state_ == State::Start) {
+    p_ = skipSpace(p_, end_);
+    if (p_ == end_ || *p_ != '{') return fail();
+    p_ = skipSpace(p_ + 1, end_);
+    if (p_ < end_ && *p_ == '}') {
+      state_ = skipSpace(p_ + 1, end_) == end_ ? State::Done : State::Failed;
+      return false;
+    }
+    state_ = State::Fields;
+  } else if (state_ != State::Fields) {
+    return false;
+  }
+
+  if (p_ == end_ || *p_ != '"') return fail();
+  const char* keyEnd = scanString(p_ + 1, end_);
+  if (!keyEnd) return fail();
+  field.key = std::string_view(p_ + 1, keyEnd - p_ - 1);
+
+  p_ = skipSpace(keyEnd + 1, end_);
+  if (p_ == end_ || *p_ != ':') return fail();
+  p_ = skipSpace(p_ + 1, end_);
+  if (p_ == end_) return fail();
+
+  const char* p = p_;
+  const char* valueEnd = nullptr;
+  if (*p == '"') {
+    valueEnd = scanString(p + 1, end_);
+    if (!valueEnd) return fail();
+    field.value = std::string_view(p + 1, valueEnd - p - 1);
+    field.type = Type::String;
+    ++valueEnd;
+  } else if (*p == '-' || isDigit(*p)) {
+    const char* q = (*p == '-') ? p + 1 : p;
+    if (q == end_ || !isDigit(*q)) return fail();
+    if (*q == '0' && q + 1 < end_ && isDigit(q[1])) return fail();
+    while (q < end_ && isDigit(*q)) ++q;
+    // 小数和指数交给 nlohmann
+    if (q < end_ && (*q == '.' || *q == 'e' || *q == 'E')) return fail();
+    field.value = std::string_view(p, q - p);
+    field.type = Type::Integer;
+    valueEnd = q;
+  } else if ((valueEnd = matchLiteral(p, end_, "true")) ||
+             (valueEnd = matchLiteral(p, end_, "false"))) {
+    field.value = std::string_view(p, valueEnd - p);
+    field.type = Type::Bool;
+  } else if ((valueEnd = matchLiteral(p, end_, "null"))) {
+    field.value = std::string_view(p, valueEnd - p);
+    field.type = Type::Null;
+  } else {
+    return fail();  // 嵌套对象或数组
+  }
+
+  p_ = skipSpace(valueEnd, end_);
+  if (p_ == end_) return fail();
+  if (*p_ == '}') {
+    state_ = skipSpace(p_ + 1, end_) == end_ ? State::Done : State::Failed;
+  } else if (*p_ == ',') {
+    p_ = skipSpace(p_ + 1, end_);
+  } else {
+    return fail();
+  }
+  return true;
+}
+
+bool JsonObjectScanner::parseInt(std::string_view text, int64_t& number) {
+  const char* first = text.data();
+  const char* last = first + text.size();
+  auto result = std::from_chars(first, last, number);
+  return result.ec == std::errc() && result.ptr == last;
+}
+
+JsonReader::JsonReader(std::string_view json) {
+  if (scan(json)) {
+    ok_ = true;
+    return;
+  }
+  fieldCount_ = 0;
+  try {
+    dom_ = std::make_unique<nlohmann::json>(nlohmann::json::parse(json));
+    ok_ = true;
+  } catch (const nlohmann::json::exception&) {
+    dom_.reset();
+    ok_ = false;
+  }
+}
+
+bool JsonReader::scan(std::string_view json) {
+  JsonObjectScanner scanner(json);
+  Field field;
+  while (scanner.next(field)) {
+    if (fieldCount_ == kMaxFields) return false;
+    fields_[fieldCount_++] = field;
+  }
+  return scanner.done();
+}
+
+const JsonReader::Field* JsonReader::find(std::string_view key) const {
+  // 重复的键以最后一个为准，与 nlohmann 一致
+  for (size_t i = fieldCount_; i > 0; --i) {
+    if (fields_[i - 1].key == key) return &fields_[i - 1];
+  }
+  return nullptr;
+}
+
+const nlohmann::json* JsonReader::findInDom(std::string_view key) const {
+  if (!dom_ || !dom_->is_object()) return nullptr;
+  auto it = dom_->find(key);
+  return it == dom_->end() ? nullptr : &*it;
+}
+
+bool JsonReader::contains(std::string_view key) const {
+  return dom_ ? findInDom(key) != nullptr : find(key) != nullptr;
+}
+
+bool JsonReader::isNull(std::string_view key) const {
+  if (dom_) {
+    const nlohmann::json* value = findInDom(key);
+    return value && value->is_null();
+  }
+  const Field* field = find(key);
+  return field && field->type == Type::Null;
+}
+
+std::optional<std::string_view> JsonReader::getString(
+    std::string_view key) const {
+  if (dom_) {
+    const nlohmann::json* value = findInDom(key);
+    if (!value || !value->is_string()) return std::nullopt;
+    return std::string_view(value->get_ref<const std::string&>());
+  }
+  const Field* field = find(key);
+  if (!field || field->type != Type::String) return std::nullopt;
+  return field->value;
+}
+
+std::optional<int64_t> JsonReader::getInt(std::string_view key) const {
+  if (dom_) {
+    const nlohmann::json* value = findInDom(key);
+    if (!value || !value->is_number()) return std::nullopt;
+    return value->get<int64_t>();
+  }
+  const Field* field = find(key);
+  if (!field || field->type != Type::Integer) return std::nullopt;
+  int64_t number = 0;
+  if (!JsonObjectScanner::parseInt(field->value, number)) return std::nullopt;
+  return number;
+}
+
+}  // namespace utils
@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string_view>
+
+namespace utils {
+/**
+ * @brief 扁平 JSON 对象的顶层字段扫描器
+ * 每次 next() 读出一个 "key": value，值为指向原文的 string_view，不分配内存。
+ * 字符串扫描使用 SSE2 一次检查 16 字节。只处理 null/bool/整数/无转义字符串，
+ * 其余情况（转义字符、嵌套对象/数组、小数）以及非法输入都会停止扫描，
+ * 由调用方回退到 nlohmann::json::parse。
+ */
+class JsonObjectScanner {
+ public:
+  enum class Type : uint8_t { Null, Bool, Integer, String };
+  struct Field {
+    std::string_view key;
+    std::string_view value;  // 字符串不含引号，其余为原始文本
+    Type type;
+  };
+
+  explicit JsonObjectScanner(std::string_view json)
+      : p_(json.data()), end_(json.data() + json.size()) {}
+
+  // 读取下一个字段，对象结束或无法继续时返回 false
+  bool next(Field& field);
+  // next() 返回 false 后：true 表示完整扫描了整个对象，false 表示需要回退
+  bool done() const { return state_ == State::Done; }
+
+  static bool parseInt(std::string_view text, int64_t& number);
+
+ private:
+  enum class State : uint8_t { Start, Fields, Done, Failed };
+
+  bool fail() {
+    state_ = State::Failed;
+    return false;
+  }
+
+  const char* p_;
+  const char* end_;
+  State state_{State::Start};
+};
+
+/**
+ * @brief 按需读取 JSON 请求体中的顶层字段
+ * 请求体基本都是 {"username":"...","password":"..."} 这样的扁平对象，
+ * 快速路径用 JsonObjectScanner 扫描一遍，把字段记录在定长数组里，
+ * 不构建 DOM。扫描器不处理的输入回退到 nlohmann::json::parse，接口行为一致。
+ * 返回的 string_view 依赖原始 body（或回退时的 DOM），生命周期不超过 reader。
+ */
+class JsonReader {
+ public:
+  explicit JsonReader(std::string_view json);
+
+  JsonReader(const JsonReader&) = delete;
+  JsonReader& operator=(const JsonReader&) = delete;
+
+  // 是否为合法 JSON（非对象时所有字段都视为不存在）
+  bool ok() const { return ok_; }
+
+  bool contains(std::string_view key) const;
+  bool isNull(std::string_view key) const;
+  // 字段不存在或类型不符时返回 std::nullopt
+  std::optional<std::string_view> getString(std::string_view key) const;
+  std::optional<int64_t> getInt(std::string_view key) const;
+
+  // 是否走了 nlohmann 回退路径（用于测试和基准）
+  bool usedFallback() const { return dom_ != nullptr; }
+
+ private:
+  using Field = JsonObjectScanner::Field;
+  using Type = JsonObjectScanner::Type;
+  static constexpr size_t kMaxFields = 16;
+
+  bool scan(std::string_view json);
+  const Field* find(std::string_view key) const;
+  const nlohmann::json* findInDom(std::string_view key) const;
+
+  bool ok_{false};
+  size_t fieldCount_{0};
+  std::array<Field, kMaxFields> fields_;
+  std::unique_ptr<nlohmann::json> dom_;  // 仅在回退时创建
+};
+}  // namespace utils
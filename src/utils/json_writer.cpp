@@ -0,0 +1,147 @@
+#include "json_writer.hpp"
+
+#include <charconv>
+
+#include "utf8.hpp"
+
+namespace utils {
+
+void JsonWriter::escape(std::string& out, std::string_view str) {
+  static constexpr char kHex[] = "0123456789abcdef";
+  const auto* p = reinterpret_cast<const unsigned char*>(str.data());
+  const auto* end = p + str.size();
+  const auto* run = p;  // 尚未追加的一段无需转义的字节
+  while (p < end) {
+    unsigned char c = *p;
+    if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+      ++p;
+      continue;
+    }
+    if (c >= 0x80) {
+      size_t len = utf8SequenceLength(p, end);
+      if (len > 0) {
+        p += len;
+        continue;
+      }
+    }
+    out.append(reinterpret_cast<const char*>(run), p - run);
+    switch (c) {
+      case '"':
+        out += "\\\"";
+        break;
+      case '\\':
+        out += "\\\\";
+        break;
+      case '\b':
+        out += "\\b";
+        break;
+      case '\f':
+        out += "\\f";
+        break;
+      case '\n':
+        out += "\\n";
+        break;
+      case '\r':
+        out += "\\r";
+        break;
+      case '\t':
+        out += "\\t";
+        break;
+      default:
+        if (c < 0x20) {
+          char buf[6] = {'\\', 'u', '0', '0', kHex[c >> 4], kHex[c & 0xF]};
+          out.append(buf, sizeof(buf));
+        } else {
+          out += "\\ufffd";
+        }
+        break;
+    }
+    run = ++p;
+  }
+  out.append(reinterpret_cast<const char*>(run), p - run);
+}
+
+void JsonWriter::separator() {
+  if (needComma_) out_ += ',';
+}
+
+JsonWriter& JsonWriter::beginObject() {
+  separator();
+  out_ += '{';
+  needComma_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  out_ += '}';
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+  separator();
+  out_ += '[';
+  needComma_ = false;
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  out_ += ']';
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+  separator();
+  out_ += '"';
+  escape(out_, name);
+  out_ += "\":";
+  needComma_ = false;  // 紧跟的值不需要逗号
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view str) {
+  separator();
+  out_ += '"';
+  escape(out_, str);
+  out_ += '"';
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* str) {
+  if (!str) return null();
+  return value(std::string_view(str));
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+  separator();
+  out_ += flag ? "true" : "false";
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+  separator();
+  out_ += "null";
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::integer(int64_t number) {
+  separator();
+  char buf[24];
+  auto result = std::to_chars(buf, buf + sizeof(buf), number);
+  out_.append(buf, result.ptr - buf);
+  needComma_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::raw(std::string_view json) {
+  separator();
+  out_ += json;
+  needComma_ = true;
+  return *this;
+}
+
+}  // namespace utils
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace utils {
+/**
+ * @brief 流式 JSON 写入器
+ * 直接把数据追加到调用方提供的 std::string 中，不构建 DOM 树。
+ * 只负责逗号、冒号和字符串转义，begin/end 的配对由调用方保证。
+ *
+ *   std::string out;
+ *   JsonWriter w(out);
+ *   w.beginObject().key("name").value("lobby").endObject();
+ */
+class JsonWriter {
+ public:
+  explicit JsonWriter(std::string& out) : out_(out) {}
+
+  JsonWriter& beginObject();
+  JsonWriter& endObject();
+  JsonWriter& beginArray();
+  JsonWriter& endArray();
+
+  JsonWriter& key(std::string_view name);
+  JsonWriter& value(std::string_view str);
+  JsonWriter& value(const char* str);  // nullptr 写为 null
+  JsonWriter& value(bool flag);
+  JsonWriter& null();
+
+  template <typename T,
+            typename std::enable_if_t<std::is_integral_v<T> &&
+                                          !std::is_same_v<T, bool>,
+                                      int> = 0>
+  JsonWriter& value(T number) {
+    return integer(static_cast<int64_t>(number));
+  }
+
+  // 追加一段已经序列化好的 JSON 文本
+  JsonWriter& raw(std::string_view json);
+
+  // 按 JSON 规则转义并追加（不含两侧引号），非法 UTF-8 字节替换为 �
+  static void escape(std::string& out, std::string_view str);
+
+ private:
+  JsonWriter& integer(int64_t number);
+  void separator();
+
+  std::string& out_;
+  bool needComma_{false};  // 同一层级中上一个元素之后需要逗号
+};
+}  // namespace utils
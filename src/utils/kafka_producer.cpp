@@ -4,6 +4,16 @@
 
 #include "rdkafka.h"
 #include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+
+namespace {
+utils::Counter produceCounter(const char* result) {
+  return utils::metrics().counter(
+      "kafka_produce_total", "Messages handed to librdkafka, by enqueue result",
+      {{"result", result}});
+}
+}  // namespace
 
 KafkaProducer::KafkaProducer(const std::string& brokers,
                              const std::string& topic)
@@ -34,22 +44,28 @@ KafkaProducer::~KafkaProducer() {
   }
 }
 
-bool KafkaProducer::send(const std::string& message) {
+bool KafkaProducer::send(std::string_view message) {
+  static const utils::Counter kProduced = produceCounter("ok");
+  static const utils::Counter kFailed = produceCounter("error");
+  utils::TraceSpan span("kafka produce", "kafka");
   if (!rk_) {
+    kFailed.inc();
     LOG(ERROR) << "KafkaProducer not initialized";
     return false;
   }
   int err = rd_kafka_producev(
       rk_, RD_KAFKA_V_TOPIC(topic_.c_str()),
       RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
-      RD_KAFKA_V_VALUE((void*)message.c_str(), message.size()), RD_KAFKA_V_END);
+      RD_KAFKA_V_VALUE((void*)message.data(), message.size()), RD_KAFKA_V_END);
 
   if (err != RD_KAFKA_RESP_ERR_NO_ERROR) {
+    kFailed.inc();
     LOG(ERROR) << "Failed to produce message: "
                << rd_kafka_err2str(static_cast<rd_kafka_resp_err_t>(err));
     return false;
   }
 
+  kProduced.inc();
   LOG(DEBUG) << "Kafka message produced: " << message;
   return true;
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 struct rd_kafka_s;
 struct rd_kafka_conf_s;
 
@@ -7,7 +8,7 @@ class KafkaProducer {
 public:
     KafkaProducer(const std::string& brokers, const std::string& topic);
     ~KafkaProducer();
-    bool send(const std::string& message);
+    bool send(std::string_view message);
 
 private:
     std::string topic_;
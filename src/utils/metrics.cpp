@@ -0,0 +1,336 @@
+#include "metrics.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+
+namespace utils {
+namespace {
+
+// 输出的 le 边界（秒），从 10 微秒到 10 秒按 1-2.5-5 递增
+constexpr uint64_t kBoundNanos[] = {
+    10000,     25000,     50000,     100000,    250000,
+    500000,    1000000,   2500000,   5000000,   10000000,
+    25000000,  50000000,  100000000, 250000000, 500000000,
+    1000000000, 2500000000, 5000000000, 10000000000};
+constexpr const char* kBoundText[] = {
+    "1e-05", "2.5e-05", "5e-05", "0.0001", "0.00025", "0.0005", "0.001",
+    "0.0025", "0.005", "0.01", "0.025", "0.05", "0.1", "0.25", "0.5",
+    "1", "2.5", "5", "10"};
+static_assert(sizeof(kBoundNanos) / sizeof(kBoundNanos[0]) ==
+              sizeof(kBoundText) / sizeof(kBoundText[0]));
+
+void appendEscaped(std::string& out, std::string_view value) {
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      out += '\\';
+      out += c;
+    } else if (c == '\n') {
+      out += "\\n";
+    } else {
+      out += c;
+    }
+  }
+}
+
+std::string renderLabels(const MetricLabels& labels) {
+  std::string out;
+  for (const auto& [name, value] : labels) {
+    if (!out.empty()) out += ',';
+    out += name;
+    out += "=\"";
+    appendEscaped(out, value);
+    out += '"';
+  }
+  return out;
+}
+
+// name{labels,extra} value
+void appendSample(std::string& out, std::string_view name,
+                  std::string_view labels, std::string_view extra,
+                  std::string_view value) {
+  out += name;
+  if (!labels.empty() || !extra.empty()) {
+    out += '{';
+    out += labels;
+    if (!labels.empty() && !extra.empty()) out += ',';
+    out += extra;
+    out += '}';
+  }
+  out += ' ';
+  out += value;
+  out += '\n';
+}
+
+std::string formatDouble(double value) {
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%.15g", value);
+  return std::string(buf, n);
+}
+
+void appendHeader(std::string& out, std::string_view name,
+                  std::string_view type, std::string_view help) {
+  out += "# HELP ";
+  out += name;
+  out += ' ';
+  out += help;
+  out += "\n# TYPE ";
+  out += name;
+  out += ' ';
+  out += type;
+  out += '\n';
+}
+
+}  // namespace
+
+struct MetricsRegistry::Chunk {
+  std::atomic<uint64_t> values[kChunkSlots];
+  Chunk() {
+    for (auto& value : values) value.store(0, std::memory_order_relaxed);
+  }
+};
+
+struct MetricsRegistry::ThreadSlots {
+  // 只由所属线程分配，抓取线程在 mutex_ 下读取
+  std::atomic<Chunk*> chunks[kMaxChunks] = {};
+  ThreadSlots() { metrics().attach(this); }
+  ~ThreadSlots() { metrics().detach(this); }
+};
+
+namespace metrics_detail {
+std::atomic<uint64_t>& slot(uint32_t index) {
+  thread_local MetricsRegistry::ThreadSlots slots;
+  std::atomic<MetricsRegistry::Chunk*>& entry =
+      slots.chunks[index / MetricsRegistry::kChunkSlots];
+  MetricsRegistry::Chunk* chunk = entry.load(std::memory_order_relaxed);
+  if (!chunk) {
+    chunk = new MetricsRegistry::Chunk();
+    entry.store(chunk, std::memory_order_release);
+  }
+  return chunk->values[index % MetricsRegistry::kChunkSlots];
+}
+}  // namespace metrics_detail
+
+uint64_t Counter::value() const { return metrics().sums(slot_, 1)[0]; }
+
+int64_t Gauge::value() const {
+  return static_cast<int64_t>(metrics().sums(slot_, 1)[0]);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+  Snapshot snapshot;
+  std::vector<uint64_t> values = metrics().sums(first_, kSlots);
+  snapshot.sumNanos = values[kBuckets];
+  values.resize(kBuckets);
+  for (uint64_t count : values) snapshot.count += count;
+  snapshot.buckets = std::move(values);
+  return snapshot;
+}
+
+uint64_t Histogram::Snapshot::quantile(double q) const {
+  if (count == 0) return 0;
+  uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+  uint64_t seen = 0;
+  for (size_t b = 0; b < buckets.size(); ++b) {
+    seen += buckets[b];
+    if (seen >= rank) return upperBound(b);
+  }
+  return upperBound(kBuckets - 1);
+}
+
+size_t Histogram::bucketOf(uint64_t nanos) {
+  if (nanos < kSubBuckets) return static_cast<size_t>(nanos);
+  int exponent = 63 - __builtin_clzll(nanos);
+  size_t bucket = (exponent - kSubBits + 1) * kSubBuckets +
+                  ((nanos >> (exponent - kSubBits)) & (kSubBuckets - 1));
+  return std::min(bucket, kBuckets - 1);
+}
+
+uint64_t Histogram::lowerBound(size_t bucket) {
+  if (bucket < kSubBuckets) return bucket;
+  int exponent = static_cast<int>(bucket / kSubBuckets) + kSubBits - 1;
+  return (kSubBuckets + bucket % kSubBuckets) << (exponent - kSubBits);
+}
+
+uint64_t Histogram::upperBound(size_t bucket) {
+  if (bucket < kSubBuckets) return bucket + 1;
+  int exponent = static_cast<int>(bucket / kSubBuckets) + kSubBits - 1;
+  return lowerBound(bucket) + (uint64_t{1} << (exponent - kSubBits));
+}
+
+Counter MetricsRegistry::counter(std::string_view name, std::string_view help,
+                                 const MetricLabels& labels) {
+  return Counter(registerSeries(name, help, labels, Type::Counter, 1));
+}
+
+Gauge MetricsRegistry::gauge(std::string_view name, std::string_view help,
+                             const MetricLabels& labels) {
+  return Gauge(registerSeries(name, help, labels, Type::Gauge, 1));
+}
+
+Histogram MetricsRegistry::histogram(std::string_view name,
+                                     std::string_view help,
+                                     const MetricLabels& labels) {
+  return Histogram(registerSeries(name, help, labels, Type::Histogram,
+                                  Histogram::kSlots));
+}
+
+uint32_t MetricsRegistry::registerSeries(std::string_view name,
+                                         std::string_view help,
+                                         const MetricLabels& labels,
+                                         Type type, uint32_t slots) {
+  std::string rendered = renderLabels(labels);
+  std::string key = std::string(name) + "{" + rendered + "}";
+  std::lock_guard<std::mutex> lock(mutex_);
+  Family* family = nullptr;
+  for (Family& candidate : families_) {
+    if (candidate.name == name) family = &candidate;
+  }
+  if (family && family->type != type) {
+    throw std::invalid_argument("Metric registered with another type: " +
+                                std::string(name));
+  }
+  auto it = seriesIndex_.find(key);
+  if (it != seriesIndex_.end()) return it->second;
+  if (nextSlot_ + slots > kChunkSlots * kMaxChunks) {
+    throw std::length_error("Too many metrics");
+  }
+  if (!family) {
+    families_.push_back(
+        Family{std::string(name), std::string(help), type, {}});
+    family = &families_.back();
+  }
+  uint32_t first = nextSlot_;
+  nextSlot_ += slots;
+  family->series.push_back(Series{std::move(rendered), first});
+  seriesIndex_.emplace(std::move(key), first);
+  return first;
+}
+
+void MetricsRegistry::attach(ThreadSlots* slots) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads_.push_back(slots);
+}
+
+void MetricsRegistry::detach(ThreadSlots* slots) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t c = 0; c < kMaxChunks; ++c) {
+    Chunk* chunk = slots->chunks[c].load(std::memory_order_acquire);
+    if (!chunk) continue;
+    size_t base = static_cast<size_t>(c) * kChunkSlots;
+    if (retired_.size() < base + kChunkSlots) {
+      retired_.resize(base + kChunkSlots);
+    }
+    for (uint32_t i = 0; i < kChunkSlots; ++i) {
+      retired_[base + i] += chunk->values[i].load(std::memory_order_relaxed);
+    }
+    delete chunk;
+  }
+  threads_.erase(std::find(threads_.begin(), threads_.end(), slots));
+}
+
+std::vector<uint64_t> MetricsRegistry::sums(uint32_t first,
+                                            uint32_t count) const {
+  std::vector<uint64_t> values(count);
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (uint32_t i = 0; i < count; ++i) {
+    uint32_t index = first + i;
+    if (index < retired_.size()) values[i] = retired_[index];
+    for (const ThreadSlots* slots : threads_) {
+      const Chunk* chunk =
+          slots->chunks[index / kChunkSlots].load(std::memory_order_acquire);
+      if (chunk) {
+        values[i] +=
+            chunk->values[index % kChunkSlots].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return values;
+}
+
+std::vector<uint64_t> MetricsRegistry::totalsLocked() const {
+  std::vector<uint64_t> totals(nextSlot_);
+  for (size_t i = 0; i < totals.size() && i < retired_.size(); ++i) {
+    totals[i] = retired_[i];
+  }
+  for (const ThreadSlots* slots : threads_) {
+    for (uint32_t c = 0; c * kChunkSlots < nextSlot_; ++c) {
+      const Chunk* chunk = slots->chunks[c].load(std::memory_order_acquire);
+      if (!chunk) continue;
+      uint32_t end = std::min(nextSlot_, (c + 1) * kChunkSlots);
+      for (uint32_t i = c * kChunkSlots; i < end; ++i) {
+        totals[i] +=
+            chunk->values[i % kChunkSlots].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  return totals;
+}
+
+std::string MetricsRegistry::render() const {
+  std::string out;
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<uint64_t> totals = totalsLocked();
+  for (const Family& family : families_) {
+    switch (family.type) {
+      case Type::Counter:
+        appendHeader(out, family.name, "counter", family.help);
+        for (const Series& series : family.series) {
+          appendSample(out, family.name, series.labels, "",
+                       std::to_string(totals[series.first]));
+        }
+        break;
+      case Type::Gauge:
+        appendHeader(out, family.name, "gauge", family.help);
+        for (const Series& series : family.series) {
+          appendSample(
+              out, family.name, series.labels, "",
+              std::to_string(static_cast<int64_t>(totals[series.first])));
+        }
+        break;
+      case Type::Histogram: {
+        appendHeader(out, family.name, "histogram", family.help);
+        std::string bucketName = family.name + "_bucket";
+        for (const Series& series : family.series) {
+          const uint64_t* buckets = &totals[series.first];
+          // 细分桶整体落在 le 之内才计入，估计值只会偏大
+          size_t b = 0;
+          uint64_t cumulative = 0;
+          for (size_t i = 0; i < std::size(kBoundNanos); ++i) {
+            while (b < Histogram::kBuckets - 1 &&
+                   Histogram::upperBound(b) - 1 <= kBoundNanos[i]) {
+              cumulative += buckets[b++];
+            }
+            appendSample(out, bucketName, series.labels,
+                         std::string("le=\"") + kBoundText[i] + "\"",
+                         std::to_string(cumulative));
+          }
+          while (b < Histogram::kBuckets) cumulative += buckets[b++];
+          appendSample(out, bucketName, series.labels, "le=\"+Inf\"",
+                       std::to_string(cumulative));
+          appendSample(out, family.name + "_sum", series.labels, "",
+                       formatDouble(buckets[Histogram::kBuckets] / 1e9));
+          appendSample(out, family.name + "_count", series.labels, "",
+                       std::to_string(cumulative));
+        }
+        break;
+      }
+    }
+  }
+  return out;
+}
+
+MetricsRegistry& metrics() {
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+void appendMetric(std::string& out, std::string_view name,
+                  std::string_view type, std::string_view help,
+                  double value) {
+  appendHeader(out, name, type, help);
+  appendSample(out, name, "", "", formatDouble(value));
+}
+}  // namespace utils
@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace utils {
+// 标签：{名称, 值}，按给出的顺序输出
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+namespace metrics_detail {
+// 当前线程的第 index 个计数槽。槽只由所属线程写，抓取时其他线程只读，
+// 所以写入不需要原子读改写指令
+std::atomic<uint64_t>& slot(uint32_t index);
+
+inline void add(uint32_t index, uint64_t n) {
+  std::atomic<uint64_t>& s = slot(index);
+  s.store(s.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+}  // namespace metrics_detail
+
+// 指标句柄只是计数槽的下标，可以随意拷贝。默认构造的句柄指向
+// 不输出的 0 号槽，记录时不需要判空
+class Counter {
+ public:
+  Counter() = default;
+  void inc(uint64_t n = 1) const { metrics_detail::add(slot_, n); }
+  // 所有线程之和，需要加锁遍历，只用于抓取和测试
+  uint64_t value() const;
+
+ private:
+  friend class MetricsRegistry;
+  explicit Counter(uint32_t slot) : slot_(slot) {}
+  uint32_t slot_ = 0;
+};
+
+// 只支持增减：各线程记录自己的增量，抓取时求和，
+// 所以加和减可以发生在不同线程（如入队和出队）
+class Gauge {
+ public:
+  Gauge() = default;
+  void add(int64_t n) const {
+    metrics_detail::add(slot_, static_cast<uint64_t>(n));
+  }
+  int64_t value() const;
+
+ private:
+  friend class MetricsRegistry;
+  explicit Gauge(uint32_t slot) : slot_(slot) {}
+  uint32_t slot_ = 0;
+};
+
+/**
+ * @brief 纳秒级延迟直方图
+ * HDR 式的对数-线性分桶：每个 2 的幂区间再等分 8 份，相对误差不超过
+ * 12.5%，覆盖 0 到约 68 秒，更大的值记入最后一个桶。
+ * 输出时折算成固定的 Prometheus le 边界。
+ */
+class Histogram {
+ public:
+  static constexpr int kSubBits = 3;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBits;
+  static constexpr size_t kBuckets = (36 - kSubBits + 1) * kSubBuckets;
+  // 每个直方图占用的槽：各桶计数，最后一个是纳秒总和
+  static constexpr size_t kSlots = kBuckets + 1;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t sumNanos = 0;
+    std::vector<uint64_t> buckets;
+    // 分位数所在桶的上界（纳秒），没有样本时为 0
+    uint64_t quantile(double q) const;
+  };
+
+  Histogram() = default;
+  void record(uint64_t nanos) const {
+    metrics_detail::add(first_ + bucketOf(nanos), 1);
+    metrics_detail::add(first_ + kBuckets, nanos);
+  }
+  void record(std::chrono::nanoseconds elapsed) const {
+    record(static_cast<uint64_t>(std::max<int64_t>(0, elapsed.count())));
+  }
+  Snapshot snapshot() const;
+
+  static size_t bucketOf(uint64_t nanos);
+  // 桶的取值范围是 [lowerBound, upperBound)
+  static uint64_t lowerBound(size_t bucket);
+  static uint64_t upperBound(size_t bucket);
+
+ private:
+  friend class MetricsRegistry;
+  explicit Histogram(uint32_t first) : first_(first) {}
+  // 0 号直方图：默认构造的句柄写到这里，不输出
+  uint32_t first_ = 1;
+};
+
+// 析构时把经过的时间记入直方图
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() {
+    histogram_.record(std::chrono::steady_clock::now() - start_);
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Histogram histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief 进程内的指标注册表
+ * 记录只写当前线程的计数槽（一次 TLS 查找加一次普通写），
+ * 抓取时加锁把各线程的槽求和，退出的线程把计数并入 retired_。
+ * 同名同标签重复注册返回同一个句柄，可以在多个实例间共享。
+ * 线程安全。
+ */
+class MetricsRegistry {
+ public:
+  static constexpr uint32_t kChunkSlots = 1024;
+  static constexpr uint32_t kMaxChunks = 64;
+
+  Counter counter(std::string_view name, std::string_view help,
+                  const MetricLabels& labels = {});
+  Gauge gauge(std::string_view name, std::string_view help,
+              const MetricLabels& labels = {});
+  Histogram histogram(std::string_view name, std::string_view help,
+                      const MetricLabels& labels = {});
+
+  // Prometheus 文本格式（0.0.4）
+  std::string render() const;
+
+  // 以下供 metrics.cpp 内部使用
+  struct Chunk;
+  struct ThreadSlots;
+  void attach(ThreadSlots* slots);
+  void detach(ThreadSlots* slots);
+  // 从 first 开始的 count 个槽，各线程求和
+  std::vector<uint64_t> sums(uint32_t first, uint32_t count) const;
+
+ private:
+  enum class Type { Counter, Gauge, Histogram };
+  struct Series {
+    std::string labels;  // 已转义的 k="v",...，无标签时为空
+    uint32_t first;
+  };
+  struct Family {
+    std::string name;
+    std::string help;
+    Type type;
+    std::vector<Series> series;
+  };
+
+  uint32_t registerSeries(std::string_view name, std::string_view help,
+                          const MetricLabels& labels, Type type,
+                          uint32_t slots);
+  // 调用方持有 mutex_
+  std::vector<uint64_t> totalsLocked() const;
+
+  mutable std::mutex mutex_;
+  std::vector<Family> families_;
+  std::unordered_map<std::string, uint32_t> seriesIndex_;
+  // 0 号槽给默认的 Counter/Gauge，其后是默认的 Histogram
+  uint32_t nextSlot_ = 1 + Histogram::kSlots;
+  std::vector<ThreadSlots*> threads_;
+  std::vector<uint64_t> retired_;
+};
+
+// 全局注册表，进程退出时不析构，线程退出时仍可访问
+MetricsRegistry& metrics();
+
+// 追加一条不经注册表的样本（如连接数、会话数这类现取的值）
+void appendMetric(std::string& out, std::string_view name,
+                  std::string_view type, std::string_view help,
+                  double value);
+}  // namespace utils
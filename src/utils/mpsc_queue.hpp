@@ -0,0 +1,67 @@
+#pragma once
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace utils {
+/**
+ * @brief 无锁多生产者单消费者队列（Vyukov 链表队列）
+ * push() 可在任意线程调用，只有一次原子交换，不加锁；pop() 只能由
+ * 同一个消费者线程调用。同一生产者的元素按 push 顺序出队。
+ * 某个生产者交换了队尾但还没链上节点时，pop() 暂时看不到它之后的
+ * 元素并返回空，该生产者完成后会再通知消费者，消费者届时重试即可。
+ */
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+  ~MpscQueue() {
+    while (pop()) {
+    }
+  }
+
+  void push(T value) { link(new Node(std::move(value))); }
+
+  std::optional<T> pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (!next) return std::nullopt;
+      tail_ = next;
+      tail = next;
+      next = next->next.load(std::memory_order_acquire);
+    }
+    if (!next) {
+      // tail 是最后一个节点：放回 stub 后 tail 才有后继，可以取出
+      if (tail != head_.load(std::memory_order_acquire)) return std::nullopt;
+      stub_.next.store(nullptr, std::memory_order_relaxed);
+      link(&stub_);
+      next = tail->next.load(std::memory_order_acquire);
+      if (!next) return std::nullopt;
+    }
+    tail_ = next;
+    std::optional<T> value(std::move(tail->value));
+    delete tail;
+    return value;
+  }
+
+ private:
+  struct Node {
+    Node() = default;
+    explicit Node(T v) : value(std::move(v)) {}
+    std::atomic<Node*> next{nullptr};
+    std::optional<T> value;
+  };
+
+  void link(Node* node) {
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  Node stub_;
+  std::atomic<Node*> head_;  // 生产者一侧，最后入队的节点
+  Node* tail_;               // 消费者一侧
+};
+}  // namespace utils
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace utils {
+/**
+ * @brief 定长对象池（slab）
+ * 每次向系统申请一块能放 kSlabSize 个对象的内存，释放的对象串在空闲
+ * 链表上，之后的 create() 直接复用，稳态下不再调用 malloc。
+ * 对象地址在 destroy() 之前不变。非线程安全，每个事件循环各用一个；
+ * 池析构时不会析构仍在使用的对象，须先逐个 destroy()。
+ */
+template <typename T, size_t kSlabSize = 256>
+class ObjectPool {
+ public:
+  ObjectPool() = default;
+  ObjectPool(const ObjectPool&) = delete;
+  ObjectPool& operator=(const ObjectPool&) = delete;
+
+  template <typename... Args>
+  T* create(Args&&... args) {
+    if (!freeList_) grow();
+    Slot* slot = freeList_;
+    freeList_ = slot->next;
+    try {
+      T* object = new (slot->storage) T(std::forward<Args>(args)...);
+      ++size_;
+      return object;
+    } catch (...) {
+      slot->next = freeList_;
+      freeList_ = slot;
+      throw;
+    }
+  }
+
+  void destroy(T* object) {
+    object->~T();
+    Slot* slot = reinterpret_cast<Slot*>(object);
+    slot->next = freeList_;
+    freeList_ = slot;
+    --size_;
+  }
+
+  // 正在使用的对象数
+  size_t size() const { return size_; }
+  // 已申请的槽位数
+  size_t capacity() const { return slabs_.size() * kSlabSize; }
+
+ private:
+  union Slot {
+    Slot* next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  void grow() {
+    slabs_.push_back(std::make_unique<Slot[]>(kSlabSize));
+    Slot* slab = slabs_.back().get();
+    for (size_t i = kSlabSize; i-- > 0;) {
+      slab[i].next = freeList_;
+      freeList_ = &slab[i];
+    }
+  }
+
+  std::vector<std::unique_ptr<Slot[]>> slabs_;
+  Slot* freeList_{nullptr};
+  size_t size_{0};
+};
+}  // namespace utils
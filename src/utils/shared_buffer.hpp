@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <utility>
+
+namespace utils {
+/**
+ * @brief 不可变、引用计数的字节缓冲区
+ * 计数和内容在同一块内存里，创建时分配一次。复制只增加计数，
+ * 多个连接的发送路径可以通过 iovec 引用同一份报文：一条消息序列化
+ * 一次，发给 N 个连接不再复制或分配。计数是原子的，可以在事件循环
+ * 之间传递；内容创建后不再修改，读取不需要同步。
+ */
+class SharedBuffer {
+ public:
+  SharedBuffer() = default;
+  static SharedBuffer copyOf(std::string_view data) {
+    void* memory = ::operator new(sizeof(Rep) + data.size());
+    Rep* rep = new (memory) Rep{{1}, data.size()};
+    if (!data.empty()) std::memcpy(rep->bytes(), data.data(), data.size());
+    return SharedBuffer(rep);
+  }
+
+  SharedBuffer(const SharedBuffer& other) : rep_(other.rep_) {
+    if (rep_) rep_->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  SharedBuffer(SharedBuffer&& other) noexcept
+      : rep_(std::exchange(other.rep_, nullptr)) {}
+  SharedBuffer& operator=(SharedBuffer other) noexcept {
+    std::swap(rep_, other.rep_);
+    return *this;
+  }
+  ~SharedBuffer() {
+    if (rep_ && rep_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      rep_->~Rep();
+      ::operator delete(rep_);
+    }
+  }
+
+  const char* data() const { return rep_ ? rep_->bytes() : nullptr; }
+  size_t size() const { return rep_ ? rep_->size : 0; }
+  bool empty() const { return size() == 0; }
+  std::string_view view() const { return {data(), size()}; }
+  explicit operator bool() const { return rep_ != nullptr; }
+  // 引用同一块内存的 SharedBuffer 数，只用于测试和统计
+  uint32_t useCount() const {
+    return rep_ ? rep_->refs.load(std::memory_order_relaxed) : 0;
+  }
+
+ private:
+  struct Rep {
+    std::atomic<uint32_t> refs;
+    size_t size;
+    char* bytes() { return reinterpret_cast<char*>(this + 1); }
+  };
+  explicit SharedBuffer(Rep* rep) : rep_(rep) {}
+
+  Rep* rep_{nullptr};
+};
+}  // namespace utils
@@ -2,9 +2,13 @@
 
 #include <algorithm>
 #include <random>
+#include <string>
 
 namespace utils {
-ThreadPool::ThreadPool(size_t num_threads) {
+ThreadPool::ThreadPool(size_t num_threads, std::string_view name)
+    : queue_depth_(metrics().gauge("thread_pool_queue_depth",
+                                   "Tasks waiting in the pool queues",
+                                   {{"pool", std::string(name)}})) {
   stop_.store(false);
   task_queues_.resize(num_threads);
   for (size_t i = 0; i < num_threads; ++i) {
@@ -47,6 +51,7 @@ ThreadPool::ThreadPool(size_t num_threads) {
         }
 
         if (has_task) {
+          queue_depth_.add(-1);
           task();
         } else {
           std::this_thread::yield();
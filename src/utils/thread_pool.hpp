@@ -7,13 +7,17 @@
 #include <future>
 #include <memory>
 #include <mutex>
+#include <string_view>
 #include <thread>
 #include <vector>
 
+#include "metrics.hpp"
+
 namespace utils {
 class ThreadPool {
  public:
-  explicit ThreadPool(size_t num_threads);
+  // name 用作指标的 pool 标签
+  explicit ThreadPool(size_t num_threads, std::string_view name = "default");
   ~ThreadPool();
 
   template <typename F, typename... Args>
@@ -31,6 +35,7 @@ class ThreadPool {
   std::vector<std::unique_ptr<TaskQueue>> task_queues_;
   std::atomic<bool> stop_;
   std::atomic<size_t> queue_index_{0};
+  utils::Gauge queue_depth_;  // 入队时加一，开始执行时减一
 
   bool steal_task(size_t thread_index, std::function<void()>& task);
 };
@@ -44,6 +49,8 @@ auto ThreadPool::enqueue(F&& f, Args&&... args)
   std::future<return_type> result = task->get_future();
 
   size_t queue_index = queue_index_++ % workers_.size();
+  // 先加再入队，工作线程的减一不会先于这里
+  queue_depth_.add(1);
   {
     std::lock_guard<std::mutex> lock(task_queues_[queue_index]->mutex);
     task_queues_[queue_index]->tasks.emplace_back([task]() { (*task)(); });
@@ -65,8 +65,10 @@ void Timer::start() {
         } else {
           tasksCv_.wait_until(
               lock, nextTask.execTimestamp, [this, &nextTask]() {
+                // 只在有更早的任务插入时提前醒来；用 <= 的话队首就是
+                // nextTask 本身，谓词立即成立，线程会空转到截止时间
                 return !running_ ||
-                       (!taskQueue_.empty() && taskQueue_.top().execTimestamp <=
+                       (!taskQueue_.empty() && taskQueue_.top().execTimestamp <
                                                    nextTask.execTimestamp);
               });
         }
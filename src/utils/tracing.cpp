@@ -0,0 +1,164 @@
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "json_writer.hpp"
+
+namespace utils {
+namespace {
+
+struct ThreadState {
+  Tracer::ThreadBuffer buffer;
+  ThreadState() { tracer().attach(&buffer); }
+  ~ThreadState() { tracer().detach(&buffer); }
+};
+
+// Chrome trace 的时间单位是微秒，保留到纳秒
+std::string micros(uint64_t nanos) {
+  char buf[32];
+  int n = std::snprintf(buf, sizeof(buf), "%llu.%03llu",
+                        static_cast<unsigned long long>(nanos / 1000),
+                        static_cast<unsigned long long>(nanos % 1000));
+  return std::string(buf, n);
+}
+
+}  // namespace
+
+namespace trace_detail {
+void record(const char* name, const char* category, uint64_t startNs,
+            uint64_t endNs) {
+  thread_local ThreadState state;
+  Tracer::ThreadBuffer& buffer = state.buffer;
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.empty()) buffer.events.resize(Tracer::kRingCapacity);
+  buffer.events[buffer.next] =
+      Tracer::Event{name, category, startNs, endNs - startNs, activeRequest};
+  if (++buffer.next == Tracer::kRingCapacity) {
+    buffer.next = 0;
+    buffer.wrapped = true;
+  }
+}
+}  // namespace trace_detail
+
+void Tracer::setSampleRate(double rate) {
+  rate = std::clamp(rate, 0.0, 1.0);
+  uint64_t bits;
+  std::memcpy(&bits, &rate, sizeof(bits));
+  rateBits_.store(bits, std::memory_order_relaxed);
+}
+
+double Tracer::sampleRate() const {
+  uint64_t bits = rateBits_.load(std::memory_order_relaxed);
+  double rate;
+  std::memcpy(&rate, &bits, sizeof(rate));
+  return rate;
+}
+
+bool Tracer::sample() {
+  double rate = sampleRate();
+  if (rate <= 0) return false;
+  // 每个线程按比例累积，攒满 1 时采样一次，不需要随机数
+  thread_local double credit = 0;
+  credit += rate;
+  if (credit < 1) return false;
+  credit -= 1;
+  return true;
+}
+
+void Tracer::attach(ThreadBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  buffer->tid = nextTid_++;
+  threads_.push_back(buffer);
+}
+
+void Tracer::detach(ThreadBuffer* buffer) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads_.erase(std::find(threads_.begin(), threads_.end(), buffer));
+}
+
+std::string Tracer::dumpChromeTrace() const {
+  std::string out;
+  JsonWriter writer(out);
+  writer.beginObject().key("displayTimeUnit").value("ns");
+  writer.key("traceEvents").beginArray();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (ThreadBuffer* buffer : threads_) {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    size_t count = buffer->wrapped ? kRingCapacity : buffer->next;
+    if (count == 0) continue;
+    writer.beginObject()
+        .key("name")
+        .value("thread_name")
+        .key("ph")
+        .value("M")
+        .key("pid")
+        .value(1)
+        .key("tid")
+        .value(buffer->tid)
+        .key("args")
+        .beginObject()
+        .key("name")
+        .value("thread " + std::to_string(buffer->tid))
+        .endObject()
+        .endObject();
+    // 从最旧的事件开始
+    size_t first = buffer->wrapped ? buffer->next : 0;
+    for (size_t i = 0; i < count; ++i) {
+      const Event& event = buffer->events[(first + i) % kRingCapacity];
+      writer.beginObject()
+          .key("name")
+          .value(event.name)
+          .key("cat")
+          .value(event.category)
+          .key("ph")
+          .value("X")
+          .key("ts")
+          .raw(micros(event.startNs))
+          .key("dur")
+          .raw(micros(event.durationNs))
+          .key("pid")
+          .value(1)
+          .key("tid")
+          .value(buffer->tid)
+          .key("args")
+          .beginObject()
+          .key("request")
+          .value(event.requestId)
+          .endObject()
+          .endObject();
+    }
+  }
+  writer.endArray().endObject();
+  return out;
+}
+
+void Tracer::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (ThreadBuffer* buffer : threads_) {
+    std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+    buffer->next = 0;
+    buffer->wrapped = false;
+  }
+}
+
+Tracer& tracer() {
+  static Tracer* instance = new Tracer();
+  return *instance;
+}
+
+TraceRequest::TraceRequest(const char* name) {
+  if (trace_detail::activeRequest || !tracer().sample()) return;
+  name_ = name;
+  trace_detail::activeRequest = tracer().nextRequestId();
+  startNs_ = trace_detail::nowNanos();
+}
+
+TraceRequest::~TraceRequest() {
+  if (!name_) return;
+  trace_detail::record(name_, "request", startNs_, trace_detail::nowNanos());
+  trace_detail::activeRequest = 0;
+}
+}  // namespace utils
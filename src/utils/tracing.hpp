@@ -0,0 +1,139 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace utils {
+namespace trace_detail {
+// 当前线程正在处理的请求被采样时为它的编号，否则为 0
+inline thread_local uint64_t activeRequest = 0;
+
+inline uint64_t nowNanos() {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
+// 写入当前线程的环形缓冲区
+void record(const char* name, const char* category, uint64_t startNs,
+            uint64_t endNs);
+}  // namespace trace_detail
+
+/**
+ * @brief 请求阶段追踪
+ * 按采样率挑选请求，被选中的请求在处理线程上记录各阶段的起止时间，
+ * 写入每个线程自己的环形缓冲区（满了覆盖最旧的），导出为 Chrome
+ * trace-event JSON，可直接在 Perfetto / chrome://tracing 中打开。
+ * 未采样的请求中 TraceSpan 只读一次线程局部变量。
+ * 退出的线程连同它的事件一起丢弃。线程安全。
+ */
+class Tracer {
+ public:
+  static constexpr size_t kRingCapacity = 4096;
+
+  struct Event {
+    const char* name;      // 须为静态字符串
+    const char* category;  // 同上
+    uint64_t startNs;
+    uint64_t durationNs;
+    uint64_t requestId;
+  };
+  struct ThreadBuffer {
+    std::mutex mutex;
+    std::vector<Event> events;  // 首次记录时分配 kRingCapacity
+    size_t next = 0;
+    bool wrapped = false;
+    uint32_t tid = 0;
+  };
+
+  // 0 关闭（默认），1 追踪所有请求，0.01 约每 100 个请求追踪一个
+  void setSampleRate(double rate);
+  double sampleRate() const;
+  bool enabled() const { return sampleRate() > 0; }
+
+  // 所有线程缓冲区中的事件，按 Chrome trace-event 格式
+  std::string dumpChromeTrace() const;
+  void clear();
+
+  // 以下供 tracing.cpp 内部使用
+  bool sample();
+  uint64_t nextRequestId() { return ++lastRequestId_; }
+  void attach(ThreadBuffer* buffer);
+  void detach(ThreadBuffer* buffer);
+
+ private:
+  std::atomic<uint64_t> rateBits_{0};  // double 的位模式
+  std::atomic<uint64_t> lastRequestId_{0};
+  mutable std::mutex mutex_;
+  std::vector<ThreadBuffer*> threads_;
+  uint32_t nextTid_ = 1;
+};
+
+// 全局追踪器，进程退出时不析构
+Tracer& tracer();
+
+// 一个阶段：构造到析构之间的时间，只在当前请求被采样时记录
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* name, const char* category = "app")
+      : name_(trace_detail::activeRequest ? name : nullptr),
+        category_(category),
+        startNs_(name_ ? trace_detail::nowNanos() : 0) {}
+  ~TraceSpan() { end(); }
+
+  // 提前结束，用于结果要在作用域外使用的阶段；之后析构不再记录
+  void end() {
+    if (name_ && trace_detail::activeRequest) {
+      trace_detail::record(name_, category_, startNs_,
+                           trace_detail::nowNanos());
+    }
+    name_ = nullptr;
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* name_;
+  const char* category_;
+  uint64_t startNs_;
+};
+
+// 把请求带到另一个线程上，或带到协程挂起之后：构造时把当前线程切换到
+// requestId（在原线程上取自 trace_detail::activeRequest），析构时恢复。
+// requestId 为 0 时这段时间不记录
+class TraceScope {
+ public:
+  explicit TraceScope(uint64_t requestId)
+      : previous_(trace_detail::activeRequest) {
+    trace_detail::activeRequest = requestId;
+  }
+  ~TraceScope() { trace_detail::activeRequest = previous_; }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  uint64_t previous_;
+};
+
+// 一个请求的处理过程：决定是否采样，选中时本身也记为一个阶段，
+// 其间同一线程上的 TraceSpan 都归到这个请求下
+class TraceRequest {
+ public:
+  explicit TraceRequest(const char* name);
+  ~TraceRequest();
+
+  TraceRequest(const TraceRequest&) = delete;
+  TraceRequest& operator=(const TraceRequest&) = delete;
+
+ private:
+  const char* name_ = nullptr;  // 未采样或嵌套在其他请求中时为空
+  uint64_t startNs_ = 0;
+};
+}  // namespace utils
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatroom_server_epoll.hpp"
+#include "load_generator.hpp"
+#include "reactor/io_uring.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+
+// 由 CMake 定义：基线文件的绝对路径和 CMAKE_BUILD_TYPE
+#ifndef CHAT_PERF_BASELINE
+#define CHAT_PERF_BASELINE "perf_baseline.json"
+#endif
+#ifndef CHAT_BUILD_TYPE
+#define CHAT_BUILD_TYPE ""
+#endif
+
+namespace {
+
+// 不同构建配置的性能没有可比性，每个配置各有一条基线
+std::string buildProfile() {
+  std::string profile = CHAT_BUILD_TYPE;
+  if (profile.empty()) profile = "default";
+#if defined(__SANITIZE_ADDRESS__)
+  profile += "+asan";
+#elif defined(__SANITIZE_THREAD__)
+  profile += "+tsan";
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+  profile += "+asan";
+#elif __has_feature(thread_sanitizer)
+  profile += "+tsan";
+#endif
+#endif
+  return profile;
+}
+
+struct Measurement {
+  double throughput = 0;
+  uint64_t p99Us = 0;
+  uint64_t errors = 0;
+  uint64_t requests = 0;
+};
+
+// 每次运行一个新的服务器：内存数据库，不连 Kafka，系统分配端口
+Measurement measure(loadgen::Options options, reactor::IoBackend backend) {
+  char dirTemplate[] = "/tmp/chat_perf_XXXXXX";
+  std::string staticDir = mkdtemp(dirTemplate);
+  Measurement result;
+  {
+    ChatroomServerEpoll server(staticDir, ":memory:", 0, "");
+    server.setIoBackend(backend);
+    std::thread serverThread([&server]() { server.startServer(); });
+    options.port = server.port();
+    loadgen::Report report = loadgen::run(options);
+    server.stopServer();
+    serverThread.join();
+    std::cout << report.toText();
+    result.throughput = report.throughput();
+    result.p99Us = report.latency.quantile(0.99) / 1000;
+    result.errors = report.errors;
+    result.requests = report.requests;
+  }
+  std::filesystem::remove_all(staticDir);
+  return result;
+}
+
+template <typename T>
+T median(std::vector<T> values) {
+  std::sort(values.begin(), values.end());
+  return values[values.size() / 2];
+}
+
+// 固定负载下的吞吐和 p99 延迟不能比基线差出容差以外。
+// 有意更新基线：CHAT_PERF_UPDATE=1 ./perf_gate，然后提交基线文件。
+// 各 I/O 后端用同一负载，基线分开记录
+void checkAgainstBaseline(reactor::IoBackend backend) {
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  std::ifstream in(CHAT_PERF_BASELINE);
+  ASSERT_TRUE(in) << "Cannot open " << CHAT_PERF_BASELINE;
+  nlohmann::json baseline = nlohmann::json::parse(in);
+  in.close();
+
+  std::string profile = buildProfile();
+  if (backend == reactor::IoBackend::IoUring) profile += "/io_uring";
+  bool update = std::getenv("CHAT_PERF_UPDATE") != nullptr;
+  if (!update && !baseline["profiles"].contains(profile)) {
+    GTEST_SKIP() << "No baseline for build profile \"" << profile
+                 << "\", record one with CHAT_PERF_UPDATE=1";
+  }
+
+  const nlohmann::json& workload = baseline["workload"];
+  loadgen::Options options;
+  options.users = workload["users"];
+  options.rooms = workload["rooms"];
+  options.roomsPerUser = workload["roomsPerUser"];
+  options.thinkTime = std::chrono::milliseconds(workload["thinkMs"]);
+  options.duration = std::chrono::milliseconds(workload["durationMs"]);
+  options.mix.send = workload["mix"][0];
+  options.mix.poll = workload["mix"][1];
+  options.mix.rooms = workload["mix"][2];
+  options.mix.users = workload["mix"][3];
+  options.prefix = "perf_";
+
+  // 取多次运行的中位数，减少单次抖动的影响
+  std::vector<double> throughputs;
+  std::vector<uint64_t> p99s;
+  uint64_t errors = 0;
+  uint64_t requests = 0;
+  for (int run = 0; run < workload["runs"].get<int>(); ++run) {
+    Measurement m = measure(options, backend);
+    throughputs.push_back(m.throughput);
+    p99s.push_back(m.p99Us);
+    errors += m.errors;
+    requests += m.requests;
+  }
+  double throughput = median(throughputs);
+  uint64_t p99Us = median(p99s);
+  std::cout << "profile " << profile << ": " << throughput << " req/s, p99 "
+            << p99Us << " us" << std::endl;
+  if (backend == reactor::IoBackend::IoUring) {
+    uint64_t enters = utils::metrics()
+                          .counter("io_uring_enter_total",
+                                   "io_uring_enter system calls")
+                          .value();
+    std::cout << "io_uring_enter per request: "
+              << static_cast<double>(enters) / requests << std::endl;
+  }
+  EXPECT_EQ(errors, 0u);
+
+  if (update) {
+    baseline["profiles"][profile] = {{"throughput", throughput},
+                                     {"p99_us", p99Us}};
+    std::ofstream(CHAT_PERF_BASELINE) << baseline.dump(2) << "\n";
+    std::cout << "Baseline updated: " << CHAT_PERF_BASELINE << std::endl;
+    return;
+  }
+
+  const nlohmann::json& expected = baseline["profiles"][profile];
+  const nlohmann::json& tolerance = baseline["tolerance"];
+  double minThroughput = expected["throughput"].get<double>() *
+                         (1 - tolerance["throughput"].get<double>());
+  double maxP99Us = expected["p99_us"].get<double>() *
+                    (1 + tolerance["p99"].get<double>());
+  EXPECT_GE(throughput, minThroughput)
+      << "Throughput regressed, baseline " << expected["throughput"];
+  EXPECT_LE(p99Us, maxP99Us) << "p99 latency regressed, baseline "
+                             << expected["p99_us"] << " us";
+}
+
+// io_uring 不可用（内核低于 6.0 或被禁用）时返回 false
+bool ioUringAvailable() {
+  try {
+    reactor::IoUring uring;
+    return true;
+  } catch (const std::exception&) {
+    return false;
+  }
+}
+
+}  // namespace
+
+TEST(PerfGate, EpollServerChatWorkload) {
+  checkAgainstBaseline(reactor::IoBackend::Epoll);
+}
+
+TEST(PerfGate, IoUringServerChatWorkload) {
+  if (!ioUringAvailable()) GTEST_SKIP() << "io_uring unavailable";
+  checkAgainstBaseline(reactor::IoBackend::IoUring);
+}
@@ -0,0 +1,595 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chatroom_server.hpp"
+#include "chatroom_server_epoll.hpp"
+#include "multi_reactor_server.hpp"
+#include "transport_options.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+
+namespace {
+
+// 连接本机端口，失败时返回 -1
+int connectTo(int port) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(port);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// 读到对端关闭为止，3 秒内没有数据也返回
+std::string readAll(int fd) {
+  timeval timeout{3, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  std::string out;
+  char buf[4096];
+  ssize_t n;
+  while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) out.append(buf, n);
+  return out;
+}
+
+// 发送完整请求，读取整个响应（服务器应答后关闭连接）
+std::string roundTrip(int port, const std::string& request) {
+  int fd = connectTo(port);
+  if (fd < 0) return "";
+  send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+  std::string response = readAll(fd);
+  close(fd);
+  return response;
+}
+
+constexpr const char* kGetRooms = "GET /rooms HTTP/1.1\r\n\r\n";
+
+// 最多等 2 秒
+template <typename Pred>
+bool waitFor(Pred pred) {
+  for (int i = 0; i < 200 && !pred(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+// 后台线程中运行的 epoll 服务器：内存数据库，不连 Kafka，系统分配端口
+class EpollServer {
+ public:
+  explicit EpollServer(
+      const ChatroomServerEpoll::AdmissionOptions& options = {},
+      reactor::IoBackend backend = reactor::IoBackend::Epoll) {
+    utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+    char dirTemplate[] = "/tmp/chat_server_test_XXXXXX";
+    staticDir_ = mkdtemp(dirTemplate);
+    server_ = std::make_unique<ChatroomServerEpoll>(staticDir_, ":memory:", 0,
+                                                    "");
+    server_->setAdmission(options);
+    backendReady_ = server_->setIoBackend(backend);
+    thread_ = std::thread([this]() { server_->startServer(); });
+  }
+  ~EpollServer() {
+    server_->stopServer();
+    thread_.join();
+    server_.reset();
+    std::filesystem::remove_all(staticDir_);
+  }
+
+  int port() const { return server_->port(); }
+  const ChatroomServerEpoll::AdmissionStats& stats() const {
+    return server_->admissionStats();
+  }
+  // 请求的 I/O 后端不可用（如 io_uring）时为 false，仍以 epoll 运行
+  bool backendReady() const { return backendReady_; }
+  // 启动后写入的文件也能访问
+  const std::string& staticDir() const { return staticDir_; }
+
+ private:
+  std::string staticDir_;
+  std::unique_ptr<ChatroomServerEpoll> server_;
+  bool backendReady_{false};
+  std::thread thread_;
+};
+
+// 系统分配一个空闲端口后释放：线程池服务器只能按指定端口启动
+int freePort() {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  bind(fd, (sockaddr*)&addr, sizeof(addr));
+  getsockname(fd, (sockaddr*)&addr, &len);
+  close(fd);
+  return ntohs(addr.sin_port);
+}
+
+// 后台线程中运行的线程池服务器，其余同 EpollServer
+class ThreadedServer {
+ public:
+  ThreadedServer() : port_(freePort()) {
+    utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+    char dirTemplate[] = "/tmp/chat_server_test_XXXXXX";
+    staticDir_ = mkdtemp(dirTemplate);
+    server_ = std::make_unique<ChatroomServer>(staticDir_, ":memory:", port_,
+                                               "");
+    thread_ = std::thread([this]() { server_->startServer(); });
+    waitFor([this] {
+      int fd = connectTo(port_);
+      if (fd >= 0) close(fd);
+      return fd >= 0;
+    });
+  }
+  ~ThreadedServer() {
+    server_->stopServer();
+    // accept() 是阻塞的，再连一次让它返回后看到停止标志
+    int fd = connectTo(port_);
+    if (fd >= 0) close(fd);
+    thread_.join();
+    server_.reset();
+    std::filesystem::remove_all(staticDir_);
+  }
+
+  int port() const { return port_; }
+
+ private:
+  int port_;
+  std::string staticDir_;
+  std::unique_ptr<ChatroomServer> server_;
+  std::thread thread_;
+};
+
+// 后台线程中运行的多 Reactor 服务器：内存数据库，不连 Kafka，
+// 第一个循环绑定系统分配的端口，其余循环经 SO_REUSEPORT 复用
+class MultiReactor {
+ public:
+  struct Config {
+    int loops = 2;
+    bool roomAffinity = false;
+    std::string dbPath = ":memory:";
+    reactor::IoBackend backend = reactor::IoBackend::Epoll;
+  };
+
+  explicit MultiReactor(const Config& config) {
+    utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+    char dirTemplate[] = "/tmp/chat_server_test_XXXXXX";
+    staticDir_ = mkdtemp(dirTemplate);
+    server_ = std::make_unique<MultiReactorServer>(staticDir_, config.dbPath,
+                                                   0, config.loops, "");
+    if (config.roomAffinity) server_->enableRoomAffinity();
+    backendReady_ = server_->setIoBackend(config.backend);
+    // startServer() 在本线程上运行第一个循环，阻塞到 stopServer()
+    thread_ = std::thread([this]() { server_->startServer(); });
+  }
+  ~MultiReactor() {
+    server_->stopServer();
+    thread_.join();
+    server_.reset();
+    std::filesystem::remove_all(staticDir_);
+  }
+
+  int port() const { return server_->port(); }
+  bool backendReady() const { return backendReady_; }
+
+ private:
+  std::string staticDir_;
+  std::unique_ptr<MultiReactorServer> server_;
+  bool backendReady_{false};
+  std::thread thread_;
+};
+
+std::string request(const std::string& method, const std::string& path,
+                    const std::string& body, const std::string& token = "") {
+  std::string out = method + " " + path + " HTTP/1.1\r\nHost: test\r\n";
+  if (!token.empty()) out += "Authorization: Bearer " + token + "\r\n";
+  out += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+  return out + body;
+}
+
+// 依次发送注册、登录、建房、加入、发送和轮询，返回每个应答的状态码和
+// 响应体。时间戳和令牌每次不同，替换成占位符
+std::vector<std::string> chatSession(int port) {
+  std::vector<std::string> answers;
+  std::string token;
+  auto call = [&](const std::string& raw) {
+    std::string response = roundTrip(port, raw);
+    size_t bodyStart = response.find("\r\n\r\n");
+    std::string body = bodyStart == std::string::npos
+                           ? ""
+                           : response.substr(bodyStart + 4);
+    std::smatch match;
+    if (std::regex_search(body, match,
+                          std::regex("\"token\":\"([0-9a-f]+)\""))) {
+      token = match[1];
+    }
+    // 先替换令牌：十六进制令牌里可能恰好有 13 位连续数字
+    body = std::regex_replace(body, std::regex("\"token\":\"[0-9a-f]+\""),
+                              "\"token\":TOK");
+    body = std::regex_replace(body, std::regex("[0-9]{13}"), "T");
+    answers.push_back(response.substr(0, 12) + " " + body);
+  };
+  call(request("POST", "/register", R"({"username":"alice","password":"p"})"));
+  call(request("POST", "/register", R"({"username":"alice","password":"x"})"));
+  call(request("POST", "/login", R"({"username":"alice","password":"x"})"));
+  call(request("POST", "/login", R"({"username":"alice","password":"p"})"));
+  call(request("POST", "/create_room", R"({"name":"lobby","creator":"alice"})",
+               token));
+  call(request("POST", "/join_room", R"({"room":"lobby","username":"alice"})",
+               token));
+  call(request("POST", "/send_message",
+               R"({"room":"lobby","username":"alice","content":"hi 你好"})",
+               token));
+  call(request("POST", "/send_message",
+               R"({"room":"lobby","username":"alice","content":"x"})"));
+  call(request("POST", "/messages",
+               R"({"room":"lobby","since":0,"username":"alice"})", token));
+  call(request("GET", "/rooms/lobby/messages?since=0", "", token));
+  call(request("GET", "/rooms", ""));
+  return answers;
+}
+
+// 响应体，没有空行时为空
+std::string bodyOf(const std::string& response) {
+  size_t start = response.find("\r\n\r\n");
+  return start == std::string::npos ? "" : response.substr(start + 4);
+}
+
+// 注册（已存在时忽略）并登录，返回会话令牌
+std::string loginAs(int port, const std::string& user) {
+  std::string credentials =
+      R"({"username":")" + user + R"(","password":"p"})";
+  roundTrip(port, request("POST", "/register", credentials));
+  std::string body =
+      bodyOf(roundTrip(port, request("POST", "/login", credentials)));
+  std::smatch match;
+  if (!std::regex_search(body, match,
+                         std::regex("\"token\":\"([0-9a-f]+)\""))) {
+    return "";
+  }
+  return match[1];
+}
+
+// GET /rooms/:name/messages 的响应体
+std::string pollRoom(int port, const std::string& token,
+                     const std::string& room, int64_t since) {
+  return bodyOf(roundTrip(
+      port, request("GET",
+                    "/rooms/" + room + "/messages?since=" +
+                        std::to_string(since),
+                    "", token)));
+}
+
+}  // namespace
+
+TEST(AdmissionTest, RejectsConnectionsBeyondLimit) {
+  ChatroomServerEpoll::AdmissionOptions options;
+  options.maxConnections = 1;
+  EpollServer server(options);
+  // 第一个连接不发请求，一直占着名额
+  int idle = connectTo(server.port());
+  ASSERT_GE(idle, 0);
+  ASSERT_TRUE(waitFor([&] { return server.stats().accepted == 1; }));
+
+  std::string response = roundTrip(server.port(), kGetRooms);
+  EXPECT_EQ(response.rfind("HTTP/1.1 503", 0), 0u) << response;
+  // 计数在关闭连接之后才增加，客户端可能先看到结果
+  EXPECT_TRUE(
+      waitFor([&] { return server.stats().rejectedMaxConnections == 1; }));
+
+  // 名额释放后恢复接受
+  close(idle);
+  ASSERT_TRUE(waitFor([&] {
+    return roundTrip(server.port(), kGetRooms).rfind("HTTP/1.1 200", 0) == 0;
+  }));
+  EXPECT_EQ(server.stats().rejectedMaxConnections, 1u);
+}
+
+TEST(AdmissionTest, ClosesSlowRequestsAtDeadline) {
+  ChatroomServerEpoll::AdmissionOptions options;
+  options.requestTimeout = std::chrono::milliseconds(100);
+  EpollServer server(options);
+  int fd = connectTo(server.port());
+  ASSERT_GE(fd, 0);
+  // 只发一部分请求头，之后不再发送
+  std::string partial = "GET /rooms HTTP/1.1\r\nHost: x\r\n";
+  send(fd, partial.data(), partial.size(), MSG_NOSIGNAL);
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(readAll(fd), "");
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+  close(fd);
+  EXPECT_EQ(server.stats().requestTimeouts, 1u);
+}
+
+TEST(AdmissionTest, RejectsOversizedRequests) {
+  ChatroomServerEpoll::AdmissionOptions options;
+  options.maxRequestBytes = 1024;
+  EpollServer server(options);
+  // Content-Length 超限时不等请求体
+  std::string response = roundTrip(
+      server.port(),
+      "POST /send_message HTTP/1.1\r\nContent-Length: 4096\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 413", 0), 0u) << response;
+  // 请求头超过上限还没结束
+  response = roundTrip(server.port(), "GET /rooms HTTP/1.1\r\nX-Pad: " +
+                                          std::string(2048, 'a'));
+  EXPECT_EQ(response.rfind("HTTP/1.1 413", 0), 0u) << response;
+  EXPECT_EQ(server.stats().oversizedRequests, 2u);
+}
+
+TEST(AdmissionTest, CountsBodyEndingInCarriageReturn) {
+  EpollServer server;
+  // 解析出的请求体去掉了末尾的 '\r'，收齐与否要按收到的字节数判断，
+  // 否则一直等到读取期限
+  std::string response =
+      roundTrip(server.port(), request("POST", "/no_such_route", "abc\r"));
+  EXPECT_EQ(response.rfind("HTTP/1.1 404", 0), 0u) << response;
+  EXPECT_EQ(server.stats().requestTimeouts, 0u);
+}
+
+TEST(AdmissionTest, ShedsConnectionsWhenOutOfFds) {
+  EpollServer server;
+  // 先建好客户端 socket，再占满本进程的 fd，服务器 accept 时 EMFILE
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(client, 0);
+  rlimit original{};
+  ASSERT_EQ(getrlimit(RLIMIT_NOFILE, &original), 0);
+  rlimit lowered = original;
+  lowered.rlim_cur = 256;
+  ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &lowered), 0);
+  std::vector<int> fillers;
+  int fd;
+  while ((fd = dup(client)) >= 0) fillers.push_back(fd);
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(server.port());
+  ASSERT_EQ(connect(client, (sockaddr*)&addr, sizeof(addr)), 0);
+  // 用预留的 fd 接受后立即关闭，不留在监听队列里
+  EXPECT_EQ(readAll(client), "");
+  EXPECT_TRUE(waitFor([&] { return server.stats().rejectedNoFd == 1; }));
+  EXPECT_EQ(server.stats().accepted, 0u);
+
+  for (int filler : fillers) close(filler);
+  close(client);
+  ASSERT_EQ(setrlimit(RLIMIT_NOFILE, &original), 0);
+  // 有 fd 之后正常服务
+  std::string response = roundTrip(server.port(), kGetRooms);
+  EXPECT_EQ(response.rfind("HTTP/1.1 200", 0), 0u) << response;
+}
+
+TEST(TransportTest, AllTransportsAnswerAlike) {
+  std::vector<std::string> threaded;
+  {
+    ThreadedServer server;
+    threaded = chatSession(server.port());
+  }
+  std::vector<std::string> epoll;
+  {
+    EpollServer server;
+    epoll = chatSession(server.port());
+  }
+  // 每个请求一个新连接，由内核分给两个循环中的任意一个
+  std::vector<std::string> multiReactor;
+  {
+    MultiReactor server({.loops = 2});
+    multiReactor = chatSession(server.port());
+  }
+  // 房间归其中一个循环所有，另一个循环收到的请求经信箱转过去
+  std::vector<std::string> roomAffinity;
+  {
+    MultiReactor server({.loops = 2, .roomAffinity = true});
+    roomAffinity = chatSession(server.port());
+  }
+  ASSERT_EQ(threaded.size(), 11u);
+  EXPECT_EQ(threaded[0], "HTTP/1.1 200 {\"status\":\"success\"}");
+  EXPECT_EQ(threaded[1].substr(0, 12), "HTTP/1.1 400");
+  EXPECT_EQ(threaded[7].substr(0, 12), "HTTP/1.1 401");
+  EXPECT_NE(threaded[9].find("hi 你好"), std::string::npos);
+  EXPECT_EQ(threaded, epoll);
+  EXPECT_EQ(threaded, multiReactor);
+  EXPECT_EQ(threaded, roomAffinity);
+}
+
+TEST(RoomAffinityTest, CachedPollsMatchDatabaseAnswers) {
+  char dirTemplate[] = "/tmp/chat_affinity_test_XXXXXX";
+  std::string dir = mkdtemp(dirTemplate);
+  std::string dbPath = dir + "/chat.db";
+  utils::Counter hits = utils::metrics().counter(
+      "room_cache_lookups_total",
+      "Message polls answered by the owning loop's room cache",
+      {{"result", "hit"}});
+
+  // 时间戳大于建立缓存时刻的消息都在缓存里：since 在此之前（含 0）
+  // 查数据库，之后由房间所属的循环从缓存回答
+  std::vector<int64_t> sinces;
+  std::vector<std::string> cached;
+  {
+    MultiReactor server({.loops = 2, .roomAffinity = true, .dbPath = dbPath});
+    std::string token = loginAs(server.port(), "alice");
+    ASSERT_FALSE(token.empty());
+    roundTrip(server.port(),
+              request("POST", "/create_room",
+                      R"({"name":"lobby","creator":"alice"})", token));
+    pollRoom(server.port(), token, "lobby", 1);  // 建立房间缓存
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for (int i = 0; i < 5; ++i) {
+      std::string body = R"({"room":"lobby","username":"alice","content":"m)" +
+                         std::to_string(i) + R"( \"引号\""})";
+      std::string response =
+          roundTrip(server.port(), request("POST", "/send_message", body,
+                                           token));
+      ASSERT_EQ(response.rfind("HTTP/1.1 200", 0), 0u) << response;
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    std::string all = pollRoom(server.port(), token, "lobby", 0);
+    std::vector<int64_t> timestamps;
+    std::regex timestamp("\"timestamp\":([0-9]+)");
+    for (std::sregex_iterator it(all.begin(), all.end(), timestamp), end;
+         it != end; ++it) {
+      timestamps.push_back(std::stoll((*it)[1]));
+    }
+    ASSERT_EQ(timestamps.size(), 5u) << all;
+
+    sinces = {0, 1, timestamps[0] - 1, timestamps[0], timestamps[2],
+              timestamps[4]};
+    uint64_t hitsBefore = hits.value();
+    for (int64_t since : sinces) {
+      cached.push_back(pollRoom(server.port(), token, "lobby", since));
+    }
+    EXPECT_EQ(hits.value() - hitsBefore, 4u);
+  }
+
+  // 同一个数据库文件，不启用房间亲和，全部由数据库回答
+  std::vector<std::string> database;
+  {
+    MultiReactor server({.loops = 2, .dbPath = dbPath});
+    std::string token = loginAs(server.port(), "alice");
+    ASSERT_FALSE(token.empty());
+    for (int64_t since : sinces) {
+      database.push_back(pollRoom(server.port(), token, "lobby", since));
+    }
+  }
+  std::filesystem::remove_all(dir);
+  EXPECT_EQ(cached, database);
+  EXPECT_NE(cached[3].find("m1"), std::string::npos);
+  EXPECT_EQ(cached[5], "[]");
+}
+
+TEST(IoUringTest, AnswersLikeEpoll) {
+  std::vector<std::string> epoll;
+  {
+    EpollServer server;
+    epoll = chatSession(server.port());
+  }
+  EpollServer server({}, reactor::IoBackend::IoUring);
+  if (!server.backendReady()) GTEST_SKIP() << "io_uring unavailable";
+  EXPECT_EQ(chatSession(server.port()), epoll);
+}
+
+TEST(IoUringTest, SendsLargeStaticFileInChunks) {
+  EpollServer server({}, reactor::IoBackend::IoUring);
+  if (!server.backendReady()) GTEST_SKIP() << "io_uring unavailable";
+  // 超过内存缓存上限，按块 pread 后发送；长度不是块大小的整数倍
+  std::string content(1000003, '\0');
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+  }
+  std::ofstream(server.staticDir() + "/big.txt", std::ios::binary)
+      << content;
+
+  std::string response =
+      roundTrip(server.port(), "GET /big.txt HTTP/1.1\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 200", 0), 0u) << response.substr(0, 200);
+  std::string body = bodyOf(response);
+  EXPECT_EQ(body.size(), content.size());
+  EXPECT_TRUE(body == content);
+}
+
+TEST(IoUringTest, FinishesShortWritesOfSharedBodies) {
+  MultiReactor server({.loops = 1,
+                       .roomAffinity = true,
+                       .backend = reactor::IoBackend::IoUring});
+  if (!server.backendReady()) GTEST_SKIP() << "io_uring unavailable";
+  utils::Counter hits = utils::metrics().counter(
+      "room_cache_lookups_total",
+      "Message polls answered by the owning loop's room cache",
+      {{"result", "hit"}});
+  std::string token = loginAs(server.port(), "alice");
+  ASSERT_FALSE(token.empty());
+  roundTrip(server.port(),
+            request("POST", "/create_room",
+                    R"({"name":"lobby","creator":"alice"})", token));
+  pollRoom(server.port(), token, "lobby", 1);  // 建立房间缓存
+  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  // 缓存的应答约 6MB，超过服务器 socket 发送缓冲区的上限（通常 4MB）
+  std::string content(200000, 'x');
+  for (int i = 0; i < 30; ++i) {
+    std::string response = roundTrip(
+        server.port(),
+        request("POST", "/send_message",
+                R"({"room":"lobby","username":"alice","content":")" +
+                    content + "\"}",
+                token));
+    ASSERT_EQ(response.rfind("HTTP/1.1 200", 0), 0u) << response;
+  }
+  std::string all = pollRoom(server.port(), token, "lobby", 0);
+  std::smatch first;
+  ASSERT_TRUE(
+      std::regex_search(all, first, std::regex("\"timestamp\":([0-9]+)")));
+  int64_t since = std::stoll(first[1]) - 1;
+
+  // 接收缓冲区很小、先不读，服务器的发送只能部分完成，剩下的从
+  // 共享缓冲区续发
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_GE(fd, 0);
+  int bufferSize = 4096;
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = htons(server.port());
+  ASSERT_EQ(connect(fd, (sockaddr*)&addr, sizeof(addr)), 0);
+  uint64_t hitsBefore = hits.value();
+  std::string poll = request(
+      "GET", "/rooms/lobby/messages?since=" + std::to_string(since), "", token);
+  send(fd, poll.data(), poll.size(), MSG_NOSIGNAL);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  std::string body = bodyOf(readAll(fd));
+  close(fd);
+  EXPECT_EQ(hits.value() - hitsBefore, 1u);
+  EXPECT_EQ(body.size(), all.size());
+  EXPECT_TRUE(body == all);
+}
+
+TEST(TransportOptionsTest, ParsesFlagsAndRejectsUnknownValues) {
+  std::vector<std::string> args = {"--transport=multi-reactor", "8080",
+                                   "--io=uring", "--loops=4", "static",
+                                   "--room-affinity"};
+  TransportOptions options = parseTransport(args);
+  EXPECT_EQ(options.transport, Transport::MultiReactor);
+  EXPECT_EQ(options.io, reactor::IoBackend::IoUring);
+  EXPECT_EQ(options.loops, 4);
+  EXPECT_TRUE(options.roomAffinity);
+  EXPECT_EQ(args, (std::vector<std::string>{"8080", "static"}));
+
+  std::vector<std::string> defaults = {"8080"};
+  options = parseTransport(defaults);
+  EXPECT_EQ(options.transport, Transport::Threaded);
+  EXPECT_FALSE(options.io.has_value());
+
+  std::vector<std::string> unknownTransport = {"--transport=fibers"};
+  EXPECT_THROW(parseTransport(unknownTransport), std::invalid_argument);
+  std::vector<std::string> unknownIo = {"--transport=epoll", "--io=kqueue"};
+  EXPECT_THROW(parseTransport(unknownIo), std::invalid_argument);
+  // 线程池传输没有事件循环
+  std::vector<std::string> threadedIo = {"--io=uring"};
+  EXPECT_THROW(parseTransport(threadedIo), std::invalid_argument);
+  // 房间分片只在多个事件循环之间进行
+  std::vector<std::string> epollAffinity = {"--transport=epoll",
+                                            "--room-affinity"};
+  EXPECT_THROW(parseTransport(epollAffinity), std::invalid_argument);
+  std::vector<std::string> threadedAffinity = {"--room-affinity"};
+  EXPECT_THROW(parseTransport(threadedAffinity), std::invalid_argument);
+}
@@ -1,12 +1,47 @@
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
 
 #include <atomic>
+#include <chrono>
+#include <ctime>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <set>
+#include <stdexcept>
 #include <thread>
+#include <vector>
 
+#include "../src/chat/chat_json.hpp"
+#include "../src/chat/requests.hpp"
+#include "../src/chat/room_shards.hpp"
+#include "../src/chat/session_store.hpp"
+#include "../src/http/http_request.hpp"
+#include "../src/http/http_response.hpp"
+#include "../src/http/rate_limiter.hpp"
+#include "../src/http/response_compression.hpp"
+#include "../src/http/router.hpp"
+#include "../src/http/static_file_cache.hpp"
+#include "../src/reactor/event_loop.hpp"
+#include "../src/reactor/offload.hpp"
+#include "../src/reactor/task.hpp"
+#include "../src/utils/arena.hpp"
+#include "../src/utils/compress.hpp"
+#include "../src/utils/json_reader.hpp"
+#include "../src/utils/json_writer.hpp"
 #include "../src/utils/logger.hpp"
+#include "../src/utils/metrics.hpp"
+#include "../src/utils/mpsc_queue.hpp"
+#include "../src/utils/object_pool.hpp"
+#include "../src/utils/shared_buffer.hpp"
+#include "../src/utils/thread_pool.hpp"
 #include "../src/utils/timer.hpp"
+#include "../src/utils/tracing.hpp"
 
 TEST(LoggerTest, LogLevelSetAndGet) {
   using namespace utils;
@@ -69,4 +104,918 @@ TEST(TimerTest, PeriodicTask) {
   std::this_thread::sleep_for(std::chrono::milliseconds(220));
   timer.stop();
   EXPECT_GE(count, 3);  // 至少执行3次
-}
\ No newline at end of file
+}
+
+TEST(TimerTest, SleepsUntilFutureTaskIsDue) {
+  auto processCpu = []() {
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) +
+           std::chrono::nanoseconds(ts.tv_nsec);
+  };
+  utils::Timer timer;
+  std::atomic<bool> called{false};
+  timer.start();
+  timer.addOnceTask(std::chrono::seconds(10), [&] { called = true; });
+  auto before = processCpu();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  auto used = processCpu() - before;
+  timer.stop();
+  // 等待期间计时线程应阻塞在条件变量上，空转会用掉整整 300ms CPU
+  EXPECT_LT(used, std::chrono::milliseconds(50));
+  EXPECT_FALSE(called);
+}
+
+TEST(JsonWriterTest, MatchesNlohmannDump) {
+  std::string out;
+  utils::JsonWriter writer(out);
+  writer.beginArray()
+      .beginObject()
+      .key("content")
+      .value("say \"hi\"\n\t\x01 你好")
+      .key("timestamp")
+      .value(int64_t{1700000000000})
+      .key("username")
+      .value("alice")
+      .endObject()
+      .beginObject()
+      .key("members")
+      .beginArray()
+      .endArray()
+      .key("online")
+      .value(false)
+      .endObject()
+      .endArray();
+
+  nlohmann::json expected = nlohmann::json::array();
+  expected.push_back({{"content", "say \"hi\"\n\t\x01 你好"},
+                      {"timestamp", 1700000000000},
+                      {"username", "alice"}});
+  expected.push_back(
+      {{"members", nlohmann::json::array()}, {"online", false}});
+  EXPECT_EQ(out, expected.dump());
+  EXPECT_EQ(nlohmann::json::parse(out), expected);
+}
+
+TEST(JsonWriterTest, ReplacesInvalidUtf8) {
+  std::string out;
+  utils::JsonWriter::escape(out, "a\xff\xc0\x80" "b\xed\xa0\x80");
+  EXPECT_EQ(out, "a\\ufffd\\ufffd\\ufffdb\\ufffd\\ufffd\\ufffd");
+  EXPECT_NO_THROW(nlohmann::json::parse("\"" + out + "\""));
+}
+
+TEST(JsonReaderTest, FastPathFields) {
+  utils::JsonReader data(
+      R"( {"room":"lobby", "since":1700000000000, "username":"张三",)"
+      R"( "content":"a longer message that spans simd blocks 你好世界",)"
+      R"( "flag":true, "none":null} )");
+  ASSERT_TRUE(data.ok());
+  EXPECT_FALSE(data.usedFallback());
+  EXPECT_EQ(data.getString("room"), "lobby");
+  EXPECT_EQ(data.getString("username"), "张三");
+  EXPECT_EQ(data.getString("content"),
+            "a longer message that spans simd blocks 你好世界");
+  EXPECT_EQ(data.getInt("since"), 1700000000000);
+  EXPECT_TRUE(data.contains("flag"));
+  EXPECT_TRUE(data.isNull("none"));
+  EXPECT_FALSE(data.getString("since").has_value());
+  EXPECT_FALSE(data.contains("password"));
+}
+
+TEST(JsonReaderTest, FallbackAndInvalid) {
+  utils::JsonReader escaped(R"({"content":"say \"hi\"\n","since":1.5})");
+  ASSERT_TRUE(escaped.ok());
+  EXPECT_TRUE(escaped.usedFallback());
+  EXPECT_EQ(escaped.getString("content"), "say \"hi\"\n");
+  EXPECT_EQ(escaped.getInt("since"), 1);
+
+  EXPECT_FALSE(utils::JsonReader(R"({"room":"lobby")").ok());
+  EXPECT_FALSE(utils::JsonReader("{\"room\":\"\xff\"}").ok());
+  EXPECT_FALSE(utils::JsonReader("").ok());
+}
+
+TEST(BoundRequestTest, BindsTypedFields) {
+  utils::BoundRequest<GetMessagesRequest> fast(
+      R"({"room":"lobby","since":null,"username":"alice","extra":[1]})");
+  ASSERT_TRUE(fast.ok());  // 数组字段触发回退，结果一致
+  EXPECT_EQ(fast->room, "lobby");
+  EXPECT_FALSE(fast->since.has_value());
+  EXPECT_EQ(fast->username, "alice");
+
+  utils::BoundRequest<GetMessagesRequest> noUser(
+      R"({"room":"lobby","since":42})");
+  ASSERT_TRUE(noUser.ok());
+  EXPECT_EQ(noUser->since, 42);
+  EXPECT_FALSE(noUser->username.has_value());
+
+  utils::BoundRequest<SendMessageRequest> escaped(
+      R"({"room":"r","username":"u","content":"line\nbreak"})");
+  ASSERT_TRUE(escaped.ok());
+  EXPECT_EQ(escaped->content, "line\nbreak");
+}
+
+TEST(BoundRequestTest, RejectsInvalidRequests) {
+  EXPECT_EQ(utils::BoundRequest<LoginRequest>(R"({"username":"a"})").status(),
+            utils::BindStatus::MissingField);
+  EXPECT_EQ(utils::BoundRequest<LoginRequest>(
+                R"({"username":"a","password":123})")
+                .status(),
+            utils::BindStatus::MissingField);
+  EXPECT_EQ(utils::BoundRequest<LoginRequest>(R"({"username":)").status(),
+            utils::BindStatus::InvalidJson);
+  EXPECT_EQ(utils::BoundRequest<GetMessagesRequest>(R"({"room":"r"})").status(),
+            utils::BindStatus::MissingField);
+}
+
+TEST(ArenaTest, AllocatesAlignedAndReusesBlock) {
+  utils::Arena arena(64);
+  void* small = arena.allocate(3, 1);
+  auto* big = static_cast<double*>(arena.allocate(200 * sizeof(double)));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(big) % alignof(std::max_align_t), 0u);
+  EXPECT_TRUE(arena.owns(small));
+  EXPECT_TRUE(arena.owns(big + 199));
+
+  int local = 0;
+  EXPECT_FALSE(arena.owns(&local));
+
+  // 多个块在 reset 后合并为一个，同样的用量不再扩容
+  arena.reset();
+  void* first = arena.allocate(3, 1);
+  arena.allocate(200 * sizeof(double));
+  arena.reset();
+  EXPECT_EQ(arena.allocate(3, 1), first);
+}
+
+TEST(ObjectPoolTest, ReusesSlotsAndRunsDestructors) {
+  struct Tracked {
+    explicit Tracked(int* live) : live(live) { ++*live; }
+    ~Tracked() { --*live; }
+    int* live;
+    std::string name;
+  };
+  int live = 0;
+  utils::ObjectPool<Tracked, 4> pool;
+  std::vector<Tracked*> objects;
+  for (int i = 0; i < 6; ++i) objects.push_back(pool.create(&live));
+  EXPECT_EQ(live, 6);
+  EXPECT_EQ(pool.size(), 6u);
+  EXPECT_EQ(pool.capacity(), 8u);
+  std::set<Tracked*> distinct(objects.begin(), objects.end());
+  EXPECT_EQ(distinct.size(), 6u);
+
+  // 释放的槽位先被复用，池不再扩容
+  Tracked* freed = objects[2];
+  pool.destroy(freed);
+  EXPECT_EQ(live, 5);
+  objects[2] = pool.create(&live);
+  EXPECT_EQ(objects[2], freed);
+  for (int i = 0; i < 2; ++i) objects.push_back(pool.create(&live));
+  EXPECT_EQ(pool.capacity(), 8u);
+  objects.push_back(pool.create(&live));
+  EXPECT_EQ(pool.capacity(), 12u);
+  EXPECT_EQ(live, 9);
+
+  for (Tracked* object : objects) pool.destroy(object);
+  EXPECT_EQ(live, 0);
+  EXPECT_EQ(pool.size(), 0u);
+}
+
+TEST(ArenaTest, ChatJsonMatchesNlohmann) {
+  utils::Arena arena;
+  std::string dumped;
+  {
+    utils::ArenaScope scope(arena);
+    chat_json event = {{"room", "lobby"},
+                       {"timestamp", int64_t{1718000000000}},
+                       {"tags", {"a", "b"}},
+                       {"content", "你好 \"quoted\""}};
+    event["extra"] = std::string(100, 'x');
+    EXPECT_GT(arena.bytesUsed(), 0u);
+    auto text = event.dump();
+    dumped.assign(text.data(), text.size());
+  }
+  EXPECT_EQ(arena.bytesUsed(), 0u);
+
+  nlohmann::json expected = {{"room", "lobby"},
+                             {"timestamp", int64_t{1718000000000}},
+                             {"tags", {"a", "b"}},
+                             {"content", "你好 \"quoted\""}};
+  expected["extra"] = std::string(100, 'x');
+  EXPECT_EQ(dumped, expected.dump());
+
+  // 作用域外退化为普通堆分配
+  chat_json outside = {{"k", "v"}};
+  EXPECT_EQ(outside.dump(), "{\"k\":\"v\"}");
+}
+
+TEST(HttpMessageTest, ParsesRequestWithoutCopying) {
+  utils::Arena arena;
+  utils::ArenaScope scope(arena);
+  std::string raw =
+      "POST /messages?room=a%20b&q=x+y HTTP/1.1\r\n"
+      "Host: localhost\r\n"
+      "content-length:  7 \r\n"
+      "\r\n"
+      "{\"a\":1}";
+  auto request = http::HttpRequest::parse(raw);
+  EXPECT_EQ(request.method(), "POST");
+  EXPECT_EQ(request.path(), "/messages");
+  EXPECT_EQ(request.body(), "{\"a\":1}");
+  EXPECT_EQ(request.body().data(), raw.data() + raw.size() - 7);
+  EXPECT_EQ(request.header("Content-Length"), "7");
+  EXPECT_FALSE(request.header("Cookie").has_value());
+  EXPECT_EQ(request.queryParam("room"), "a b");
+  EXPECT_EQ(request.queryParam("q"), "x y");
+}
+
+TEST(HttpMessageTest, SerializesResponse) {
+  http::HttpResponse response(404, "{\"error\":\"x\"}");
+  response.setHeader("X-Test", "1");
+  response.setHeader("X-Test", "2");
+  response.setHeader("Content-Length", "999");  // 总是按响应体生成
+  EXPECT_EQ(response.toString(),
+            "HTTP/1.1 404 Not Found\r\n"
+            "Content-Length: 13\r\n"
+            "Content-Type: application/json\r\n"
+            "X-Test: 2\r\n"
+            "\r\n"
+            "{\"error\":\"x\"}");
+}
+
+TEST(HttpMessageTest, SerializesHeadersWithoutBody) {
+  http::HttpResponse response(200, std::string(4096, 'Q'));
+  utils::ArenaString head = response.serializeHeaders();
+  EXPECT_EQ(head.find('Q'), utils::ArenaString::npos);
+  EXPECT_EQ(head.substr(head.size() - 4), "\r\n\r\n");
+  EXPECT_EQ(head.size() + response.body().size(), response.toString().size());
+  EXPECT_EQ(http::HttpResponse(299).serializeHeaders().substr(0, 29),
+            "HTTP/1.1 299 Unknown Status\r\n");
+
+  // 形如 "Sun, 18 Oct 2026 08:00:00 GMT"
+  std::string_view date = http::httpDate();
+  EXPECT_EQ(date.size(), 29u);
+  EXPECT_EQ(date.substr(3, 2), ", ");
+  EXPECT_EQ(date.substr(25), " GMT");
+  EXPECT_EQ(http::httpDate().data(), date.data());
+}
+
+TEST(StaticFileCacheTest, NegotiatesEncoding) {
+  using utils::ContentEncoding;
+  EXPECT_EQ(utils::negotiateEncoding("gzip, deflate, br", true, true),
+            ContentEncoding::Brotli);
+  EXPECT_EQ(utils::negotiateEncoding("gzip, br;q=0", true, true),
+            ContentEncoding::Gzip);
+  EXPECT_EQ(utils::negotiateEncoding("GZIP;q=0.5", true, false),
+            ContentEncoding::Gzip);
+  EXPECT_EQ(utils::negotiateEncoding("br", true, false),
+            ContentEncoding::Identity);
+  EXPECT_EQ(utils::negotiateEncoding("", true, true),
+            ContentEncoding::Identity);
+}
+
+TEST(StaticFileCacheTest, ServesCachedVariantsAndRevalidates) {
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / "chat_static_cache_test";
+  fs::remove_all(root);
+  fs::create_directories(root);
+  std::string css;
+  for (int i = 0; i < 200; ++i) css += "body { margin: 0; }\n";
+  std::ofstream(root / "style.css") << css;
+
+  utils::Arena arena;
+  utils::ArenaScope scope(arena);
+  http::StaticFileCache cache(root.string());
+  EXPECT_EQ(cache.size(), 1u);
+
+  std::string raw = "GET /style.css HTTP/1.1\r\n\r\n";
+  auto plain = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(plain.statusCode(), 200);
+  EXPECT_EQ(plain.body(), css);
+
+  raw = "GET /style.css HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n";
+  auto gzip = cache.respond(http::HttpRequest::parse(raw));
+  std::string etag;
+  for (const auto& header : gzip.headers()) {
+    if (header.first == "ETag") etag = std::string(header.second.c_str());
+  }
+  if (utils::contentEncodingAvailable(utils::ContentEncoding::Gzip)) {
+    EXPECT_LT(gzip.body().size(), css.size());
+    EXPECT_NE(etag.find("-gzip"), std::string::npos);
+  }
+
+  raw = "GET /style.css HTTP/1.1\r\nAccept-Encoding: gzip\r\n"
+        "If-None-Match: " + etag + "\r\n\r\n";
+  auto cached = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(cached.statusCode(), 304);
+  EXPECT_TRUE(cached.body().empty());
+
+  raw = "GET /../etc/passwd HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(cache.respond(http::HttpRequest::parse(raw)).statusCode(), 404);
+
+  // mtime 变化后在检查间隔过后重新加载
+  std::ofstream(root / "style.css") << "p {}";
+  fs::last_write_time(root / "style.css",
+                      fs::last_write_time(root / "style.css") +
+                          std::chrono::seconds(5));
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  raw = "GET /style.css HTTP/1.1\r\n\r\n";
+  EXPECT_EQ(cache.respond(http::HttpRequest::parse(raw)).body(), "p {}");
+  fs::remove_all(root);
+}
+
+TEST(StaticFileCacheTest, ServesLargeFilesByRange) {
+  namespace fs = std::filesystem;
+  fs::path root = fs::temp_directory_path() / "chat_static_range_test";
+  fs::remove_all(root);
+  fs::create_directories(root);
+  std::ofstream(root / "video.bin") << std::string(1000, 'x');
+
+  utils::Arena arena;
+  utils::ArenaScope scope(arena);
+  http::StaticFileCache cache(root.string(), 100);  // 超过 100 字节不缓存
+
+  std::string raw = "GET /video.bin HTTP/1.1\r\n\r\n";
+  auto full = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(full.statusCode(), 200);
+  ASSERT_TRUE(full.fileBody());
+  EXPECT_EQ(full.fileBody()->offset, 0u);
+  EXPECT_EQ(full.fileBody()->length, 1000u);
+  EXPECT_NE(full.toString().find("Content-Length: 1000\r\n"),
+            utils::ArenaString::npos);
+
+  raw = "GET /video.bin HTTP/1.1\r\nRange: bytes=100-199\r\n\r\n";
+  auto part = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(part.statusCode(), 206);
+  ASSERT_TRUE(part.fileBody());
+  EXPECT_EQ(part.fileBody()->offset, 100u);
+  EXPECT_EQ(part.fileBody()->length, 100u);
+  EXPECT_NE(part.toString().find("Content-Range: bytes 100-199/1000\r\n"),
+            utils::ArenaString::npos);
+
+  raw = "GET /video.bin HTTP/1.1\r\nRange: bytes=-10\r\n\r\n";
+  auto suffix = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(suffix.statusCode(), 206);
+  EXPECT_EQ(suffix.fileBody()->offset, 990u);
+
+  raw = "GET /video.bin HTTP/1.1\r\nRange: bytes=5000-\r\n\r\n";
+  auto invalid = cache.respond(http::HttpRequest::parse(raw));
+  EXPECT_EQ(invalid.statusCode(), 416);
+  EXPECT_NE(invalid.toString().find("Content-Range: bytes */1000\r\n"),
+            utils::ArenaString::npos);
+
+  // If-Range 与当前 ETag 不一致时忽略 Range，返回整个文件
+  raw = "GET /video.bin HTTP/1.1\r\nRange: bytes=0-9\r\n"
+        "If-Range: \"stale\"\r\n\r\n";
+  EXPECT_EQ(cache.respond(http::HttpRequest::parse(raw)).statusCode(), 200);
+  fs::remove_all(root);
+}
+
+TEST(ResponseCompressionTest, CompressesLargeTextResponses) {
+  if (!utils::contentEncodingAvailable(utils::ContentEncoding::Gzip)) {
+    GTEST_SKIP() << "built without zlib";
+  }
+  utils::Arena arena;
+  utils::ArenaScope scope(arena);
+  std::string json = "[";
+  for (int i = 0; i < 100; ++i) {
+    json += "{\"username\":\"alice\",\"content\":\"hello\"},";
+  }
+  json.back() = ']';
+  http::CompressionOptions options;
+  options.enabled = true;
+  auto gzipRequest = http::HttpRequest::parse(
+      "POST /messages HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+  auto plainRequest =
+      http::HttpRequest::parse("POST /messages HTTP/1.1\r\n\r\n");
+
+  http::HttpResponse response(200, json);
+  ASSERT_TRUE(http::compressResponse(gzipRequest, response, options));
+  EXPECT_EQ(response.header("Content-Encoding"), "gzip");
+  EXPECT_EQ(response.header("Vary"), "Accept-Encoding");
+  // 复用的线程内压缩器与一次性压缩结果一致
+  EXPECT_EQ(response.body(), utils::gzipCompress(json, options.gzipLevel));
+  std::string again;
+  ASSERT_TRUE(utils::compressTo(utils::ContentEncoding::Gzip, json,
+                                options.gzipLevel, again));
+  EXPECT_EQ(again, response.body());
+
+  http::HttpResponse identity(200, json);
+  EXPECT_FALSE(http::compressResponse(plainRequest, identity, options));
+  EXPECT_EQ(identity.body(), json);
+
+  http::HttpResponse small(200, "{\"status\":\"success\"}");
+  EXPECT_FALSE(http::compressResponse(gzipRequest, small, options));
+
+  options.enabled = false;
+  http::HttpResponse disabled(200, json);
+  EXPECT_FALSE(http::compressResponse(gzipRequest, disabled, options));
+}
+
+TEST(RouterTest, MatchesStaticParamAndWildcardRoutes) {
+  utils::Arena arena;
+  utils::ArenaScope scope(arena);
+  http::Router router;
+  router.add(http::Method::Get, "/", 0);
+  router.add(http::Method::Get, "/*", 1);
+  router.add(http::Method::Get, "/rooms", 2);
+  router.add(http::Method::Post, "/rooms", 3);
+  router.add(http::Method::Get, "/rooms/:name/messages", 4);
+  router.add(http::Method::Get, "/rooms/lobby/members", 5);
+
+  auto find = [&](http::Method method, std::string_view path,
+                  http::PathParams& params) {
+    params.clear();
+    return router.find(method, path, params);
+  };
+  http::PathParams params;
+  EXPECT_EQ(find(http::Method::Get, "/", params), 0u);
+  EXPECT_EQ(find(http::Method::Get, "/rooms", params), 2u);
+  EXPECT_EQ(find(http::Method::Post, "/rooms", params), 3u);
+  EXPECT_EQ(find(http::Method::Put, "/rooms", params),
+            http::Router::kNotFound);
+
+  EXPECT_EQ(find(http::Method::Get, "/rooms/a%20b/messages", params), 4u);
+  ASSERT_EQ(params.size(), 1u);
+  EXPECT_EQ(params[0].first, "name");
+  EXPECT_EQ(params[0].second, "a%20b");
+
+  // 静态段优先，深处失败时回溯到参数段
+  EXPECT_EQ(find(http::Method::Get, "/rooms/lobby/members", params), 5u);
+  EXPECT_TRUE(params.empty());
+  EXPECT_EQ(find(http::Method::Get, "/rooms/lobby/messages", params), 4u);
+  EXPECT_EQ(params[0].second, "lobby");
+
+  EXPECT_EQ(find(http::Method::Get, "/js/chat.js", params), 1u);
+  ASSERT_EQ(params.size(), 1u);
+  EXPECT_EQ(params[0].second, "js/chat.js");
+  EXPECT_EQ(find(http::Method::Post, "/js/chat.js", params),
+            http::Router::kNotFound);
+
+  EXPECT_EQ(http::parseMethod("DELETE"), http::Method::Delete);
+  EXPECT_EQ(http::parseMethod("get"), http::Method::Unknown);
+  EXPECT_THROW(router.add(http::Method::Get, "/a/*/b", 6),
+               std::invalid_argument);
+}
+
+TEST(SessionStoreTest, ResolvesExpiresAndRemovesTokens) {
+  SessionStore store(std::chrono::milliseconds(200));
+  std::string alice = store.create("alice");
+  std::string alice2 = store.create("alice");
+  std::string bob = store.create("bob");
+  EXPECT_EQ(alice.size(), SessionStore::kTokenLength);
+  EXPECT_NE(alice, alice2);
+  EXPECT_EQ(store.resolve(alice), "alice");
+  EXPECT_EQ(store.resolve(bob), "bob");
+  EXPECT_FALSE(store.resolve("not-a-token"));
+  EXPECT_FALSE(store.resolve(std::string(SessionStore::kTokenLength, '0')));
+
+  // 同一用户还有其他会话时，删除不算最后一个
+  EXPECT_FALSE(store.remove(alice));
+  EXPECT_FALSE(store.resolve(alice));
+  EXPECT_FALSE(store.remove(alice));
+
+  // bob 一直在访问，alice2 过期后只有 alice 离线
+  for (int i = 0; i < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_EQ(store.resolve(bob), "bob");
+  }
+  EXPECT_FALSE(store.resolve(alice2));
+  EXPECT_EQ(store.sweep(), std::vector<std::string>{"alice"});
+  EXPECT_EQ(store.size(), 1u);
+  EXPECT_TRUE(store.remove(bob));
+  EXPECT_EQ(store.size(), 0u);
+
+  const char* raw =
+      "GET / HTTP/1.1\r\nCookie: theme=dark; chat_session=abc \r\n\r\n";
+  auto request = http::HttpRequest::parse(raw);
+  EXPECT_EQ(SessionStore::tokenFrom(request), "abc");
+  raw = "GET / HTTP/1.1\r\nAuthorization: Bearer xyz\r\n"
+        "Cookie: chat_session=abc\r\n\r\n";
+  request = http::HttpRequest::parse(raw);
+  EXPECT_EQ(SessionStore::tokenFrom(request), "xyz");
+}
+
+TEST(SessionStoreTest, SweepsRefreshedSessionsInDeadlineOrder) {
+  using std::chrono::milliseconds;
+  SessionStore store(milliseconds(400));
+  auto start = std::chrono::steady_clock::now();
+  std::string alice = store.create("alice");  // 截止 400ms
+
+  std::this_thread::sleep_until(start + milliseconds(100));
+  EXPECT_EQ(store.resolve(alice), "alice");  // 顺延到 500ms
+
+  // 足够多的会话保证 alice 所在分片里也有截止时间晚于她的条目
+  std::this_thread::sleep_until(start + milliseconds(200));
+  for (int i = 0; i < 200; ++i) store.create("bob");  // 截止 600ms
+
+  // alice 的旧条目到期，按 500ms 重新排队，应排在 bob 之前
+  std::this_thread::sleep_until(start + milliseconds(450));
+  EXPECT_TRUE(store.sweep().empty());
+  EXPECT_EQ(store.size(), 201u);
+
+  std::this_thread::sleep_until(start + milliseconds(550));
+  EXPECT_EQ(store.sweep(), std::vector<std::string>{"alice"});
+  EXPECT_EQ(store.size(), 200u);
+}
+
+TEST(RateLimiterTest, LimitsPerIpPerUserAndPerRoute) {
+  http::RateLimitOptions options;
+  options.enabled = true;
+  options.perIp = {10, 3};
+  options.perUser = {1, 2};
+  options.routes = {{"POST", "/login", {1, 1}, {}}};
+  http::RateLimiter limiter(options);
+
+  // 桶满时可以连发 burst 个，之后按 rate 补充
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(limiter.acquireForIp(1, "GET", "/rooms"), 0u);
+  }
+  EXPECT_EQ(limiter.acquireForIp(1, "GET", "/rooms"), 1u);
+  EXPECT_EQ(limiter.acquireForIp(2, "GET", "/rooms"), 0u);
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  EXPECT_EQ(limiter.acquireForIp(1, "GET", "/rooms"), 0u);
+
+  // 路由单独计数；perUser 未设置表示该路由不按用户限流
+  EXPECT_EQ(limiter.acquireForIp(1, "POST", "/login"), 0u);
+  EXPECT_EQ(limiter.acquireForIp(1, "POST", "/login"), 1u);
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(limiter.acquireForUser("alice", "POST", "/login"), 0u);
+  }
+
+  EXPECT_EQ(limiter.acquireForUser("alice", "POST", "/messages"), 0u);
+  EXPECT_EQ(limiter.acquireForUser("alice", "POST", "/messages"), 0u);
+  EXPECT_EQ(limiter.acquireForUser("alice", "POST", "/messages"), 1u);
+  EXPECT_EQ(limiter.acquireForUser("bob", "POST", "/messages"), 0u);
+
+  http::HttpResponse response = http::tooManyRequests(3);
+  EXPECT_EQ(response.statusCode(), 429);
+  EXPECT_EQ(response.header("Retry-After"), "3");
+}
+
+TEST(RateLimiterTest, EvictsRefilledBuckets) {
+  http::RateLimitOptions options;
+  options.enabled = true;
+  options.perIp = {1000, 1};
+  http::RateLimiter limiter(options);
+  // 每个 IP 只取一个令牌，1ms 后就补满，插入过程中会被陆续清理
+  for (uint32_t ip = 0; ip < 100000; ++ip) {
+    limiter.acquireForIp(ip, "GET", "/");
+  }
+  EXPECT_LT(limiter.bucketCount(), 100000u);
+}
+
+TEST(MetricsTest, SumsPerThreadSlotsIncludingExitedThreads) {
+  utils::Counter counter = utils::metrics().counter(
+      "test_events_total", "Test counter", {{"kind", "a"}});
+  utils::Gauge gauge = utils::metrics().gauge("test_depth", "Test gauge");
+  // 同名同标签返回同一个槽
+  utils::metrics().counter("test_events_total", "Test counter",
+                           {{"kind", "a"}}).inc(5);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 1000; ++i) counter.inc();
+      gauge.add(3);
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  gauge.add(-2);
+  EXPECT_EQ(counter.value(), 4005u);
+  EXPECT_EQ(gauge.value(), 10);
+  EXPECT_THROW(utils::metrics().gauge("test_events_total", "Wrong type"),
+               std::invalid_argument);
+
+  std::string text = utils::metrics().render();
+  EXPECT_NE(text.find("# TYPE test_events_total counter\n"
+                      "test_events_total{kind=\"a\"} 4005\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("test_depth 10\n"), std::string::npos);
+}
+
+TEST(MetricsTest, HistogramBucketsQuantilesAndExposition) {
+  // 桶连续且相对宽度不超过 1/8
+  for (size_t b = 0; b + 1 < utils::Histogram::kBuckets; ++b) {
+    EXPECT_EQ(utils::Histogram::upperBound(b),
+              utils::Histogram::lowerBound(b + 1));
+  }
+  for (uint64_t v : {0ull, 7ull, 8ull, 1000ull, 123456789ull}) {
+    size_t b = utils::Histogram::bucketOf(v);
+    EXPECT_LE(utils::Histogram::lowerBound(b), v);
+    EXPECT_LT(v, utils::Histogram::upperBound(b));
+  }
+
+  utils::Histogram histogram = utils::metrics().histogram(
+      "test_latency_seconds", "Test histogram", {{"route", "/x"}});
+  for (int i = 0; i < 99; ++i) histogram.record(uint64_t{20000});  // 20us
+  histogram.record(std::chrono::milliseconds(3));
+  utils::Histogram::Snapshot snapshot = histogram.snapshot();
+  EXPECT_EQ(snapshot.count, 100u);
+  EXPECT_EQ(snapshot.sumNanos, 99u * 20000 + 3000000);
+  EXPECT_GE(snapshot.quantile(0.5), 20000u);
+  EXPECT_LE(snapshot.quantile(0.5), 20000u * 9 / 8);
+  EXPECT_GE(snapshot.quantile(1.0), 3000000u);
+
+  std::string text = utils::metrics().render();
+  EXPECT_NE(text.find("test_latency_seconds_bucket{route=\"/x\","
+                      "le=\"1e-05\"} 0\n"
+                      "test_latency_seconds_bucket{route=\"/x\","
+                      "le=\"2.5e-05\"} 99\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("test_latency_seconds_bucket{route=\"/x\","
+                      "le=\"0.005\"} 100\n"),
+            std::string::npos);
+  EXPECT_NE(text.find("test_latency_seconds_count{route=\"/x\"} 100\n"),
+            std::string::npos);
+}
+
+TEST(TracingTest, SamplesRequestsAndExportsChromeTrace) {
+  utils::Tracer& tracer = utils::tracer();
+  tracer.clear();
+  tracer.setSampleRate(0.5);
+  // 每两个请求采样一个；未采样请求中的阶段不记录
+  for (int i = 0; i < 4; ++i) {
+    utils::TraceRequest request("request");
+    utils::TraceSpan parse("parse", "http");
+    parse.end();
+    utils::TraceSpan db("query", "db");
+  }
+  tracer.setSampleRate(0);
+  {
+    utils::TraceRequest request("ignored");
+    utils::TraceSpan span("ignored");
+  }
+
+  nlohmann::json trace = nlohmann::json::parse(tracer.dumpChromeTrace());
+  std::map<std::string, int> counts;
+  std::set<uint64_t> requests;
+  for (const auto& event : trace["traceEvents"]) {
+    if (event["ph"] == "M") continue;
+    EXPECT_EQ(event["ph"], "X");
+    EXPECT_GE(event["dur"].get<double>(), 0);
+    ++counts[event["name"].get<std::string>()];
+    requests.insert(event["args"]["request"].get<uint64_t>());
+  }
+  EXPECT_EQ(counts["request"], 2);
+  EXPECT_EQ(counts["parse"], 2);
+  EXPECT_EQ(counts["query"], 2);
+  EXPECT_EQ(counts.count("ignored"), 0u);
+  EXPECT_EQ(requests.size(), 2u);
+  tracer.clear();
+}
+
+namespace {
+// 两次 offload：第一次的结果作为第二次的输入，记录执行和恢复的线程
+reactor::Task<int> addTwice(utils::ThreadPool* pool, int value,
+                            std::thread::id& workerThread,
+                            std::thread::id& resumedThread) {
+  int once = co_await reactor::offload(pool, [&workerThread, value]() {
+    workerThread = std::this_thread::get_id();
+    return value + 1;
+  });
+  int twice = co_await reactor::offload(pool, [once]() { return once + 1; });
+  resumedThread = std::this_thread::get_id();
+  co_return twice;
+}
+
+reactor::Task<int> failing(utils::ThreadPool* pool) {
+  co_return co_await reactor::offload(pool, []() -> int {
+    throw std::runtime_error("query failed");
+  });
+}
+}  // namespace
+
+TEST(TaskTest, RunsInlineWithoutEventLoop) {
+  utils::ThreadPool pool(1, "test");
+  std::thread::id worker;
+  std::thread::id resumed;
+  // 没有事件循环时 offload 不挂起，在当前线程执行
+  EXPECT_EQ(reactor::syncWait(addTwice(&pool, 1, worker, resumed)), 3);
+  EXPECT_EQ(worker, std::this_thread::get_id());
+  EXPECT_EQ(resumed, std::this_thread::get_id());
+  EXPECT_THROW(reactor::syncWait(failing(&pool)), std::runtime_error);
+}
+
+TEST(TaskTest, OffloadResumesOnEventLoop) {
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  utils::ThreadPool pool(1, "test");
+  reactor::EventLoop loop;
+  std::thread::id worker;
+  std::thread::id resumed;
+  std::optional<int> result;
+  bool started = false;
+  // 在事件循环的回调里启动，第一次 offload 就挂起
+  loop.queueInLoop([&]() {
+    reactor::spawn(addTwice(&pool, 40, worker, resumed),
+                   [&result](int value) { result = value; });
+    started = true;
+  });
+  for (int i = 0; i < 100 && !result; ++i) loop.runOnce(100);
+  ASSERT_TRUE(started);
+  ASSERT_EQ(result, 42);
+  EXPECT_NE(worker, std::this_thread::get_id());
+  EXPECT_EQ(resumed, std::this_thread::get_id());
+  EXPECT_EQ(reactor::EventLoop::current(), nullptr);
+}
+
+namespace {
+// 和数据库调用一样：查询在线程池中执行，恢复后在事件循环上发送
+reactor::Task<int> tracedQuery(utils::ThreadPool* pool) {
+  int rows = co_await reactor::offload(pool, []() {
+    utils::TraceSpan span("getRoomMessages", "db");
+    return 3;
+  });
+  utils::TraceSpan span("send", "http");
+  co_return rows;
+}
+}  // namespace
+
+TEST(TracingTest, FollowsRequestAcrossOffload) {
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  utils::Tracer& tracer = utils::tracer();
+  tracer.clear();
+  tracer.setSampleRate(1);
+  utils::ThreadPool pool(1, "test");
+  reactor::EventLoop loop;
+  std::optional<int> result;
+  // 请求在第一次 offload 时挂起，TraceRequest 随之结束
+  loop.queueInLoop([&]() {
+    utils::TraceRequest request("request");
+    reactor::spawn(tracedQuery(&pool), [&result](int rows) { result = rows; });
+  });
+  for (int i = 0; i < 100 && !result; ++i) loop.runOnce(100);
+  tracer.setSampleRate(0);
+  ASSERT_EQ(result, 3);
+
+  nlohmann::json trace = nlohmann::json::parse(tracer.dumpChromeTrace());
+  std::map<std::string, uint64_t> requestOf;
+  std::map<std::string, std::string> categoryOf;
+  for (const auto& event : trace["traceEvents"]) {
+    if (event["ph"] == "M") continue;
+    std::string name = event["name"];
+    requestOf[name] = event["args"]["request"].get<uint64_t>();
+    categoryOf[name] = event["cat"];
+  }
+  // 线程池中的查询和恢复后的发送都归到同一个请求下
+  ASSERT_EQ(requestOf.count("getRoomMessages"), 1u);
+  EXPECT_EQ(categoryOf["getRoomMessages"], "db");
+  ASSERT_EQ(requestOf.count("send"), 1u);
+  EXPECT_EQ(requestOf["getRoomMessages"], requestOf["request"]);
+  EXPECT_EQ(requestOf["send"], requestOf["request"]);
+  tracer.clear();
+}
+
+TEST(EventLoopTest, SkipsChannelRemovedEarlierInSameBatch) {
+  reactor::EventLoop loop;
+  // 两个 eventfd 在等待前都已可读，同一批返回。先执行的回调移除另一个，
+  // 被移除的 Channel 本轮不再回调
+  int fds[2] = {eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC),
+                eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC)};
+  int calls[2] = {0, 0};
+  for (int i = 0; i < 2; ++i) {
+    auto channel = std::make_shared<reactor::Channel>(fds[i]);
+    channel->setEvents(EPOLLIN);
+    channel->setReadCallback([&, i]() {
+      ++calls[i];
+      loop.removeChannel(fds[1 - i]);
+    });
+    loop.addChannel(channel);
+  }
+  EXPECT_EQ(loop.runOnce(100), 2);
+  EXPECT_EQ(calls[0] + calls[1], 1);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+TEST(EventLoopTest, ReleasesConnectionsClosedByQueuedTasks) {
+  reactor::EventLoop loop;
+  // 和服务器一样：关闭连接时先登记，清理回调里再关闭 fd
+  std::vector<int> closed;
+  loop.setCleanupCallback([&]() {
+    for (int fd : closed) close(fd);
+    closed.clear();
+  });
+  int fd = eventfd(0, EFD_CLOEXEC);
+  ASSERT_GE(fd, 0);
+  // 协程恢复后发送响应并关闭连接，都在排队的任务里
+  loop.queueInLoop([&]() { closed.push_back(fd); });
+  loop.runOnce(1000);
+  EXPECT_TRUE(closed.empty());
+  EXPECT_EQ(fcntl(fd, F_GETFD), -1);
+}
+
+TEST(MpscQueueTest, KeepsPerProducerOrder) {
+  constexpr int kProducers = 4;
+  constexpr int kItems = 20000;
+  utils::MpscQueue<std::pair<int, int>> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p]() {
+      for (int i = 0; i < kItems; ++i) queue.push({p, i});
+    });
+  }
+  // 消费者与生产者并发出队
+  std::vector<int> next(kProducers, 0);
+  int received = 0;
+  while (received < kProducers * kItems) {
+    std::optional<std::pair<int, int>> item = queue.pop();
+    if (!item) continue;
+    ASSERT_EQ(item->second, next[item->first]);
+    ++next[item->first];
+    ++received;
+  }
+  for (std::thread& t : producers) t.join();
+  EXPECT_FALSE(queue.pop());
+}
+
+namespace {
+reactor::Task<std::optional<std::string>> appendAndPoll(RoomShards& shards,
+                                                        std::string room,
+                                                        int64_t base) {
+  // 乱序追加，缓存按时间戳排序
+  co_await shards.append(room, base + 2, "{\"n\":2}");
+  co_await shards.append(room, base + 1, "{\"n\":1}");
+  co_await shards.append(room, base + 3, "{\"n\":3}");
+  std::optional<utils::SharedBuffer> first =
+      co_await shards.messagesAfter(room, base + 1);
+  std::optional<utils::SharedBuffer> second =
+      co_await shards.messagesAfter(room, base + 1);
+  // 相同的查询共用同一个缓冲区
+  if (!first || !second || first->data() != second->data()) {
+    co_return std::nullopt;
+  }
+  co_return std::string(first->view());
+}
+}  // namespace
+
+TEST(RoomShardsTest, RunsRoomOperationsOnOwningLoop) {
+  utils::Logger::setGlobalLogLevel(utils::LogLevel::ERROR);
+  RoomShards shards(2);
+  reactor::EventLoop loops[2];
+  shards.attach(0, loops[0]);
+  shards.attach(1, loops[1]);
+  // 晚于房间建立时间的时间戳
+  int64_t base = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::system_clock::now().time_since_epoch())
+                     .count() +
+                 60000;
+  std::string remote = "room";
+  while (shards.shardOf(remote) != 1) remote += "x";
+  std::string local = "room";
+  while (shards.shardOf(local) != 0) local += "y";
+
+  std::optional<std::string> remoteResult;
+  std::optional<std::string> localResult;
+  std::optional<bool> fullHistory;
+  loops[0].queueInLoop([&]() {
+    reactor::spawn(appendAndPoll(shards, remote, base),
+                   [&](std::optional<std::string> r) {
+                     remoteResult = r.value_or("miss");
+                   });
+    // 所属循环就是当前循环时不经过信箱，同步完成
+    reactor::spawn(appendAndPoll(shards, local, base),
+                   [&](std::optional<std::string> r) {
+                     localResult = r.value_or("miss");
+                   });
+    EXPECT_TRUE(localResult);
+    EXPECT_FALSE(remoteResult);
+    // since 为 0 要全部历史，缓存不回答
+    reactor::spawn(
+        [](RoomShards& s, std::string room)
+            -> reactor::Task<bool> {
+          co_return (co_await s.messagesAfter(room, 0)).has_value();
+        }(shards, local),
+        [&](bool cached) { fullHistory = cached; });
+  });
+  for (int i = 0; i < 200 && !remoteResult; ++i) {
+    loops[0].runOnce(5);
+    loops[1].runOnce(5);
+  }
+  EXPECT_EQ(remoteResult, "[{\"n\":2},{\"n\":3}]");
+  EXPECT_EQ(localResult, "[{\"n\":2},{\"n\":3}]");
+  EXPECT_EQ(fullHistory, false);
+}
+
+TEST(SharedBufferTest, SharesBytesAcrossCopiesAndResponses) {
+  utils::SharedBuffer buffer = utils::SharedBuffer::copyOf("[{\"n\":1}]");
+  EXPECT_EQ(buffer.view(), "[{\"n\":1}]");
+  EXPECT_EQ(buffer.useCount(), 1u);
+  {
+    utils::SharedBuffer copy = buffer;
+    EXPECT_EQ(copy.data(), buffer.data());
+    EXPECT_EQ(buffer.useCount(), 2u);
+    utils::ArenaScope arena(utils::threadArena());
+    http::HttpResponse resp(200);
+    resp.setHeader("Content-Type", "application/json");
+    resp.setBody(copy);
+    // 响应体直接引用共享缓冲区
+    EXPECT_EQ(resp.body().data(), buffer.data());
+    EXPECT_EQ(buffer.useCount(), 3u);
+    EXPECT_NE(resp.serializeHeaders().find("Content-Length: 9\r\n"),
+              std::string::npos);
+    resp.setBody(resp.body());  // 复制出来后释放引用
+    EXPECT_EQ(resp.body(), buffer.view());
+    EXPECT_TRUE(resp.sharedBody().empty());
+  }
+  EXPECT_EQ(buffer.useCount(), 1u);
+  EXPECT_TRUE(utils::SharedBuffer().empty());
+}
@@ -0,0 +1,857 @@
+#include "load_generator.hpp"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+
+#include "reactor/channel.hpp"
+#include "reactor/event_loop.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/json_writer.hpp"
+
+namespace loadgen {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* kPassword = "loadgen-password";
+// 消息内容：lg:<发送者>:<序号>:<发出时的 steady_clock 纳秒> 加上填充，
+// 接收方据此计算投递延迟
+constexpr std::string_view kMarker = "lg:";
+constexpr std::string_view kPadding =
+    " the quick brown fox jumps over the lazy dog";
+
+uint64_t steadyNanos(Clock::time_point t) {
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch())
+          .count());
+}
+
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+// 与 utils::Histogram 相同的分桶，只累计本次运行，不进全局注册表
+class LatencyRecorder {
+ public:
+  LatencyRecorder() : buckets_(utils::Histogram::kBuckets) {}
+
+  void record(uint64_t nanos) {
+    ++buckets_[utils::Histogram::bucketOf(nanos)];
+    sumNanos_ += nanos;
+    ++count_;
+  }
+  void merge(const LatencyRecorder& other) {
+    for (size_t b = 0; b < buckets_.size(); ++b) {
+      buckets_[b] += other.buckets_[b];
+    }
+    sumNanos_ += other.sumNanos_;
+    count_ += other.count_;
+  }
+  utils::Histogram::Snapshot snapshot() const {
+    utils::Histogram::Snapshot snapshot;
+    snapshot.count = count_;
+    snapshot.sumNanos = sumNanos_;
+    snapshot.buckets = buckets_;
+    return snapshot;
+  }
+
+ private:
+  std::vector<uint64_t> buckets_;
+  uint64_t sumNanos_ = 0;
+  uint64_t count_ = 0;
+};
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+           return std::tolower(static_cast<unsigned char>(x)) ==
+                  std::tolower(static_cast<unsigned char>(y));
+         });
+}
+
+struct Response {
+  int status = 0;
+  std::string_view body;
+};
+
+// 收到完整响应时返回 true。有 Content-Length 时按长度判断，
+// 否则读到连接关闭为止
+bool parseResponse(std::string_view data, bool eof, Response& response) {
+  size_t headerEnd = data.find("\r\n\r\n");
+  if (headerEnd == std::string_view::npos) return false;
+  std::string_view head = data.substr(0, headerEnd);
+  std::string_view body = data.substr(headerEnd + 4);
+  size_t space = head.find(' ');
+  if (space != std::string_view::npos) {
+    std::from_chars(head.data() + space + 1, head.data() + head.size(),
+                    response.status);
+  }
+  while (!head.empty()) {
+    size_t end = head.find("\r\n");
+    std::string_view line = head.substr(0, end);
+    head = end == std::string_view::npos ? std::string_view()
+                                         : head.substr(end + 2);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos ||
+        !equalsIgnoreCase(line.substr(0, colon), "Content-Length")) {
+      continue;
+    }
+    std::string_view value = line.substr(colon + 1);
+    while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+    size_t length = 0;
+    std::from_chars(value.data(), value.data() + value.size(), length);
+    if (body.size() < length) return false;
+    response.body = body.substr(0, length);
+    return true;
+  }
+  if (!eof) return false;
+  response.body = body;
+  return true;
+}
+
+bool isError(const Response& response) {
+  return response.status != 200 ||
+         response.body.find("\"error\"") != std::string_view::npos;
+}
+
+sockaddr_in resolve(const std::string& host, int port) {
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* result = nullptr;
+  if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+    throw std::runtime_error("Cannot resolve host: " + host);
+  }
+  sockaddr_in addr = *reinterpret_cast<sockaddr_in*>(result->ai_addr);
+  freeaddrinfo(result);
+  addr.sin_port = htons(static_cast<uint16_t>(port));
+  return addr;
+}
+
+class RequestBuilder {
+ public:
+  RequestBuilder(const Options& options)
+      : host_(options.host + ":" + std::to_string(options.port)) {}
+
+  std::string build(std::string_view method, std::string_view path,
+                    std::string_view token, std::string_view body) const {
+    std::string out;
+    out.reserve(160 + body.size());
+    out.append(method).append(" ").append(path).append(" HTTP/1.1\r\n");
+    out.append("Host: ").append(host_).append("\r\n");
+    if (!token.empty()) {
+      out.append("Authorization: Bearer ").append(token).append("\r\n");
+    }
+    if (method == "POST") {
+      out.append("Content-Type: application/json\r\n");
+      out.append("Content-Length: ")
+          .append(std::to_string(body.size()))
+          .append("\r\n");
+    }
+    out.append("\r\n").append(body);
+    return out;
+  }
+
+ private:
+  std::string host_;
+};
+
+std::string credentials(std::string_view username) {
+  std::string body;
+  utils::JsonWriter(body)
+      .beginObject()
+      .key("username")
+      .value(username)
+      .key("password")
+      .value(kPassword)
+      .endObject();
+  return body;
+}
+
+// 阻塞地发送一个请求并读到连接关闭，只用于开始前创建房间
+Response blockingRequest(const sockaddr_in& addr, const std::string& request,
+                         std::string& buffer) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) throw std::runtime_error("socket() failed");
+  timeval timeout{5, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) <
+      0) {
+    close(fd);
+    throw std::runtime_error(std::string("Cannot connect to server: ") +
+                             strerror(errno));
+  }
+  size_t sent = 0;
+  while (sent < request.size()) {
+    ssize_t n = send(fd, request.data() + sent, request.size() - sent,
+                     MSG_NOSIGNAL);
+    if (n <= 0) break;
+    sent += n;
+  }
+  buffer.clear();
+  char chunk[16384];
+  Response response;
+  while (!parseResponse(buffer, false, response)) {
+    ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+      parseResponse(buffer, true, response);
+      break;
+    }
+    buffer.append(chunk, n);
+  }
+  close(fd);
+  return response;
+}
+
+/**
+ * 一个事件循环线程及分给它的用户。除 stop() 外只在循环线程上调用，
+ * run() 返回后可以读取统计结果。
+ */
+class Driver {
+ public:
+  Driver(const Options& options, const sockaddr_in& addr,
+         const std::vector<std::string>& rooms, const std::string& prefix,
+         uint64_t seed)
+      : options_(options),
+        addr_(addr),
+        rooms_(rooms),
+        prefix_(prefix),
+        builder_(options),
+        rng_(seed),
+        mix_({options.mix.send, options.mix.poll, options.mix.rooms,
+              options.mix.users}) {
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd_ < 0) throw std::runtime_error("Failed to create timerfd");
+    auto timerChannel = std::make_shared<reactor::Channel>(timerFd_);
+    timerChannel->setEvents(EPOLLIN);
+    timerChannel->setReadCallback([this]() { handleTimer(); });
+    loop_.addChannel(timerChannel);
+    loop_.setCleanupCallback([this]() { afterEvents(); });
+  }
+  ~Driver() { close(timerFd_); }
+
+  void addUser(size_t id) {
+    User user;
+    user.index = users_.size();
+    user.id = id;
+    user.name = prefix_ + "user" + std::to_string(id);
+    size_t count = std::min(options_.roomsPerUser, rooms_.size());
+    for (size_t k = 0; k < count; ++k) {
+      user.rooms.push_back((id + k) % rooms_.size());
+    }
+    user.since.assign(user.rooms.size(), 0);
+    users_.push_back(std::move(user));
+  }
+
+  void run() {
+    // 在思考时间内错开各用户的第一个请求
+    Clock::time_point now = Clock::now();
+    std::uniform_int_distribution<int64_t> stagger(
+        0, std::max<int64_t>(options_.thinkTime.count(), 0));
+    for (User& user : users_) {
+      schedule(user, now + std::chrono::milliseconds(stagger(rng_)),
+               Wake::Next);
+    }
+    loop_.loop();
+    for (User& user : users_) {
+      if (user.fd >= 0) close(user.fd);
+    }
+  }
+
+  // 可在任意线程调用，在途请求不计入结果
+  void stop() {
+    loop_.queueInLoop([this]() { loop_.quit(); });
+  }
+
+  uint64_t requests[kRouteCount] = {};
+  uint64_t errors[kRouteCount] = {};
+  LatencyRecorder latency[kRouteCount];
+  LatencyRecorder delivery;
+
+ private:
+  enum class Wake : uint8_t { Next, Timeout };
+
+  struct User {
+    size_t index = 0;
+    size_t id = 0;
+    std::string name;
+    std::string token;
+    std::vector<size_t> rooms;  // rooms_ 的下标
+    // 0 注册，1 登录，2 起依次加入 rooms，之后进入稳定阶段
+    size_t setupStep = 0;
+    uint32_t seq = 0;
+    std::vector<int64_t> since;  // 与 rooms 对应，轮询的起点（服务器毫秒）
+    // (房间 << 32 | 发送者) -> 已收到的最大序号，用于去重
+    std::unordered_map<uint64_t, uint32_t> lastSeq;
+
+    // 在途请求
+    Route route = Route::Register;
+    size_t roomSlot = 0;
+    int fd = -1;
+    std::shared_ptr<reactor::Channel> channel;
+    std::string out;
+    size_t sent = 0;
+    std::string in;
+    bool connected = false;
+    Clock::time_point start;
+    // 每次开始和结束请求时加一，过期的定时项据此忽略
+    uint64_t generation = 0;
+  };
+
+  struct TimerEntry {
+    Clock::time_point when;
+    size_t user;
+    uint64_t generation;
+    Wake kind;
+    bool operator>(const TimerEntry& other) const { return when > other.when; }
+  };
+
+  void schedule(User& user, Clock::time_point when, Wake kind) {
+    bool earliest = timers_.empty() || when < timers_.top().when;
+    timers_.push(TimerEntry{when, user.index, user.generation, kind});
+    if (earliest) armTimer();
+  }
+
+  void armTimer() {
+    itimerspec spec{};
+    if (!timers_.empty()) {
+      auto nanos = timers_.top().when.time_since_epoch();
+      auto secs = std::chrono::duration_cast<std::chrono::seconds>(nanos);
+      spec.it_value.tv_sec = secs.count();
+      spec.it_value.tv_nsec =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(nanos - secs)
+              .count();
+      // it_value 全为 0 会关闭定时器
+      if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+      }
+    }
+    timerfd_settime(timerFd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+  }
+
+  void handleTimer() {
+    uint64_t expirations;
+    ssize_t n = read(timerFd_, &expirations, sizeof(expirations));
+    (void)n;
+    Clock::time_point now = Clock::now();
+    while (!timers_.empty() && timers_.top().when <= now) {
+      TimerEntry entry = timers_.top();
+      timers_.pop();
+      User& user = users_[entry.user];
+      if (entry.generation != user.generation) continue;
+      if (entry.kind == Wake::Timeout) {
+        if (user.fd >= 0) fail(user);
+      } else if (user.fd < 0) {
+        // 新连接可能复用本轮刚关闭的 fd，本轮后面还有它的旧事件，
+        // 所以等本轮事件处理完再发起
+        ready_.push_back(entry.user);
+      }
+    }
+    armTimer();
+  }
+
+  void afterEvents() {
+    retired_.clear();
+    std::vector<size_t> ready;
+    ready.swap(ready_);
+    for (size_t index : ready) startNext(users_[index]);
+  }
+
+  void startNext(User& user) {
+    if (user.setupStep == 0) {
+      startRequest(user, Route::Register, "POST", "/register",
+                   credentials(user.name));
+      return;
+    }
+    if (user.setupStep == 1) {
+      startRequest(user, Route::Login, "POST", "/login",
+                   credentials(user.name));
+      return;
+    }
+    if (user.setupStep < 2 + user.rooms.size()) {
+      user.roomSlot = user.setupStep - 2;
+      std::string body;
+      utils::JsonWriter(body)
+          .beginObject()
+          .key("room")
+          .value(rooms_[user.rooms[user.roomSlot]])
+          .key("username")
+          .value(user.name)
+          .endObject();
+      startRequest(user, Route::JoinRoom, "POST", "/join_room", body);
+      return;
+    }
+    int choice = mix_(rng_);
+    if (user.rooms.empty() && choice < 2) choice = 2;
+    if (choice == 0) {
+      user.roomSlot = rng_() % user.rooms.size();
+      std::string content(kMarker);
+      content.append(std::to_string(user.id))
+          .append(":")
+          .append(std::to_string(++user.seq))
+          .append(":")
+          .append(std::to_string(steadyNanos(Clock::now())))
+          .append(kPadding);
+      std::string body;
+      utils::JsonWriter(body)
+          .beginObject()
+          .key("room")
+          .value(rooms_[user.rooms[user.roomSlot]])
+          .key("username")
+          .value(user.name)
+          .key("content")
+          .value(content)
+          .endObject();
+      startRequest(user, Route::SendMessage, "POST", "/send_message", body);
+    } else if (choice == 1) {
+      user.roomSlot = rng_() % user.rooms.size();
+      std::string body;
+      utils::JsonWriter(body)
+          .beginObject()
+          .key("room")
+          .value(rooms_[user.rooms[user.roomSlot]])
+          .key("since")
+          .value(user.since[user.roomSlot])
+          .key("username")
+          .value(user.name)
+          .endObject();
+      startRequest(user, Route::PollMessages, "POST", "/messages", body);
+    } else if (choice == 2) {
+      startRequest(user, Route::Rooms, "GET", "/rooms", "");
+    } else {
+      startRequest(user, Route::Users, "GET", "/users", "");
+    }
+  }
+
+  void startRequest(User& user, Route route, std::string_view method,
+                    std::string_view path, std::string_view body) {
+    user.route = route;
+    user.out = builder_.build(method, path, user.token, body);
+    user.sent = 0;
+    user.in.clear();
+    user.connected = false;
+    user.start = Clock::now();
+    ++user.generation;
+
+    user.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (user.fd < 0) {
+      fail(user);
+      return;
+    }
+    if (connect(user.fd, reinterpret_cast<const sockaddr*>(&addr_),
+                sizeof(addr_)) < 0 &&
+        errno != EINPROGRESS) {
+      fail(user);
+      return;
+    }
+    size_t index = user.index;
+    user.channel = std::make_shared<reactor::Channel>(user.fd);
+    user.channel->setEvents(EPOLLOUT);
+    user.channel->setWriteCallback([this, index]() { onWritable(index); });
+    user.channel->setReadCallback([this, index]() { onReadable(index); });
+    user.channel->setCloseCallback([this, index]() { onReadable(index); });
+    user.channel->setErrorCallback([this, index]() { fail(users_[index]); });
+    loop_.addChannel(user.channel);
+    schedule(user, user.start + options_.requestTimeout, Wake::Timeout);
+  }
+
+  void onWritable(size_t index) {
+    User& user = users_[index];
+    if (user.fd < 0) return;
+    if (!user.connected) {
+      int error = 0;
+      socklen_t len = sizeof(error);
+      getsockopt(user.fd, SOL_SOCKET, SO_ERROR, &error, &len);
+      if (error != 0) {
+        fail(user);
+        return;
+      }
+      user.connected = true;
+    }
+    while (user.sent < user.out.size()) {
+      ssize_t n = send(user.fd, user.out.data() + user.sent,
+                       user.out.size() - user.sent, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK) return;
+        fail(user);
+        return;
+      }
+      user.sent += n;
+    }
+    user.channel->setEvents(EPOLLIN);
+    loop_.updateChannel(user.channel);
+  }
+
+  void onReadable(size_t index) {
+    User& user = users_[index];
+    if (user.fd < 0) return;
+    bool eof = false;
+    char chunk[16384];
+    while (true) {
+      ssize_t n = recv(user.fd, chunk, sizeof(chunk), 0);
+      if (n > 0) {
+        user.in.append(chunk, n);
+        continue;
+      }
+      if (n == 0) {
+        eof = true;
+      } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        eof = true;
+      }
+      break;
+    }
+    Response response;
+    if (parseResponse(user.in, eof, response)) {
+      complete(user, response);
+    } else if (eof) {
+      fail(user);
+    }
+  }
+
+  void closeConnection(User& user) {
+    if (user.fd >= 0) {
+      if (user.channel) loop_.removeChannel(user.fd);
+      close(user.fd);
+      user.fd = -1;
+    }
+    // 可能正处在这个 Channel 自己的回调中，本轮结束后再释放
+    if (user.channel) retired_.push_back(std::move(user.channel));
+    ++user.generation;
+  }
+
+  void fail(User& user) {
+    size_t route = static_cast<size_t>(user.route);
+    ++requests[route];
+    ++errors[route];
+    closeConnection(user);
+    scheduleNext(user);
+  }
+
+  void complete(User& user, const Response& response) {
+    Clock::time_point now = Clock::now();
+    size_t route = static_cast<size_t>(user.route);
+    ++requests[route];
+    latency[route].record(steadyNanos(now) - steadyNanos(user.start));
+    bool ok = !isError(response);
+    if (!ok) ++errors[route];
+
+    // 注册失败（如用户已存在）也继续登录，其余准备步骤失败时重试
+    switch (user.route) {
+      case Route::Register:
+        user.setupStep = 1;
+        break;
+      case Route::Login:
+        if (ok) {
+          utils::JsonReader reader(response.body);
+          if (auto token = reader.getString("token")) {
+            user.token = std::string(*token);
+            user.setupStep = 2;
+          }
+        }
+        break;
+      case Route::JoinRoom:
+        if (ok) {
+          user.since[user.roomSlot] = nowMs();
+          ++user.setupStep;
+        }
+        break;
+      case Route::PollMessages:
+        if (ok) recordDeliveries(user, response.body, now);
+        break;
+      default:
+        break;
+    }
+    closeConnection(user);
+    scheduleNext(user);
+  }
+
+  void recordDeliveries(User& user, std::string_view body,
+                        Clock::time_point now) {
+    nlohmann::json messages = nlohmann::json::parse(body, nullptr, false);
+    if (!messages.is_array()) return;
+    int64_t& since = user.since[user.roomSlot];
+    int64_t latest = since;
+    uint64_t nowNanos = steadyNanos(now);
+    for (const auto& message : messages) {
+      latest = std::max(latest, message.value("timestamp", int64_t{0}));
+      std::string content = message.value("content", std::string());
+      if (content.compare(0, kMarker.size(), kMarker) != 0) continue;
+      uint64_t fields[3] = {};
+      const char* p = content.data() + kMarker.size();
+      const char* end = content.data() + content.size();
+      for (uint64_t& field : fields) {
+        p = std::from_chars(p, end, field).ptr;
+        if (p < end && *p == ':') ++p;
+      }
+      auto [sender, seq, sentNanos] = fields;
+      if (sender == user.id) continue;
+      uint64_t key = (static_cast<uint64_t>(user.roomSlot) << 32) | sender;
+      uint32_t& last = user.lastSeq[key];
+      if (seq <= last) continue;
+      last = static_cast<uint32_t>(seq);
+      if (sentNanos <= nowNanos) delivery.record(nowNanos - sentNanos);
+    }
+    // 同一毫秒内可能还有消息没写入，下次从前一毫秒开始取，靠序号去重
+    since = std::max(since, latest - 1);
+  }
+
+  void scheduleNext(User& user) {
+    Clock::time_point when = Clock::now();
+    if (options_.thinkTime.count() > 0) {
+      std::exponential_distribution<double> think(
+          1.0 / options_.thinkTime.count());
+      when += std::chrono::microseconds(
+          static_cast<int64_t>(think(rng_) * 1000));
+    }
+    schedule(user, when, Wake::Next);
+  }
+
+  const Options& options_;
+  sockaddr_in addr_;
+  const std::vector<std::string>& rooms_;
+  std::string prefix_;
+  RequestBuilder builder_;
+  std::mt19937_64 rng_;
+  std::discrete_distribution<int> mix_;
+
+  reactor::EventLoop loop_;
+  int timerFd_ = -1;
+  std::vector<User> users_;
+  std::priority_queue<TimerEntry, std::vector<TimerEntry>,
+                      std::greater<TimerEntry>>
+      timers_;
+  std::vector<size_t> ready_;
+  std::vector<std::shared_ptr<reactor::Channel>> retired_;
+};
+
+std::string millis(uint64_t nanos) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.2f", nanos / 1e6);
+  return buf;
+}
+
+void appendQuantiles(utils::JsonWriter& writer,
+                     const utils::Histogram::Snapshot& snapshot) {
+  writer.key("p50_us")
+      .value(snapshot.quantile(0.5) / 1000)
+      .key("p90_us")
+      .value(snapshot.quantile(0.9) / 1000)
+      .key("p99_us")
+      .value(snapshot.quantile(0.99) / 1000)
+      .key("max_us")
+      .value(snapshot.quantile(1.0) / 1000);
+}
+
+}  // namespace
+
+const char* routeName(Route route) {
+  switch (route) {
+    case Route::Register:
+      return "POST /register";
+    case Route::Login:
+      return "POST /login";
+    case Route::JoinRoom:
+      return "POST /join_room";
+    case Route::SendMessage:
+      return "POST /send_message";
+    case Route::PollMessages:
+      return "POST /messages";
+    case Route::Rooms:
+      return "GET /rooms";
+    case Route::Users:
+      return "GET /users";
+  }
+  return "unknown";
+}
+
+const RouteStats* Report::route(Route route) const {
+  for (const RouteStats& stats : routes) {
+    if (stats.route == route) return &stats;
+  }
+  return nullptr;
+}
+
+std::string Report::toText() const {
+  std::string out;
+  char line[160];
+  std::snprintf(line, sizeof(line),
+                "%llu requests in %.1f s, %.1f req/s, %llu errors\n",
+                static_cast<unsigned long long>(requests), seconds,
+                throughput(), static_cast<unsigned long long>(errors));
+  out += line;
+  std::snprintf(line, sizeof(line), "%-20s %9s %7s %9s %9s %9s %9s\n",
+                "route", "requests", "errors", "p50 ms", "p90 ms", "p99 ms",
+                "max ms");
+  out += line;
+  auto appendRow = [&](const char* name, uint64_t count, uint64_t failed,
+                       const utils::Histogram::Snapshot& latency) {
+    std::snprintf(line, sizeof(line), "%-20s %9llu %7llu %9s %9s %9s %9s\n",
+                  name, static_cast<unsigned long long>(count),
+                  static_cast<unsigned long long>(failed),
+                  millis(latency.quantile(0.5)).c_str(),
+                  millis(latency.quantile(0.9)).c_str(),
+                  millis(latency.quantile(0.99)).c_str(),
+                  millis(latency.quantile(1.0)).c_str());
+    out += line;
+  };
+  for (const RouteStats& stats : routes) {
+    appendRow(routeName(stats.route), stats.requests, stats.errors,
+              stats.latency);
+  }
+  appendRow("all", requests, errors, latency);
+  std::snprintf(line, sizeof(line),
+                "message delivery: %llu, p50 %s ms, p90 %s ms, p99 %s ms\n",
+                static_cast<unsigned long long>(delivery.count),
+                millis(delivery.quantile(0.5)).c_str(),
+                millis(delivery.quantile(0.9)).c_str(),
+                millis(delivery.quantile(0.99)).c_str());
+  out += line;
+  return out;
+}
+
+std::string Report::toJson() const {
+  std::string out;
+  utils::JsonWriter writer(out);
+  char number[32];
+  writer.beginObject().key("seconds");
+  std::snprintf(number, sizeof(number), "%.3f", seconds);
+  writer.raw(number).key("requests").value(requests).key("errors").value(
+      errors);
+  std::snprintf(number, sizeof(number), "%.1f", throughput());
+  writer.key("throughput").raw(number).key("latency").beginObject();
+  appendQuantiles(writer, latency);
+  writer.endObject().key("routes").beginArray();
+  for (const RouteStats& stats : routes) {
+    writer.beginObject()
+        .key("route")
+        .value(routeName(stats.route))
+        .key("requests")
+        .value(stats.requests)
+        .key("errors")
+        .value(stats.errors);
+    appendQuantiles(writer, stats.latency);
+    writer.endObject();
+  }
+  writer.endArray().key("delivery").beginObject().key("count").value(
+      delivery.count);
+  appendQuantiles(writer, delivery);
+  writer.endObject().endObject();
+  return out;
+}
+
+Report run(const Options& options) {
+  sockaddr_in addr = resolve(options.host, options.port);
+  std::string prefix = options.prefix;
+  if (prefix.empty()) {
+    prefix = "lg" + std::to_string(getpid()) + "_" +
+             std::to_string(nowMs() % 100000000) + "_";
+  }
+
+  // 房间由一个单独的用户预先创建，普通用户只加入
+  RequestBuilder builder(options);
+  std::string ownerName = prefix + "owner";
+  std::string buffer;
+  blockingRequest(
+      addr, builder.build("POST", "/register", "", credentials(ownerName)),
+      buffer);
+  Response login = blockingRequest(
+      addr, builder.build("POST", "/login", "", credentials(ownerName)),
+      buffer);
+  utils::JsonReader reader(login.body);
+  std::optional<std::string_view> token = reader.getString("token");
+  if (isError(login) || !token) {
+    throw std::runtime_error("Owner login failed: " + std::string(login.body));
+  }
+  std::string ownerToken(*token);
+  std::vector<std::string> rooms;
+  for (size_t r = 0; r < options.rooms; ++r) {
+    rooms.push_back(prefix + "room" + std::to_string(r));
+    std::string body;
+    utils::JsonWriter(body)
+        .beginObject()
+        .key("name")
+        .value(rooms.back())
+        .key("creator")
+        .value(ownerName)
+        .endObject();
+    Response created = blockingRequest(
+        addr, builder.build("POST", "/create_room", ownerToken, body), buffer);
+    if (isError(created)) {
+      throw std::runtime_error("Failed to create room: " +
+                               std::string(created.body));
+    }
+  }
+
+  size_t threads =
+      std::max<size_t>(1, std::min(options.threads, options.users));
+  std::vector<std::unique_ptr<Driver>> drivers;
+  for (size_t t = 0; t < threads; ++t) {
+    drivers.push_back(std::make_unique<Driver>(options, addr, rooms, prefix,
+                                               options.seed + t));
+  }
+  for (size_t u = 0; u < options.users; ++u) {
+    drivers[u % threads]->addUser(u);
+  }
+
+  Clock::time_point start = Clock::now();
+  std::vector<std::thread> workers;
+  for (auto& driver : drivers) {
+    workers.emplace_back([&driver]() { driver->run(); });
+  }
+  std::this_thread::sleep_for(options.duration);
+  Report report;
+  report.seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  for (auto& driver : drivers) driver->stop();
+  for (auto& worker : workers) worker.join();
+
+  LatencyRecorder all;
+  LatencyRecorder delivery;
+  for (size_t r = 0; r < kRouteCount; ++r) {
+    RouteStats stats;
+    stats.route = static_cast<Route>(r);
+    LatencyRecorder latency;
+    for (auto& driver : drivers) {
+      stats.requests += driver->requests[r];
+      stats.errors += driver->errors[r];
+      latency.merge(driver->latency[r]);
+    }
+    if (stats.requests == 0) continue;
+    all.merge(latency);
+    stats.latency = latency.snapshot();
+    report.requests += stats.requests;
+    report.errors += stats.errors;
+    report.routes.push_back(std::move(stats));
+  }
+  for (auto& driver : drivers) delivery.merge(driver->delivery);
+  report.latency = all.snapshot();
+  report.delivery = delivery.snapshot();
+  return report;
+}
+
+}  // namespace loadgen
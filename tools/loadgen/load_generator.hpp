@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "utils/metrics.hpp"
+
+namespace loadgen {
+
+// 稳定阶段各操作的相对权重
+struct Mix {
+  double send = 20;   // POST /send_message
+  double poll = 60;   // POST /messages
+  double rooms = 10;  // GET /rooms
+  double users = 10;  // GET /users
+};
+
+struct Options {
+  std::string host = "127.0.0.1";
+  int port = 8080;
+  size_t users = 100;
+  size_t rooms = 10;
+  size_t roomsPerUser = 2;
+  size_t threads = 1;  // 事件循环线程数，用户平均分到各线程
+  std::chrono::milliseconds duration{10000};
+  // 两次请求之间的平均思考时间（指数分布），0 表示收到响应立即发下一个
+  std::chrono::milliseconds thinkTime{100};
+  std::chrono::milliseconds requestTimeout{5000};
+  Mix mix;
+  // 用户名和房间名的前缀，为空时按进程号和时间生成，
+  // 同一个数据库上可以重复运行
+  std::string prefix;
+  uint64_t seed = 1;
+};
+
+enum class Route {
+  Register,
+  Login,
+  JoinRoom,
+  SendMessage,
+  PollMessages,
+  Rooms,
+  Users,
+};
+constexpr size_t kRouteCount = 7;
+const char* routeName(Route route);
+
+struct RouteStats {
+  Route route;
+  uint64_t requests = 0;
+  // 连接失败、超时、非 200 状态码或响应体中带 "error"
+  uint64_t errors = 0;
+  utils::Histogram::Snapshot latency;
+};
+
+struct Report {
+  double seconds = 0;
+  uint64_t requests = 0;
+  uint64_t errors = 0;
+  std::vector<RouteStats> routes;  // 只含有请求的路由
+  utils::Histogram::Snapshot latency;  // 所有路由合计
+  // 端到端投递延迟：发送请求发出到其他成员轮询到这条消息，
+  // 每个接收者各记一次
+  utils::Histogram::Snapshot delivery;
+
+  double throughput() const { return seconds > 0 ? requests / seconds : 0; }
+  const RouteStats* route(Route route) const;
+  std::string toText() const;
+  std::string toJson() const;
+};
+
+/**
+ * @brief 聊天负载生成器
+ * 模拟 options.users 个用户：注册、登录、加入 roomsPerUser 个房间，然后按
+ * mix 的比例发消息、轮询消息、拉取房间和用户列表，每次请求之间停顿一段
+ * 思考时间。每个用户同时只有一个请求在途（闭环），每个请求一个新连接，
+ * 与服务器的 Connection: close 一致。
+ * 运行在项目自己的 reactor 上，每个线程一个 EventLoop。
+ * 房间由一个额外的用户在开始前创建。服务器不可达时抛出 std::runtime_error。
+ */
+Report run(const Options& options);
+
+}  // namespace loadgen
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "load_generator.hpp"
+
+namespace {
+
+void usage() {
+  std::cerr
+      << "Usage: chat_loadgen [--host=127.0.0.1] [--port=8080] [--users=100]\n"
+         "                    [--rooms=10] [--rooms-per-user=2] "
+         "[--threads=1]\n"
+         "                    [--duration=10] [--think-ms=100] "
+         "[--timeout-ms=5000]\n"
+         "                    [--mix=send:poll:rooms:users] [--prefix=]\n"
+         "                    [--seed=1] [--json=report.json]\n"
+         "  --duration   seconds to run\n"
+         "  --think-ms   mean pause between a user's requests, 0 for none\n"
+         "  --mix        relative weights, default 20:60:10:10\n"
+         "  --prefix     user and room name prefix, default unique per run\n"
+         "  --json       also write the report as JSON to this file\n";
+}
+
+bool parseMix(std::string_view text, loadgen::Mix& mix) {
+  double* weights[] = {&mix.send, &mix.poll, &mix.rooms, &mix.users};
+  for (double* weight : weights) {
+    if (text.empty()) return false;
+    size_t end = text.find(':');
+    *weight = std::strtod(std::string(text.substr(0, end)).c_str(), nullptr);
+    text = end == std::string_view::npos ? std::string_view()
+                                         : text.substr(end + 1);
+  }
+  return text.empty();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  loadgen::Options options;
+  std::string jsonPath;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    size_t eq = arg.find('=');
+    if (arg.substr(0, 2) != "--" || eq == std::string_view::npos) {
+      usage();
+      return 2;
+    }
+    std::string_view name = arg.substr(2, eq - 2);
+    std::string value(arg.substr(eq + 1));
+    if (name == "host") {
+      options.host = value;
+    } else if (name == "port") {
+      options.port = std::stoi(value);
+    } else if (name == "users") {
+      options.users = std::stoul(value);
+    } else if (name == "rooms") {
+      options.rooms = std::stoul(value);
+    } else if (name == "rooms-per-user") {
+      options.roomsPerUser = std::stoul(value);
+    } else if (name == "threads") {
+      options.threads = std::stoul(value);
+    } else if (name == "duration") {
+      options.duration = std::chrono::milliseconds(
+          static_cast<int64_t>(std::stod(value) * 1000));
+    } else if (name == "think-ms") {
+      options.thinkTime = std::chrono::milliseconds(std::stoi(value));
+    } else if (name == "timeout-ms") {
+      options.requestTimeout = std::chrono::milliseconds(std::stoi(value));
+    } else if (name == "mix") {
+      if (!parseMix(value, options.mix)) {
+        usage();
+        return 2;
+      }
+    } else if (name == "prefix") {
+      options.prefix = value;
+    } else if (name == "seed") {
+      options.seed = std::stoull(value);
+    } else if (name == "json") {
+      jsonPath = value;
+    } else {
+      usage();
+      return 2;
+    }
+  }
+
+  try {
+    loadgen::Report report = loadgen::run(options);
+    std::cout << report.toText();
+    if (!jsonPath.empty()) {
+      std::ofstream(jsonPath) << report.toJson() << "\n";
+    }
+  } catch (const std::exception& e) {
+    std::cerr << "chat_loadgen: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}